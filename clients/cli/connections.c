@@ -234,10 +234,12 @@ NmcOutputField nmc_fields_con_active_details_general[] = {
 	{"CON-PATH",      N_("CON-PATH")},     /* 10 */
 	{"ZONE",          N_("ZONE")},         /* 11 */
 	{"MASTER-PATH",   N_("MASTER-PATH")},  /* 12 */
+	{"TIMINGS",       N_("TIMINGS")},      /* 13 */
 	{NULL, NULL}
 };
 #define NMC_FIELDS_CON_ACTIVE_DETAILS_GENERAL_ALL  "GROUP,NAME,UUID,DEVICES,STATE,DEFAULT,DEFAULT6,"\
-                                                   "VPN,ZONE,DBUS-PATH,CON-PATH,SPEC-OBJECT,MASTER-PATH"
+                                                   "VPN,ZONE,DBUS-PATH,CON-PATH,SPEC-OBJECT,MASTER-PATH,"\
+                                                   "TIMINGS"
 
 /* IP group is handled by common.c */
 
@@ -793,7 +795,7 @@ nmc_connection_profile_details (NMConnection *connection, NmCli *nmc, gboolean s
 		int section_idx = g_array_index (print_settings_array, int, i);
 		const char *prop_name = (const char *) g_ptr_array_index (prop_array, i);
 
-		if (nmc->print_output != NMC_PRINT_TERSE && !nmc->multiline_output && was_output)
+		if (nmc->print_output != NMC_PRINT_TERSE && nmc->print_output != NMC_PRINT_JSON && !nmc->multiline_output && was_output)
 			g_print ("\n"); /* Empty line */
 
 		was_output = FALSE;
@@ -970,7 +972,7 @@ fill_output_connection (NMConnection *connection, NmCli *nmc, gboolean active_on
 	set_val_strc (arr, 12, ac_path);
 	set_val_strc (arr, 13, nm_setting_connection_get_slave_type (s_con));
 
-	g_ptr_array_add (nmc->output_data, arr);
+	nmc_output_add_row (nmc, arr);
 }
 
 static void
@@ -1007,7 +1009,7 @@ fill_output_connection_for_invisible (NMActiveConnection *ac, NmCli *nmc)
 
 	set_val_color_fmt_all (arr, NMC_TERM_FORMAT_DIM);
 
-	g_ptr_array_add (nmc->output_data, arr);
+	nmc_output_add_row (nmc, arr);
 }
 
 static void
@@ -1023,6 +1025,8 @@ fill_output_active_connection (NMActiveConnection *active,
 	NMActiveConnectionState state;
 	NMDevice *master;
 	const char *con_path = NULL, *con_zone = NULL;
+	GVariant *timings;
+	GString *timings_str;
 	int i;
 	NmcOutputField *tmpl, *arr;
 	size_t tmpl_len;
@@ -1054,6 +1058,21 @@ fill_output_active_connection (NMActiveConnection *active,
 	if (dev_str->len > 0)
 		g_string_truncate (dev_str, dev_str->len - 1);  /* Cut off last ',' */
 
+	/* Milestones of the activation, in microseconds since it started */
+	timings_str = g_string_new (NULL);
+	timings = nm_active_connection_get_timings (active);
+	if (timings) {
+		GVariantIter iter;
+		const char *name;
+		guint64 usec;
+
+		g_variant_iter_init (&iter, timings);
+		while (g_variant_iter_next (&iter, "{&st}", &name, &usec)) {
+			g_string_append_printf (timings_str, "%s%s=%" G_GUINT64_FORMAT "us",
+			                        timings_str->len ? "," : "", name, usec);
+		}
+	}
+
 	tmpl = nmc_fields_con_active_details_general;
 	tmpl_len = sizeof (nmc_fields_con_active_details_general);
 	if (!with_group) {
@@ -1077,11 +1096,12 @@ fill_output_active_connection (NMActiveConnection *active,
 	set_val_strc (arr, 10-idx_start, con_path);
 	set_val_strc (arr, 11-idx_start, con_zone);
 	set_val_strc (arr, 12-idx_start, master ? nm_object_get_path (NM_OBJECT (master)) : NULL);
-	set_val_strc (arr, 13-idx_start, s_con ? nm_setting_connection_get_slave_type (s_con) : NULL);
+	set_val_str  (arr, 13-idx_start, timings_str->str);
 
 	g_ptr_array_add (nmc->output_data, arr);
 
 	g_string_free (dev_str, FALSE);
+	g_string_free (timings_str, FALSE);
 }
 
 typedef struct {
@@ -1219,7 +1239,7 @@ nmc_active_connection_details (NMActiveConnection *acon, NmCli *nmc)
 		int group_idx = g_array_index (print_groups, int, i);
 		char *group_fld = (char *) g_ptr_array_index (group_fields, i);
 
-		if (nmc->print_output != NMC_PRINT_TERSE && !nmc->multiline_output && was_output)
+		if (nmc->print_output != NMC_PRINT_TERSE && nmc->print_output != NMC_PRINT_JSON && !nmc->multiline_output && was_output)
 			g_print ("\n"); /* Empty line */
 
 		was_output = FALSE;
@@ -1808,7 +1828,7 @@ do_connections_show (NmCli *nmc, int argc, char **argv)
 		nmc->print_fields.header_name = active_only ? _("NetworkManager active profiles") :
 		                                              _("NetworkManager connection profiles");
 		arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-		g_ptr_array_add (nmc->output_data, arr);
+		nmc_output_add_row (nmc, arr);
 
 		/* There might be active connections not present in connection list
 		 * (e.g. private connections of a different user). Show them as well. */
@@ -2116,6 +2136,7 @@ typedef struct {
 	NmCli *nmc;
 	NMDevice *device;
 	NMActiveConnection *active;
+	guint timeout_id;
 } ActivateConnectionInfo;
 
 static void activate_connection_info_finish (ActivateConnectionInfo *info);
@@ -2256,6 +2277,7 @@ activate_connection_timeout_cb (gpointer user_data)
 	ActivateConnectionInfo *info = user_data;
 
 	/* Time expired -> exit nmcli */
+	info->timeout_id = 0;
 	set_nmc_error_timeout (info->nmc);
 	activate_connection_info_finish (info);
 	return FALSE;
@@ -2303,6 +2325,8 @@ progress_active_connection_cb (gpointer user_data)
 static void
 activate_connection_info_finish (ActivateConnectionInfo *info)
 {
+	nm_clear_g_source (&info->timeout_id);
+
 	if (info->device) {
 		g_signal_handlers_disconnect_by_func (info->device, G_CALLBACK (device_state_cb), info);
 		g_object_unref (info->device);
@@ -2376,7 +2400,7 @@ activate_connection_cb (GObject *client, GAsyncResult *result, gpointer user_dat
 			}
 
 			/* Start timer not to loop forever when signals are not emitted */
-			g_timeout_add_seconds (nmc->timeout, activate_connection_timeout_cb, info);
+			info->timeout_id = g_timeout_add_seconds (nmc->timeout, activate_connection_timeout_cb, info);
 		}
 	}
 }
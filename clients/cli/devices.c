@@ -287,6 +287,7 @@ NmcOutputField nmc_fields_dev_lldp_list[] = {
 extern GMainLoop *loop;
 
 static guint progress_id = 0;  /* ID of event source for displaying progress */
+static guint timeout_id = 0;   /* ID of event source for the operation timeout */
 
 static void
 usage (void)
@@ -494,8 +495,10 @@ quit (void)
 {
 	if (progress_id) {
 		g_source_remove (progress_id);
+		progress_id = 0;
 		nmc_terminal_erase_line ();
 	}
+	nm_clear_g_source (&timeout_id);
 
 	g_main_loop_quit (loop);  /* quit main loop */
 }
@@ -876,7 +879,7 @@ fill_output_access_point (gpointer data, gpointer user_data)
 	if (active)
 		arr[15].color = NMC_TERM_COLOR_GREEN;
 
-	g_ptr_array_add (info->nmc->output_data, arr);
+	nmc_output_add_row (info->nmc, arr);
 
 	g_string_free (security_str, FALSE);
 }
@@ -1112,7 +1115,7 @@ show_device_info (NMDevice *device, NmCli *nmc)
 		int section_idx = g_array_index (sections_array, int, k);
 		char *section_fld = (char *) g_ptr_array_index (fields_in_section, k);
 
-		if (nmc->print_output != NMC_PRINT_TERSE && !nmc->multiline_output && was_output)
+		if (nmc->print_output != NMC_PRINT_TERSE && nmc->print_output != NMC_PRINT_JSON && !nmc->multiline_output && was_output)
 			g_print ("\n"); /* Print empty line between groups in tabular mode */
 
 		was_output = FALSE;
@@ -1475,7 +1478,7 @@ fill_output_device_status (NMDevice *device, NmCli *nmc)
 	set_val_strc (arr, 5, ac ? nm_active_connection_get_uuid (ac) : NULL);
 	set_val_strc (arr, 6, ac ? nm_object_get_path (NM_OBJECT (ac)) : NULL);
 
-	g_ptr_array_add (nmc->output_data, arr);
+	nmc_output_add_row (nmc, arr);
 }
 
 static NMCResultCode
@@ -1520,7 +1523,7 @@ do_devices_status (NmCli *nmc, int argc, char **argv)
 	/* Add headers */
 	nmc->print_fields.header_name = _("Status of devices");
 	arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-	g_ptr_array_add (nmc->output_data, arr);
+	nmc_output_add_row (nmc, arr);
 
 	devices = nmc_get_devices_sorted (nmc->client);
 	for (i = 0; devices[i]; i++)
@@ -1589,6 +1592,7 @@ timeout_cb (gpointer user_data)
 
 	NmCli *nmc = (NmCli *) user_data;
 
+	timeout_id = 0;
 	g_string_printf (nmc->return_text, _("Error: Timeout %d sec expired."), nmc->timeout);
 	nmc->return_value = NMC_RESULT_ERROR_TIMEOUT_EXPIRED;
 	quit ();
@@ -1605,27 +1609,72 @@ progress_cb (gpointer user_data)
 	return TRUE;
 }
 
-static void connected_state_cb (NMDevice *device, NMActiveConnection *active);
+typedef struct {
+	NmCli *nmc;
+	NMDevice *device;
+	NMActiveConnection *active;
+} WaitActivationInfo;
+
+static void connected_state_cb (WaitActivationInfo *info);
 
 static void
 device_state_cb (NMDevice *device, GParamSpec *pspec, gpointer user_data)
 {
-	NMActiveConnection *active = (NMActiveConnection *) user_data;
-
-	connected_state_cb (device, active);
+	connected_state_cb ((WaitActivationInfo *) user_data);
 }
 
 static void
 active_state_cb (NMActiveConnection *active, GParamSpec *pspec, gpointer user_data)
 {
-	NMDevice *device = (NMDevice *) user_data;
+	connected_state_cb ((WaitActivationInfo *) user_data);
+}
 
-	connected_state_cb (device, active);
+static void
+wait_activation_info_free (WaitActivationInfo *info)
+{
+	g_signal_handlers_disconnect_by_func (info->active, G_CALLBACK (active_state_cb), info);
+	g_signal_handlers_disconnect_by_func (info->device, G_CALLBACK (device_state_cb), info);
+
+	g_object_unref (info->active);
+	g_object_unref (info->device);
+	g_free (info);
+}
+
+static gboolean
+wait_activation_timeout_cb (gpointer user_data)
+{
+	WaitActivationInfo *info = user_data;
+	NmCli *nmc = info->nmc;
+
+	/* Stop watching, so that a late state change cannot quit
+	 * the main loop of a later command in batch mode. */
+	wait_activation_info_free (info);
+	return timeout_cb (nmc);
 }
 
+/* Takes the reference on @active */
 static void
-connected_state_cb (NMDevice *device, NMActiveConnection *active)
+wait_activation (NmCli *nmc, NMDevice *device, NMActiveConnection *active)
 {
+	WaitActivationInfo *info;
+
+	info = g_new0 (WaitActivationInfo, 1);
+	info->nmc = nmc;
+	info->device = g_object_ref (device);
+	info->active = active;
+
+	g_signal_connect (device, "notify::state", G_CALLBACK (device_state_cb), info);
+	g_signal_connect (active, "notify::state", G_CALLBACK (active_state_cb), info);
+
+	/* Start timer not to loop forever if "notify::state" signal is not issued */
+	timeout_id = g_timeout_add_seconds (nmc->timeout, wait_activation_timeout_cb, info);
+}
+
+static void
+connected_state_cb (WaitActivationInfo *info)
+{
+	NMDevice *device = info->device;
+	NMActiveConnection *active = info->active;
 	NMDeviceState state;
 	NMDeviceStateReason reason;
 	NMActiveConnectionState ac_state;
@@ -1649,12 +1698,7 @@ connected_state_cb (NMDevice *device, NMActiveConnection *active)
 	} else
 		return;
 
-	g_signal_handlers_disconnect_by_func (active, G_CALLBACK (active_state_cb), device);
-	g_signal_handlers_disconnect_by_func (device, G_CALLBACK (device_state_cb), active);
-
-	g_object_unref (active);
-	g_object_unref (device);
-
+	wait_activation_info_free (info);
 	quit ();
 }
 
@@ -1716,14 +1760,12 @@ add_and_activate_cb (GObject *client,
 			g_object_unref (active);
 			quit ();
 		} else {
-			g_object_ref (device);
-			g_signal_connect (device, "notify::state", G_CALLBACK (device_state_cb), active);
-			g_signal_connect (active, "notify::state", G_CALLBACK (active_state_cb), device);
+			wait_activation (nmc, device, active);
 
-			g_timeout_add_seconds (nmc->timeout, timeout_cb, nmc);  /* Exit if timeout expires */
-
-			if (nmc->print_output == NMC_PRINT_PRETTY)
+			if (nmc->print_output == NMC_PRINT_PRETTY) {
+				nm_clear_g_source (&progress_id);
 				progress_id = g_timeout_add (120, progress_cb, device);
+			}
 		}
 	}
 
@@ -1810,11 +1852,7 @@ connect_device_cb (GObject *client, GAsyncResult *result, gpointer user_data)
 				                               nm_connection_get_path (NM_CONNECTION (connection)));
 			}
 
-			g_object_ref (device);
-			g_signal_connect (device, "notify::state", G_CALLBACK (device_state_cb), active);
-			g_signal_connect (active, "notify::state", G_CALLBACK (active_state_cb), device);
-			/* Start timer not to loop forever if "notify::state" signal is not issued */
-			g_timeout_add_seconds (nmc->timeout, timeout_cb, nmc);
+			wait_activation (nmc, device, active);
 		}
 	}
 	g_free (info);
@@ -2477,7 +2515,7 @@ show_access_point_info (NMDevice *device, NmCli *nmc)
 
 	arr = nmc_dup_fields_array (nmc_fields_dev_wifi_list, sizeof (nmc_fields_dev_wifi_list),
 	                            NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-	g_ptr_array_add (nmc->output_data, arr);
+	nmc_output_add_row (nmc, arr);
 
 	info = g_malloc0 (sizeof (APInfo));
 	info->nmc = nmc;
@@ -2705,7 +2743,7 @@ do_device_wifi_list (NmCli *nmc, int argc, char **argv)
 				}
 				/* Add headers (field names) */
 				arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-				g_ptr_array_add (nmc->output_data, arr);
+				nmc_output_add_row (nmc, arr);
 
 				info = g_malloc0 (sizeof (APInfo));
 				info->nmc = nmc;
@@ -2746,12 +2784,15 @@ do_device_wifi_list (NmCli *nmc, int argc, char **argv)
 				if (!NM_IS_DEVICE_WIFI (dev))
 					continue;
 
+				if (empty_line)
+					g_print ("\n"); /* Empty line between devices' APs */
+
 				/* Main header name */
 				nmc->print_fields.header_name = (char *) construct_header_name (base_hdr, nm_device_get_iface (dev));
 				nmc->print_fields.indices = parse_output_fields (fields_str, tmpl, FALSE, NULL, NULL);
 
 				arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
-				g_ptr_array_add (nmc->output_data, arr);
+				nmc_output_add_row (nmc, arr);
 
 				aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (dev));
 				for (j = 0; j < aps->len; j++) {
@@ -2774,8 +2815,6 @@ do_device_wifi_list (NmCli *nmc, int argc, char **argv)
 					}
 					g_free (bssid_up);
 				}
-				if (empty_line)
-					g_print ("\n"); /* Empty line between devices' APs */
 				print_data (nmc);  /* Print all data */
 				nmc_empty_output_fields (nmc);
 				empty_line = TRUE;
@@ -77,20 +77,31 @@ static NmcOutputField nmc_fields_nm_logging[] = {
 #define NMC_FIELDS_NM_LOGGING_ALL     "LEVEL,DOMAINS"
 #define NMC_FIELDS_NM_LOGGING_COMMON  "LEVEL,DOMAINS"
 
+/* Available fields for 'general counters' */
+static NmcOutputField nmc_fields_nm_counters[] = {
+	{"COUNTER", N_("COUNTER")},  /* 0 */
+	{"VALUE",   N_("VALUE")},    /* 1 */
+	{NULL, NULL}
+};
+#define NMC_FIELDS_NM_COUNTERS_ALL     "COUNTER,VALUE"
+#define NMC_FIELDS_NM_COUNTERS_COMMON  "COUNTER,VALUE"
+
 
 /* glib main loop variable - defined in nmcli.c */
 extern GMainLoop *loop;
 
+static guint timeout_id = 0;  /* ID of event source for the operation timeout */
 
 static void
 usage_general (void)
 {
 	g_printerr (_("Usage: nmcli general { COMMAND | help }\n\n"
-	              "COMMAND := { status | hostname | permissions | logging }\n\n"
+	              "COMMAND := { status | hostname | permissions | logging | counters }\n\n"
 	              "  status\n\n"
 	              "  hostname [<hostname>]\n\n"
 	              "  permissions\n\n"
-	              "  logging [level <log level>] [domains <log domains>]\n\n"));
+	              "  logging [level <log level>] [domains <log domains>]\n\n"
+	              "  counters\n\n"));
 }
 
 static void
@@ -135,6 +146,16 @@ usage_general_logging (void)
 	              "for the list of possible logging domains.\n\n"));
 }
 
+static void
+usage_general_counters (void)
+{
+	g_printerr (_("Usage: nmcli general counters { help }\n"
+	              "\n"
+	              "Show NetworkManager performance counters. Besides internal counters,\n"
+	              "these are the number of cached platform objects and, per device type,\n"
+	              "a histogram of how long activations took.\n\n"));
+}
+
 static void
 usage_networking (void)
 {
@@ -225,6 +246,7 @@ usage_monitor (void)
 static void
 quit (void)
 {
+	nm_clear_g_source (&timeout_id);
 	g_main_loop_quit (loop);  /* quit main loop */
 }
 
@@ -446,11 +468,19 @@ permission_result_to_string (NMClientPermissionResult perm_result)
 	}
 }
 
+static void permission_changed (NMClient *client,
+                                NMClientPermission permission,
+                                NMClientPermissionResult result,
+                                NmCli *nmc);
+
 static gboolean
 timeout_cb (gpointer user_data)
 {
 	NmCli *nmc = (NmCli *) user_data;
 
+	timeout_id = 0;
+	g_signal_handlers_disconnect_by_func (nmc->client, G_CALLBACK (permission_changed), nmc);
+	g_idle_remove_by_data (nmc);
 	g_string_printf (nmc->return_text, _("Error: Timeout %d sec expired."), nmc->timeout);
 	nmc->return_value = NMC_RESULT_ERROR_TIMEOUT_EXPIRED;
 	quit ();
@@ -502,6 +532,7 @@ print_permissions (void *user_data)
 	}
 	print_data (nmc);  /* Print all data */
 
+	g_signal_handlers_disconnect_by_func (nmc->client, G_CALLBACK (permission_changed), nmc);
 	quit ();
 	return G_SOURCE_REMOVE;
 }
@@ -550,7 +581,7 @@ show_nm_permissions (NmCli *nmc)
 
 	if (nmc->timeout == -1)
 		nmc->timeout = 10;
-	g_timeout_add_seconds (nmc->timeout, timeout_cb, nmc);
+	timeout_id = g_timeout_add_seconds (nmc->timeout, timeout_cb, nmc);
 
 	nmc->should_wait++;
 	return TRUE;
@@ -699,6 +730,65 @@ do_general_logging (NmCli *nmc, int argc, char **argv)
 	return nmc->return_value;
 }
 
+static NMCResultCode
+do_general_counters (NmCli *nmc, int argc, char **argv)
+{
+	gs_unref_variant GVariant *counters = NULL;
+	GError *error = NULL;
+	const char *fields_str;
+	const char *fields_all =    NMC_FIELDS_NM_COUNTERS_ALL;
+	const char *fields_common = NMC_FIELDS_NM_COUNTERS_COMMON;
+	NmcOutputField *tmpl, *arr;
+	size_t tmpl_len;
+	GVariantIter iter;
+	const char *name;
+	guint64 value;
+
+	if (nmc->complete)
+		return nmc->return_value;
+
+	if (!nmc->required_fields || strcasecmp (nmc->required_fields, "common") == 0)
+		fields_str = fields_common;
+	else if (!nmc->required_fields || strcasecmp (nmc->required_fields, "all") == 0)
+		fields_str = fields_all;
+	else
+		fields_str = nmc->required_fields;
+
+	tmpl = nmc_fields_nm_counters;
+	tmpl_len = sizeof (nmc_fields_nm_counters);
+	nmc->print_fields.indices = parse_output_fields (fields_str, tmpl, FALSE, NULL, &error);
+
+	if (error) {
+		g_string_printf (nmc->return_text, _("Error: 'general counters': %s"), error->message);
+		g_error_free (error);
+		return NMC_RESULT_ERROR_USER_INPUT;
+	}
+
+	counters = nm_client_get_perf_counters (nmc->client, NULL, &error);
+	if (!counters) {
+		g_string_printf (nmc->return_text, _("Error: failed to get counters: %s"),
+		                 nmc_error_get_simple_message (error));
+		g_error_free (error);
+		return NMC_RESULT_ERROR_UNKNOWN;
+	}
+
+	nmc->print_fields.header_name = _("NetworkManager performance counters");
+	arr = nmc_dup_fields_array (tmpl, tmpl_len, NMC_OF_FLAG_MAIN_HEADER_ADD | NMC_OF_FLAG_FIELD_NAMES);
+	g_ptr_array_add (nmc->output_data, arr);
+
+	g_variant_iter_init (&iter, counters);
+	while (g_variant_iter_next (&iter, "{&st}", &name, &value)) {
+		arr = nmc_dup_fields_array (tmpl, tmpl_len, 0);
+		set_val_str (arr, 0, g_strdup (name));
+		set_val_str (arr, 1, g_strdup_printf ("%" G_GUINT64_FORMAT, value));
+		g_ptr_array_add (nmc->output_data, arr);
+	}
+
+	print_data (nmc);  /* Print all data */
+
+	return nmc->return_value;
+}
+
 static void
 save_hostname_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -749,6 +839,7 @@ static const NMCCommand general_cmds[] = {
 	{ "hostname",     do_general_hostname,     usage_general_hostname,     TRUE,   TRUE },
 	{ "permissions",  do_general_permissions,  usage_general_permissions,  TRUE,   TRUE },
 	{ "logging",      do_general_logging,      usage_general_logging,      TRUE,   TRUE },
+	{ "counters",     do_general_counters,     usage_general_counters,     TRUE,   TRUE },
 	{ NULL,           do_general_status,       usage_general,              TRUE,   TRUE },
 };
 
@@ -22,6 +22,7 @@
 #include "nm-default.h"
 
 #include <stdio.h>
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -173,6 +174,7 @@ usage (void)
 	              "OPTIONS\n"
 	              "  -t[erse]                                       terse output\n"
 	              "  -p[retty]                                      pretty output\n"
+	              "  -j[son]                                        JSON output, one object per line\n"
 	              "  -m[ode] tabular|multiline                      output mode\n"
 	              "  -c[olors] auto|yes|no                          whether to use colors in output\n"
 	              "  -f[ields] <field1,field2,...>|all|common       specify fields to output\n"
@@ -181,6 +183,7 @@ usage (void)
 	              "  -a[sk]                                         ask for missing parameters\n"
 	              "  -s[how-secrets]                                allow displaying passwords\n"
 	              "  -w[ait] <seconds>                              set timeout waiting for finishing operations\n"
+	              "  -b[atch] <file>|-                              run commands read from a file or stdin, one at a time\n"
 	              "  -v[ersion]                                     show program version\n"
 	              "  -h[elp]                                        print this help\n"
 	              "\n"
@@ -230,9 +233,9 @@ process_command_line (NmCli *nmc, int argc, char **argv)
 			break;
 
 		if (argc == 1 && nmc->complete) {
-			nmc_complete_strings (opt, "--terse", "--pretty", "--mode", "--colors", "--escape",
+			nmc_complete_strings (opt, "--terse", "--pretty", "--json", "--mode", "--colors", "--escape",
 			                           "--fields", "--nocheck", "--ask", "--show-secrets",
-			                           "--get-values", "--wait", "--version", "--help", NULL);
+			                           "--get-values", "--wait", "--batch", "--version", "--help", NULL);
 		}
 
 		if (opt[1] == '-') {
@@ -255,6 +258,11 @@ process_command_line (NmCli *nmc, int argc, char **argv)
 				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
 				return FALSE;
 			}
+			else if (nmc->print_output == NMC_PRINT_JSON) {
+				g_string_printf (nmc->return_text, _("Error: Option '--terse' is mutually exclusive with '--json'."));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				return FALSE;
+			}
 			else
 				nmc->print_output = NMC_PRINT_TERSE;
 		} else if (matches (opt, "-pretty")) {
@@ -268,8 +276,26 @@ process_command_line (NmCli *nmc, int argc, char **argv)
 				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
 				return FALSE;
 			}
+			else if (nmc->print_output == NMC_PRINT_JSON) {
+				g_string_printf (nmc->return_text, _("Error: Option '--pretty' is mutually exclusive with '--json'."));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				return FALSE;
+			}
 			else
 				nmc->print_output = NMC_PRINT_PRETTY;
+		} else if (matches (opt, "-json")) {
+			if (nmc->print_output == NMC_PRINT_JSON) {
+				g_string_printf (nmc->return_text, _("Error: Option '--json' is specified the second time."));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				return FALSE;
+			}
+			else if (nmc->print_output != NMC_PRINT_NORMAL) {
+				g_string_printf (nmc->return_text, _("Error: Option '--json' is mutually exclusive with '--terse' and '--pretty'."));
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				return FALSE;
+			}
+			else
+				nmc->print_output = NMC_PRINT_JSON;
 		} else if (matches (opt, "-mode")) {
 			nmc->mode_specified = TRUE;
 			if (next_arg (&argc, &argv) != 0) {
@@ -368,6 +394,14 @@ process_command_line (NmCli *nmc, int argc, char **argv)
 				return FALSE;
 			}
 			nmc->timeout = (int) timeout;
+		} else if (matches (opt, "-batch")) {
+			if (next_arg (&argc, &argv) != 0) {
+				g_string_printf (nmc->return_text, _("Error: missing argument for '%s' option."), opt);
+				nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+				return FALSE;
+			}
+			g_free (nmc->batch_file);
+			nmc->batch_file = g_strdup (argv[0]);
 		} else if (matches (opt, "-version")) {
 			if (!nmc->complete)
 				g_print (_("nmcli tool, version %s\n"), NMCLI_VERSION);
@@ -385,12 +419,163 @@ process_command_line (NmCli *nmc, int argc, char **argv)
 		argv++;
 	}
 
+	if (nmc->batch_file) {
+		if (nmc->complete)
+			return FALSE;
+		if (argc) {
+			g_string_printf (nmc->return_text, _("Error: no command can be given together with '--batch'."));
+			nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+			return FALSE;
+		}
+		/* The commands are run by run_batch() */
+		return TRUE;
+	}
+
 	/* Now run the requested command */
 	nmc_do_cmd (nmc, nmcli_cmds, *argv, argc, argv);
 
 	return TRUE;
 }
 
+/* Output options that commands are allowed to change while they run. */
+typedef struct {
+	NMCPrintOutput print_output;
+	gboolean multiline_output;
+	gboolean mode_specified;
+	char *required_fields;
+	int timeout;
+} BatchOptions;
+
+static void
+batch_options_restore (NmCli *nmc, const BatchOptions *opts)
+{
+	nmc->print_output = opts->print_output;
+	nmc->multiline_output = opts->multiline_output;
+	nmc->mode_specified = opts->mode_specified;
+	g_free (nmc->required_fields);
+	nmc->required_fields = g_strdup (opts->required_fields);
+	nmc->timeout = opts->timeout;
+	nmc->nowait_flag = TRUE;
+}
+
+static void
+batch_print_status (guint lineno, NMCResultCode result, const char *text)
+{
+	GString *str;
+	const char *p;
+
+	str = g_string_sized_new (64);
+	g_string_append_printf (str, "BATCH:%u:%d:", lineno, (int) result);
+	for (p = text; *p; p++) {
+		if (*p == ':' || *p == '\\')
+			g_string_append_c (str, '\\');
+		if (*p == '\n')
+			g_string_append_c (str, ' ');
+		else
+			g_string_append_c (str, *p);
+	}
+	g_print ("%s\n", str->str);
+	g_string_free (str, TRUE);
+}
+
+/*
+ * run_batch:
+ * @nmc: Client instance
+ *
+ * Runs the commands from nmc->batch_file one after another, one command
+ * per line in the same syntax as on the command line (without the leading
+ * "nmcli" and global options). All commands share the NMClient instance,
+ * which is created by the first command that needs it, so that the
+ * object tree is fetched only once.
+ *
+ * After each command a status line "BATCH:<line>:<exit code>:<message>"
+ * is printed, with ':' and '\' in the message escaped like in terse
+ * output. The exit status is the one of the last failed command.
+ *
+ * Commands never overlap: each one runs the main loop until it quits,
+ * and only then the next line is read. Running independent commands
+ * concurrently would first need the per-command state that lives in
+ * NmCli and in the static variables of the command modules (return
+ * value and text, output fields, timeout and progress sources) to be
+ * kept per command.
+ */
+static void
+run_batch (NmCli *nmc)
+{
+	FILE *file;
+	char *line = NULL;
+	size_t line_len = 0;
+	guint lineno = 0;
+	BatchOptions opts;
+	GPtrArray *argvs;
+	NMCResultCode result = NMC_RESULT_SUCCESS;
+
+	if (nm_streq (nmc->batch_file, "-"))
+		file = stdin;
+	else {
+		file = fopen (nmc->batch_file, "re");
+		if (!file) {
+			int errsv = errno;
+
+			g_string_printf (nmc->return_text, _("Error: failed to open '%s': %s."),
+			                 nmc->batch_file, g_strerror (errsv));
+			nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+			return;
+		}
+	}
+
+	opts.print_output = nmc->print_output;
+	opts.multiline_output = nmc->multiline_output;
+	opts.mode_specified = nmc->mode_specified;
+	opts.required_fields = g_strdup (nmc->required_fields);
+	opts.timeout = nmc->timeout;
+
+	/* Command handlers may keep pointers into their arguments until
+	 * the end, like for arguments of the command line. */
+	argvs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+
+	while (getline (&line, &line_len, file) != -1) {
+		GError *error = NULL;
+		char **cmd_argv = NULL;
+		int cmd_argc = 0;
+
+		lineno++;
+		g_strstrip (line);
+		if (!line[0] || line[0] == '#')
+			continue;
+
+		if (!g_shell_parse_argv (line, &cmd_argc, &cmd_argv, &error)) {
+			batch_print_status (lineno, NMC_RESULT_ERROR_USER_INPUT, error->message);
+			result = NMC_RESULT_ERROR_USER_INPUT;
+			g_clear_error (&error);
+			continue;
+		}
+		g_ptr_array_add (argvs, cmd_argv);
+
+		batch_options_restore (nmc, &opts);
+		nmc->return_value = NMC_RESULT_SUCCESS;
+		g_string_assign (nmc->return_text, _("Success"));
+		nmc->should_wait = 0;
+		nmc_empty_output_fields (nmc);
+
+		nmc_do_cmd (nmc, nmcli_cmds, *cmd_argv, cmd_argc, cmd_argv);
+		g_main_loop_run (loop);
+
+		batch_print_status (lineno, nmc->return_value, nmc->return_text->str);
+		if (nmc->return_value != NMC_RESULT_SUCCESS)
+			result = nmc->return_value;
+	}
+
+	if (file != stdin)
+		fclose (file);
+	free (line);
+	g_ptr_array_unref (argvs);
+	g_free (opts.required_fields);
+
+	nmc->return_value = result;
+	g_string_assign (nmc->return_text, "");
+}
+
 static gboolean nmcli_sigint = FALSE;
 
 gboolean
@@ -553,6 +738,7 @@ nmc_init (NmCli *nmc)
 	nmc->editor_save_confirmation = TRUE;
 	nmc->editor_show_secrets = FALSE;
 	nmc->editor_prompt_color = NMC_TERM_COLOR_NORMAL;
+	nmc->batch_file = NULL;
 }
 
 static void
@@ -571,6 +757,7 @@ nmc_cleanup (NmCli *nmc)
 		g_hash_table_destroy (nmc->pwds_hash);
 
 	g_free (nmc->required_fields);
+	g_free (nmc->batch_file);
 	nmc_empty_output_fields (nmc);
 	g_ptr_array_unref (nmc->output_data);
 
@@ -602,15 +789,21 @@ main (int argc, char *argv[])
 
 	nmc_init (&nm_cli);
 	loop = g_main_loop_new (NULL, FALSE);
-	if (process_command_line (&nm_cli, argc, argv))
-		g_main_loop_run (loop);
+	if (process_command_line (&nm_cli, argc, argv)) {
+		if (nm_cli.batch_file)
+			run_batch (&nm_cli);
+		else
+			g_main_loop_run (loop);
+	}
 
 	if (nm_cli.complete) {
 		/* Remove error statuses from command completion runs. */
 		if (nm_cli.return_value < NMC_RESULT_COMPLETE_FILE)
 			nm_cli.return_value = NMC_RESULT_SUCCESS;
-	} else if (nm_cli.return_value != NMC_RESULT_SUCCESS) {
-		/* Print result descripting text */
+	} else if (   nm_cli.return_value != NMC_RESULT_SUCCESS
+	           && nm_cli.return_text->len) {
+		/* Print result descripting text. It is empty if the errors
+		 * were already reported per command by run_batch(). */
 		g_printerr ("%s\n", nm_cli.return_text->str);
 	}
 
@@ -94,7 +94,8 @@ typedef enum {
 typedef enum {
 	NMC_PRINT_TERSE = 0,
 	NMC_PRINT_NORMAL = 1,
-	NMC_PRINT_PRETTY = 2
+	NMC_PRINT_PRETTY = 2,
+	NMC_PRINT_JSON = 3,     /* One JSON object per line */
 } NMCPrintOutput;
 
 /* === Output fields === */
@@ -160,6 +161,7 @@ typedef struct _NmCli {
 	gboolean editor_save_confirmation;                /* Whether to ask for confirmation on saving connections with 'autoconnect=yes' */
 	gboolean editor_show_secrets;                     /* Whether to display secrets in the editor' */
 	NmcTermColor editor_prompt_color;                 /* Color of prompt in connection editor */
+	char *batch_file;                                 /* '--batch' option: file to read commands from, '-' for stdin */
 } NmCli;
 
 extern NmCli nm_cli;
@@ -9903,7 +9903,8 @@ setting_details (NMSetting *setting, NmCli *nmc,  const char *one_prop, gboolean
 
 	g_return_val_if_fail (NM_IS_SETTING (setting), FALSE);
 
-	if (nmc->print_output == NMC_PRINT_TERSE)
+	if (   nmc->print_output == NMC_PRINT_TERSE
+	    || nmc->print_output == NMC_PRINT_JSON)
 		type = NMC_PROPERTY_GET_PARSABLE;
 
 	while (iter->sname) {
@@ -0,0 +1,169 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2017 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "nm-test-libnm-utils.h"
+
+/*****************************************************************************/
+
+/* Runs nmcli against the test service and returns its stdout. */
+static char *
+_run_nmcli (const char *const *args, int *out_status)
+{
+	gs_unref_ptrarray GPtrArray *argv = NULL;
+	gs_free_error GError *error = NULL;
+	char *out = NULL;
+	gs_free char *err = NULL;
+	int status;
+
+	argv = g_ptr_array_new ();
+	g_ptr_array_add (argv, TEST_NMCLI);
+	for (; *args; args++)
+		g_ptr_array_add (argv, (char *) *args);
+	g_ptr_array_add (argv, NULL);
+
+	if (!g_spawn_sync (NULL, (char **) argv->pdata, NULL, 0,
+	                   NULL, NULL, &out, &err, &status, &error))
+		g_assert_no_error (error);
+
+	if (err && err[0])
+		g_test_message ("nmcli stderr: %s", err);
+
+	g_assert (WIFEXITED (status));
+	*out_status = WEXITSTATUS (status);
+	return out;
+}
+
+static NMClient *
+_setup_wired (NMTstcServiceInfo *sinfo, guint n_connections)
+{
+	NMClient *client;
+	GError *error = NULL;
+	guint i;
+
+	client = nm_client_new (NULL, &error);
+	g_assert_no_error (error);
+
+	nmtstc_service_add_wired_device (sinfo, client, "eth0", NULL, NULL);
+
+	for (i = 0; i < n_connections; i++) {
+		gs_unref_object NMConnection *connection = NULL;
+		gs_free char *id = g_strdup_printf ("con-%u", i + 1);
+
+		connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+		nmtstc_service_add_connection (sinfo, connection, TRUE, NULL);
+	}
+
+	return client;
+}
+
+/*****************************************************************************/
+
+static void
+test_batch_connection_up (void)
+{
+	NMTSTC_SERVICE_INFO_SETUP (sinfo);
+	gs_unref_object NMClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	gs_free char *batch_file = NULL;
+	gs_free char *out = NULL;
+	gs_strfreev char **lines = NULL;
+	GString *batch;
+	const guint n_cmds = 30;
+	int fd;
+	int status;
+	guint i;
+
+	client = _setup_wired (sinfo, 2);
+
+	/* Each activation completes within a fraction of the one second
+	 * timeout, but all of them together take longer than that. The
+	 * timeout of a finished command must not fire while a later one
+	 * is running. */
+	batch = g_string_new (NULL);
+	for (i = 0; i < n_cmds; i++)
+		g_string_append_printf (batch, "connection up con-%u\n", (i % 2) + 1);
+
+	fd = g_file_open_tmp ("test-nmcli-batch-XXXXXX", &batch_file, &error);
+	g_assert_no_error (error);
+	close (fd);
+	g_file_set_contents (batch_file, batch->str, batch->len, &error);
+	g_assert_no_error (error);
+	g_string_free (batch, TRUE);
+
+	{
+		const char *const args[] = { "--wait", "1", "--batch", batch_file, NULL };
+
+		out = _run_nmcli (args, &status);
+	}
+	unlink (batch_file);
+
+	lines = g_strsplit (out, "\n", -1);
+	for (i = 0; i < n_cmds; i++) {
+		gs_free char *expected = g_strdup_printf ("BATCH:%u:0:Success", i + 1);
+
+		g_assert (g_strv_contains ((const char *const *) lines, expected));
+	}
+	g_assert (!strstr (out, "Timeout"));
+	g_assert_cmpint (status, ==, 0);
+}
+
+static void
+test_json_connection_show (void)
+{
+	NMTSTC_SERVICE_INFO_SETUP (sinfo);
+	gs_unref_object NMClient *client = NULL;
+	gs_free char *out = NULL;
+	const char *const args[] = { "--json", "connection", "show", "con-1", NULL };
+	int status;
+
+	client = _setup_wired (sinfo, 1);
+
+	out = _run_nmcli (args, &status);
+	g_assert_cmpint (status, ==, 0);
+
+	/* Like terse output, JSON uses the parsable form of the values,
+	 * both for enums and for flags. */
+	g_assert (strstr (out, "\"connection.lldp\":\"default\""));
+	g_assert (strstr (out, "\"802-3-ethernet.wake-on-lan\":\"default\""));
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	g_setenv ("LIBNM_USE_SESSION_BUS", "1", TRUE);
+	g_setenv ("LC_ALL", "C", TRUE);
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	g_test_add_func ("/nmcli/batch/connection-up", test_batch_connection_up);
+	g_test_add_func ("/nmcli/json/connection-show", test_json_connection_show);
+
+	return g_test_run ();
+}
@@ -1027,6 +1027,105 @@ get_value_to_print (NmCli *nmc,
 	return out;
 }
 
+static void
+json_append_escaped (GString *str, const char *val)
+{
+	const char *p;
+
+	for (p = val; *p; p++) {
+		switch (*p) {
+		case '"':
+			g_string_append (str, "\\\"");
+			break;
+		case '\\':
+			g_string_append (str, "\\\\");
+			break;
+		case '\n':
+			g_string_append (str, "\\n");
+			break;
+		case '\t':
+			g_string_append (str, "\\t");
+			break;
+		default:
+			if ((guchar) *p < 0x20)
+				g_string_append_printf (str, "\\u%04x", (guint) (guchar) *p);
+			else
+				g_string_append_c (str, *p);
+			break;
+		}
+	}
+}
+
+static void
+json_append_string (GString *str, const char *val)
+{
+	g_string_append_c (str, '"');
+	json_append_escaped (str, val);
+	g_string_append_c (str, '"');
+}
+
+/*
+ * Print the values of 'field_values' as one JSON object per line, keyed
+ * by the untranslated field names. Unset values are null, array values
+ * are JSON arrays. Headers are not printed. The line buffer is kept
+ * around, so that printing many rows doesn't allocate per row.
+ */
+static void
+print_required_fields_json (NmCli *nmc, const NmcOutputField field_values[])
+{
+	static GString *str = NULL;
+	const NmcPrintFields fields = nmc->print_fields;
+	gboolean section_prefix = field_values[0].flags & NMC_OF_FLAG_SECTION_PREFIX;
+	gboolean first = TRUE;
+	int i;
+
+	if (field_values[0].flags & (NMC_OF_FLAG_FIELD_NAMES | NMC_OF_FLAG_MAIN_HEADER_ONLY))
+		return;
+
+	if (G_UNLIKELY (!str))
+		str = g_string_sized_new (256);
+	g_string_truncate (str, 0);
+
+	g_string_append_c (str, '{');
+	for (i = 0; i < fields.indices->len; i++) {
+		int idx = g_array_index (fields.indices, int, i);
+		const NmcOutputField *field = &field_values[idx];
+
+		if (section_prefix && idx == 0)  /* The first field is section prefix */
+			continue;
+
+		if (!first)
+			g_string_append_c (str, ',');
+		first = FALSE;
+
+		g_string_append_c (str, '"');
+		if (section_prefix && field_values[0].value) {
+			json_append_escaped (str, field_values[0].value);
+			g_string_append_c (str, '.');
+		}
+		json_append_escaped (str, field->name);
+		g_string_append (str, "\":");
+
+		if (!field->value)
+			g_string_append (str, "null");
+		else if (field->value_is_array) {
+			const char *const *p;
+
+			g_string_append_c (str, '[');
+			for (p = field->value; *p; p++) {
+				if (p != field->value)
+					g_string_append_c (str, ',');
+				json_append_string (str, *p);
+			}
+			g_string_append_c (str, ']');
+		} else
+			json_append_string (str, field->value);
+	}
+	g_string_append (str, "}\n");
+
+	g_print ("%s", str->str);
+}
+
 /*
  * Print both headers or values of 'field_values' array.
  * Entries to print and their order are specified via indices in
@@ -1058,6 +1157,10 @@ print_required_fields (NmCli *nmc, const NmcOutputField field_values[])
 	enum { ML_HEADER_WIDTH = 79 };
 	enum { ML_VALUE_INDENT = 40 };
 
+	if (nmc->print_output == NMC_PRINT_JSON) {
+		print_required_fields_json (nmc, field_values);
+		return;
+	}
 
 	/* --- Main header --- */
 	if (main_header && pretty) {
@@ -1204,6 +1307,39 @@ print_required_fields (NmCli *nmc, const NmcOutputField field_values[])
 	g_string_free (str, TRUE);
 }
 
+/*
+ * Terse, JSON and multiline output don't align columns, so the rows don't need
+ * to be known in advance and can be printed as soon as they are produced.
+ */
+gboolean
+nmc_output_can_stream (NmCli *nmc)
+{
+	return    nmc->print_output == NMC_PRINT_TERSE
+	       || nmc->print_output == NMC_PRINT_JSON
+	       || nmc->multiline_output;
+}
+
+/*
+ * Add a row to nmc->output_data, to be printed by print_data().
+ *
+ * If the output mode allows it, the row is instead printed and freed right
+ * away, so that listing many objects uses constant memory and the first
+ * rows show up without waiting for the rest. nmc->print_fields must already
+ * be set up, and the caller must not print anything else between adding
+ * the rows and calling print_data().
+ */
+void
+nmc_output_add_row (NmCli *nmc, NmcOutputField *row)
+{
+	if (nmc_output_can_stream (nmc)) {
+		print_required_fields (nmc, row);
+		fflush (stdout);
+		nmc_free_output_field_values (row);
+		g_free (row);
+	} else
+		g_ptr_array_add (nmc->output_data, row);
+}
+
 /*
  * Print nmc->output_data
  *
@@ -1230,6 +1366,10 @@ print_data (NmCli *nmc)
 		row++;
 	}
 
+	/* Column widths are only used by the aligned tabular output */
+	if (nmc_output_can_stream (nmc))
+		num_fields = 0;
+
 	/* Find out maximal string lengths */
 	for (i = 0; i < num_fields; i++) {
 		size_t max_width = 0;
@@ -100,6 +100,8 @@ char *nmc_get_allowed_fields (const NmcOutputField fields_array[], int group_idx
 NmcOutputField *nmc_dup_fields_array (NmcOutputField fields[], size_t size, guint32 flags);
 void nmc_empty_output_fields (NmCli *nmc);
 void print_required_fields (NmCli *nmc, const NmcOutputField field_values[]);
+gboolean nmc_output_can_stream (NmCli *nmc);
+void nmc_output_add_row (NmCli *nmc, NmcOutputField *row);
 void print_data (NmCli *nmc);
 
 #endif /* NMC_UTILS_H */
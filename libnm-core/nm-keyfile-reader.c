@@ -44,6 +44,7 @@ typedef struct {
 	GError *error;
 	const char *group;
 	NMSetting *setting;
+	GHashTable *group_keys;
 } KeyfileReaderInfo;
 
 
@@ -1403,6 +1404,35 @@ static KeyParser key_parsers[] = {
 	{ NULL, NULL, FALSE }
 };
 
+static GHashTable *key_parsers_by_setting = NULL;
+
+static const KeyParser *
+key_parser_lookup (const char *setting_name, const char *key)
+{
+	GHashTable *by_key;
+
+	/* The table of parsers is static, index it once by setting name and then
+	 * by key, so that looking up a property does not require walking
+	 * all parsers. */
+	if (G_UNLIKELY (key_parsers_by_setting == NULL)) {
+		const KeyParser *parser;
+
+		key_parsers_by_setting = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                                NULL, (GDestroyNotify) g_hash_table_unref);
+		for (parser = &key_parsers[0]; parser->setting_name; parser++) {
+			by_key = g_hash_table_lookup (key_parsers_by_setting, parser->setting_name);
+			if (!by_key) {
+				by_key = g_hash_table_new (g_str_hash, g_str_equal);
+				g_hash_table_insert (key_parsers_by_setting, (gpointer) parser->setting_name, by_key);
+			}
+			g_hash_table_insert (by_key, (gpointer) parser->key, (gpointer) parser);
+		}
+	}
+
+	by_key = g_hash_table_lookup (key_parsers_by_setting, setting_name);
+	return by_key ? g_hash_table_lookup (by_key, key) : NULL;
+}
+
 static void
 set_default_for_missing_key (NMSetting *setting, const char *property)
 {
@@ -1423,7 +1453,7 @@ read_one_setting_value (NMSetting *setting,
 	GType type;
 	gs_free_error GError *err = NULL;
 	gboolean check_for_key = TRUE;
-	KeyParser *parser = &key_parsers[0];
+	const KeyParser *parser;
 
 	if (info->error)
 		return;
@@ -1443,14 +1473,10 @@ read_one_setting_value (NMSetting *setting,
 
 	setting_name = nm_setting_get_name (setting);
 
-	/* Look through the list of handlers for non-standard format key values */
-	while (parser->setting_name) {
-		if (!strcmp (parser->setting_name, setting_name) && !strcmp (parser->key, key)) {
-			check_for_key = parser->check_for_key;
-			break;
-		}
-		parser++;
-	}
+	/* Look up the handler for non-standard format key values */
+	parser = key_parser_lookup (setting_name, key);
+	if (parser)
+		check_for_key = parser->check_for_key;
 
 	/* VPN properties don't have the exact key name */
 	if (NM_IS_SETTING_VPN (setting))
@@ -1465,7 +1491,10 @@ read_one_setting_value (NMSetting *setting,
 	 * like IP addresses and routes where more than one value is actually
 	 * encoded by the setting property, this won't be true.
 	 */
-	if (check_for_key && !nm_keyfile_plugin_kf_has_key (keyfile, setting_name, key, &err)) {
+	if (   check_for_key
+	    && (  info->group_keys
+	        ? !g_hash_table_contains (info->group_keys, key)
+	        : !nm_keyfile_plugin_kf_has_key (keyfile, setting_name, key, &err))) {
 		/* Key doesn't exist or an error ocurred, thus nothing to do. */
 		if (err) {
 			if (!handle_warn (info, key, NM_KEYFILE_WARN_SEVERITY_WARN,
@@ -1482,7 +1511,7 @@ read_one_setting_value (NMSetting *setting,
 	/* If there's a custom parser for this key, handle that before the generic
 	 * parsers below.
 	 */
-	if (parser->setting_name) {
+	if (parser) {
 		(*parser->parser) (info, setting, key);
 		return;
 	}
@@ -1638,9 +1667,31 @@ read_setting (KeyfileReaderInfo *info)
 	type = nm_setting_lookup_type (alias);
 	if (type) {
 		NMSetting *setting = g_object_new (type, NULL);
+		const char *setting_name = nm_setting_get_name (setting);
+		gs_strfreev char **keys = NULL;
+		gs_unref_hashtable GHashTable *group_keys = NULL;
+		gsize i, n_keys = 0;
+
+		/* Fetch the keys that are actually present in the group once, so that
+		 * the properties of the setting that are absent from the file can be
+		 * skipped with a single hash lookup. Like nm_keyfile_plugin_kf_has_key(),
+		 * prefer the group named after the setting over its alias. */
+		keys = g_key_file_get_keys (info->keyfile,
+		                            g_key_file_has_group (info->keyfile, setting_name)
+		                              ? setting_name
+		                              : info->group,
+		                            &n_keys,
+		                            NULL);
+		if (keys) {
+			group_keys = g_hash_table_new (g_str_hash, g_str_equal);
+			for (i = 0; i < n_keys; i++)
+				g_hash_table_add (group_keys, keys[i]);
+		}
 
 		info->setting = setting;
+		info->group_keys = group_keys;
 		nm_setting_enumerate_values (setting, read_one_setting_value, info);
+		info->group_keys = NULL;
 		info->setting = NULL;
 		if (!info->error)
 			return setting;
@@ -216,6 +216,13 @@ typedef enum {
  */
 #define NM_VPN_PLUGIN_CAN_PERSIST        "can-persist"
 
+/* boolean: If %TRUE the Config, Ip4Config or Ip6Config dictionary only
+ * carries the items that changed since the previous dictionary of the same
+ * kind; all other items keep their previous value. Items cannot be removed
+ * by a delta, send a full dictionary for that.
+ */
+#define NM_VPN_PLUGIN_CONFIG_DELTA       "delta"
+
 
 /*** Ip4Config ***/
 
@@ -933,6 +933,30 @@ nm_vpn_plugin_info_supports_multiple (NMVpnPluginInfo *self)
 	return _nm_utils_ascii_str_to_bool (s, FALSE);
 }
 
+/**
+ * nm_vpn_plugin_info_supports_shared_service:
+ * @self: plugin info instance
+ *
+ * A shared service is started once and hosts all connections of its
+ * service type. Each connection is a separate plugin object below
+ * %NM_VPN_DBUS_PLUGIN_PATH.
+ *
+ * Returns: %TRUE if the service supports hosting multiple connections in
+ *   one instance, otherwise %FALSE
+ *
+ * Since: 1.8
+ */
+gboolean
+nm_vpn_plugin_info_supports_shared_service (NMVpnPluginInfo *self)
+{
+	const char *s;
+
+	g_return_val_if_fail (NM_IS_VPN_PLUGIN_INFO (self), FALSE);
+
+	s = nm_vpn_plugin_info_lookup_property (self, NM_VPN_PLUGIN_INFO_KF_GROUP_CONNECTION, "supports-shared-service");
+	return _nm_utils_ascii_str_to_bool (s, FALSE);
+}
+
 
 /**
  * nm_vpn_plugin_info_get_aliases:
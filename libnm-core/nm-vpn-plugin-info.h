@@ -95,6 +95,8 @@ NM_AVAILABLE_IN_1_4
 gboolean nm_vpn_plugin_info_supports_hints     (NMVpnPluginInfo *self);
 NM_AVAILABLE_IN_1_2
 gboolean nm_vpn_plugin_info_supports_multiple  (NMVpnPluginInfo *self);
+NM_AVAILABLE_IN_1_8
+gboolean nm_vpn_plugin_info_supports_shared_service (NMVpnPluginInfo *self);
 NM_AVAILABLE_IN_1_4
 const char *const*nm_vpn_plugin_info_get_aliases (NMVpnPluginInfo *self);
 NM_AVAILABLE_IN_1_2
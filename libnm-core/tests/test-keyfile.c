@@ -583,6 +583,44 @@ test_team_conf_read_invalid (void)
 
 /*****************************************************************************/
 
+static void
+test_read_alias_group (void)
+{
+	GKeyFile *keyfile = NULL;
+	gs_unref_object NMConnection *con = NULL;
+	NMSettingConnection *s_con;
+	NMSettingWired *s_wired;
+
+	con = nmtst_create_connection_from_keyfile (
+	      "[connection]\n"
+	      "type=ethernet\n"
+	      "id=test-alias\n"
+	      "autoconnect=false\n"
+	      "[ethernet]\n"
+	      "mac-address=00:11:22:33:44:55\n"
+	      "mtu=1400\n",
+	      "/test_read_alias_group", NULL);
+
+	g_assert (con);
+	s_con = nm_connection_get_setting_connection (con);
+	g_assert (s_con);
+	g_assert_cmpstr (nm_setting_connection_get_connection_type (s_con), ==, NM_SETTING_WIRED_SETTING_NAME);
+	g_assert (!nm_setting_connection_get_autoconnect (s_con));
+
+	s_wired = nm_connection_get_setting_wired (con);
+	g_assert (s_wired);
+	g_assert_cmpstr (nm_setting_wired_get_mac_address (s_wired), ==, "00:11:22:33:44:55");
+	g_assert_cmpint (nm_setting_wired_get_mtu (s_wired), ==, 1400);
+
+	/* keys absent from the file keep their default value */
+	g_assert (!nm_setting_wired_get_cloned_mac_address (s_wired));
+	g_assert_cmpstr (nm_setting_wired_get_port (s_wired), ==, NULL);
+
+	CLEAR (&con, &keyfile);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -593,6 +631,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/keyfile/test_8021x_cert_read", test_8021x_cert_read);
 	g_test_add_func ("/core/keyfile/test_team_conf_read/valid", test_team_conf_read_valid);
 	g_test_add_func ("/core/keyfile/test_team_conf_read/invalid", test_team_conf_read_invalid);
+	g_test_add_func ("/core/keyfile/test_read_alias_group", test_read_alias_group);
 
 	return g_test_run ();
 }
@@ -60,6 +60,7 @@ typedef struct {
 	gboolean is_vpn;
 	NMDevice *master;
 	NMActiveConnectionStateReason reason;
+	GVariant *timings;
 } NMActiveConnectionPrivate;
 
 enum {
@@ -79,6 +80,7 @@ enum {
 	PROP_DHCP6_CONFIG,
 	PROP_VPN,
 	PROP_MASTER,
+	PROP_TIMINGS,
 
 	LAST_PROP
 };
@@ -371,6 +373,27 @@ nm_active_connection_get_master (NMActiveConnection *connection)
 	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->master;
 }
 
+/**
+ * nm_active_connection_get_timings:
+ * @connection: a #NMActiveConnection
+ *
+ * Gets the activation milestones the connection reached so far, as
+ * a dictionary of type "a{st}" that maps the name of a milestone to
+ * the microseconds since the activation started.
+ *
+ * Returns: (transfer none): the timings of the #NMActiveConnection, or
+ *   %NULL if unknown.
+ *
+ * Since: 1.8
+ **/
+GVariant *
+nm_active_connection_get_timings (NMActiveConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
+
+	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->timings;
+}
+
 static void
 nm_active_connection_init (NMActiveConnection *connection)
 {
@@ -440,6 +463,8 @@ finalize (GObject *object)
 	g_free (priv->uuid);
 	g_free (priv->type);
 	g_free (priv->specific_object_path);
+	if (priv->timings)
+		g_variant_unref (priv->timings);
 
 	G_OBJECT_CLASS (nm_active_connection_parent_class)->finalize (object);
 }
@@ -498,6 +523,9 @@ get_property (GObject *object,
 	case PROP_MASTER:
 		g_value_set_object (value, nm_active_connection_get_master (self));
 		break;
+	case PROP_TIMINGS:
+		g_value_set_variant (value, nm_active_connection_get_timings (self));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -525,6 +553,22 @@ demarshal_specific_object_path (NMObject *object, GParamSpec *pspec, GVariant *v
 	return TRUE;
 }
 
+static gboolean
+demarshal_timings (NMObject *object, GParamSpec *pspec, GVariant *value, gpointer field)
+{
+	GVariant **param = (GVariant **) field;
+
+	if (!g_variant_is_of_type (value, G_VARIANT_TYPE ("a{st}")))
+		return FALSE;
+
+	if (*param)
+		g_variant_unref (*param);
+	*param = g_variant_ref_sink (value);
+
+	_nm_object_queue_notify (object, NM_ACTIVE_CONNECTION_TIMINGS);
+	return TRUE;
+}
+
 static void
 init_dbus (NMObject *object)
 {
@@ -545,6 +589,7 @@ init_dbus (NMObject *object)
 		{ NM_ACTIVE_CONNECTION_DHCP6_CONFIG,         &priv->dhcp6_config, NULL, NM_TYPE_DHCP6_CONFIG },
 		{ NM_ACTIVE_CONNECTION_VPN,                  &priv->is_vpn },
 		{ NM_ACTIVE_CONNECTION_MASTER,               &priv->master, NULL, NM_TYPE_DEVICE },
+		{ NM_ACTIVE_CONNECTION_TIMINGS,              &priv->timings, demarshal_timings },
 
 		{ NULL },
 	};
@@ -759,6 +804,22 @@ nm_active_connection_class_init (NMActiveConnectionClass *ap_class)
 		                      G_PARAM_READABLE |
 		                      G_PARAM_STATIC_STRINGS));
 
+	/**
+	 * NMActiveConnection:timings:
+	 *
+	 * The activation milestones reached so far, mapped to the
+	 * microseconds since the activation started.
+	 *
+	 * Since: 1.8
+	 **/
+	g_object_class_install_property
+		(object_class, PROP_TIMINGS,
+		 g_param_spec_variant (NM_ACTIVE_CONNECTION_TIMINGS, "", "",
+		                       G_VARIANT_TYPE ("a{st}"),
+		                       NULL,
+		                       G_PARAM_READABLE |
+		                       G_PARAM_STATIC_STRINGS));
+
 	/* signals */
 	signals[STATE_CHANGED] =
 		g_signal_new ("state-changed",
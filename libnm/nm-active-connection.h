@@ -52,6 +52,7 @@ G_BEGIN_DECLS
 #define NM_ACTIVE_CONNECTION_DHCP6_CONFIG         "dhcp6-config"
 #define NM_ACTIVE_CONNECTION_VPN                  "vpn"
 #define NM_ACTIVE_CONNECTION_MASTER               "master"
+#define NM_ACTIVE_CONNECTION_TIMINGS              "timings"
 
 /**
  * NMActiveConnection:
@@ -86,6 +87,8 @@ gboolean                       nm_active_connection_get_default6             (NM
 NMIPConfig                    *nm_active_connection_get_ip6_config           (NMActiveConnection *connection);
 NMDhcpConfig                  *nm_active_connection_get_dhcp6_config         (NMActiveConnection *connection);
 gboolean                       nm_active_connection_get_vpn                  (NMActiveConnection *connection);
+NM_AVAILABLE_IN_1_8
+GVariant                      *nm_active_connection_get_timings              (NMActiveConnection *connection);
 
 G_END_DECLS
 
@@ -492,6 +492,36 @@ nm_client_get_logging (NMClient *client, char **level, char **domains, GError **
 	                               level, domains, error);
 }
 
+/**
+ * nm_client_get_perf_counters:
+ * @client: a #NMClient
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Gets NetworkManager's performance counters. Besides the internal
+ * counters, the result contains the number of objects in the platform
+ * caches and histograms of how long activations took per device type.
+ * See the org.freedesktop.NetworkManager.PerfCounters D-Bus interface
+ * for the names of the counters.
+ *
+ * Returns: (transfer full): a #GVariant of type "a{st}" mapping the
+ *   names of the counters to their value, or %NULL on error.
+ *
+ * Since: 1.8
+ **/
+GVariant *
+nm_client_get_perf_counters (NMClient *client, GCancellable *cancellable, GError **error)
+{
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!_nm_client_check_nm_running (client, error))
+		return NULL;
+
+	return nm_manager_get_perf_counters (NM_CLIENT_GET_PRIVATE (client)->manager,
+	                                     cancellable, error);
+}
+
 /**
  * nm_client_set_logging:
  * @client: a #NMClient
@@ -258,6 +258,11 @@ gboolean nm_client_set_logging (NMClient *client,
                                 const char *domains,
                                 GError **error);
 
+NM_AVAILABLE_IN_1_8
+GVariant *nm_client_get_perf_counters (NMClient *client,
+                                       GCancellable *cancellable,
+                                       GError **error);
+
 NMClientPermissionResult nm_client_get_permission_result (NMClient *client,
                                                           NMClientPermission permission);
 
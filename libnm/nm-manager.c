@@ -519,6 +519,37 @@ nm_manager_get_logging (NMManager *manager, char **level, char **domains, GError
 	return ret;
 }
 
+GVariant *
+nm_manager_get_perf_counters (NMManager *manager, GCancellable *cancellable, GError **error)
+{
+	GDBusProxy *proxy;
+	GVariant *ret;
+	GVariant *counters;
+
+	g_return_val_if_fail (NM_IS_MANAGER (manager), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	proxy = G_DBUS_PROXY (NM_MANAGER_GET_PRIVATE (manager)->proxy);
+	ret = g_dbus_connection_call_sync (g_dbus_proxy_get_connection (proxy),
+	                                   g_dbus_proxy_get_name (proxy),
+	                                   NM_DBUS_PATH,
+	                                   NM_DBUS_INTERFACE_PERF_COUNTERS,
+	                                   "GetCounters",
+	                                   NULL,
+	                                   G_VARIANT_TYPE ("(a{st})"),
+	                                   G_DBUS_CALL_FLAGS_NONE, -1,
+	                                   cancellable, error);
+	if (!ret) {
+		if (error && *error)
+			g_dbus_error_strip_remote_error (*error);
+		return NULL;
+	}
+
+	g_variant_get (ret, "(@a{st})", &counters);
+	g_variant_unref (ret);
+	return counters;
+}
+
 gboolean
 nm_manager_set_logging (NMManager *manager, const char *level, const char *domains, GError **error)
 {
@@ -101,6 +101,10 @@ gboolean nm_manager_get_logging (NMManager *manager,
                                  char **level,
                                  char **domains,
                                  GError **error);
+GVariant *nm_manager_get_perf_counters (NMManager *manager,
+                                        GCancellable *cancellable,
+                                        GError **error);
+
 gboolean nm_manager_set_logging (NMManager *manager,
                                  const char *level,
                                  const char *domains,
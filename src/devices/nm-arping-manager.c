@@ -19,15 +19,22 @@
 #include "nm-arping-manager.h"
 
 #include <netinet/in.h>
-#include <sys/types.h>
-#include <sys/wait.h>
+#include <netinet/if_ether.h>
+#include <netpacket/packet.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "platform/nm-platform.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
+#include "nm-core-internal.h"
 
 /*****************************************************************************/
 
+/* Number of probes sent for each address (RFC 5227, PROBE_NUM). The probes
+ * are spread evenly across the timeout passed to nm_arping_manager_start_probe(). */
+#define PROBE_NUM 3
+
 typedef enum {
 	STATE_INIT,
 	STATE_PROBING,
@@ -37,12 +44,22 @@ typedef enum {
 
 typedef struct {
 	in_addr_t address;
-	GPid pid;
-	guint watch;
 	gboolean duplicate;
 	NMArpingManager *manager;
 } AddressInfo;
 
+/* A packet socket bound to one interface. It is shared by all the
+ * managers of that interface and closed when the last one releases it. */
+typedef struct {
+	int ifindex;
+	int fd;
+	guint refcount;
+	guint8 hwaddr[ETH_ALEN];
+	GIOChannel *channel;
+	guint watch_id;
+	GSList *managers;
+} ArpSocket;
+
 /*****************************************************************************/
 
 enum {
@@ -56,7 +73,11 @@ typedef struct {
 	int            ifindex;
 	State          state;
 	GHashTable    *addresses;
-	guint          completed;
+	ArpSocket     *socket;
+	guint          n_duplicates;
+	guint          probes_sent;
+	guint          probe_interval;
+	guint          probe_timeout;
 	guint          timer;
 	guint          round2_id;
 } NMArpingManagerPrivate;
@@ -94,6 +115,214 @@ G_DEFINE_TYPE (NMArpingManager, nm_arping_manager, G_TYPE_OBJECT)
 
 /*****************************************************************************/
 
+static GHashTable *arp_sockets = NULL;
+
+static void arp_socket_handle_packet (ArpSocket *sock, const struct ether_arp *arp);
+static void arp_socket_handle_failure (ArpSocket *sock);
+
+static gboolean
+arp_socket_event_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	ArpSocket *sock = user_data;
+	struct ether_arp arp;
+	struct sockaddr_ll from;
+	socklen_t from_len;
+	ssize_t n;
+
+	if (condition & (G_IO_ERR | G_IO_HUP)) {
+		int err = 0;
+		socklen_t err_len = sizeof (err);
+
+		/* Reading SO_ERROR clears a pending asynchronous error, like the
+		 * interface going down, and the socket stays usable. On hangup or
+		 * when the error can't be retrieved, give up on the socket. */
+		if (   !(condition & G_IO_HUP)
+		    && getsockopt (sock->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) == 0) {
+			nm_log_dbg (LOGD_IP4, "arping: error on packet socket for ifindex %d: %s",
+			            sock->ifindex, g_strerror (err));
+		} else {
+			nm_log_warn (LOGD_IP4, "arping: packet socket for ifindex %d failed",
+			             sock->ifindex);
+			sock->watch_id = 0;
+			arp_socket_handle_failure (sock);
+			return G_SOURCE_REMOVE;
+		}
+	}
+
+	for (;;) {
+		from_len = sizeof (from);
+		n = recvfrom (sock->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &from, &from_len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (   (size_t) n < sizeof (arp)
+		    || from.sll_pkttype == PACKET_OUTGOING)
+			continue;
+		if (   arp.arp_hrd != htons (ARPHRD_ETHER)
+		    || arp.arp_pro != htons (ETHERTYPE_IP)
+		    || arp.arp_hln != ETH_ALEN
+		    || arp.arp_pln != sizeof (in_addr_t))
+			continue;
+		if (memcmp (arp.arp_sha, sock->hwaddr, ETH_ALEN) == 0)
+			continue;
+
+		arp_socket_handle_packet (sock, &arp);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static ArpSocket *
+arp_socket_acquire (int ifindex, GError **error)
+{
+	ArpSocket *sock;
+	struct sockaddr_ll sll = { };
+	gconstpointer hwaddr;
+	size_t hwaddr_len = 0;
+	int fd;
+
+	if (G_UNLIKELY (arp_sockets == NULL))
+		arp_sockets = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	sock = g_hash_table_lookup (arp_sockets, GINT_TO_POINTER (ifindex));
+	if (sock) {
+		sock->refcount++;
+		return sock;
+	}
+
+	hwaddr = nm_platform_link_get_address (NM_PLATFORM_GET, ifindex, &hwaddr_len);
+	if (!hwaddr || hwaddr_len != ETH_ALEN) {
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "unsupported hardware address length %u for ifindex %d",
+		             (guint) hwaddr_len, ifindex);
+		return NULL;
+	}
+
+	fd = socket (PF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, htons (ETH_P_ARP));
+	if (fd < 0) {
+		int errsv = errno;
+
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't create packet socket: %s", g_strerror (errsv));
+		return NULL;
+	}
+
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons (ETH_P_ARP);
+	sll.sll_ifindex = ifindex;
+	if (bind (fd, (struct sockaddr *) &sll, sizeof (sll)) < 0) {
+		int errsv = errno;
+
+		close (fd);
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't bind packet socket to ifindex %d: %s",
+		             ifindex, g_strerror (errsv));
+		return NULL;
+	}
+
+	sock = g_slice_new0 (ArpSocket);
+	sock->ifindex = ifindex;
+	sock->fd = fd;
+	sock->refcount = 1;
+	memcpy (sock->hwaddr, hwaddr, ETH_ALEN);
+	sock->channel = g_io_channel_unix_new (fd);
+	sock->watch_id = g_io_add_watch (sock->channel, G_IO_IN | G_IO_ERR | G_IO_HUP,
+	                                 arp_socket_event_cb, sock);
+
+	g_hash_table_insert (arp_sockets, GINT_TO_POINTER (ifindex), sock);
+	return sock;
+}
+
+static void
+arp_socket_release (ArpSocket *sock)
+{
+	nm_assert (sock && sock->refcount > 0);
+
+	if (--sock->refcount > 0)
+		return;
+
+	nm_assert (!sock->managers);
+
+	/* A failed socket is no longer in the table and may have been
+	 * replaced by a new one for the same interface. */
+	if (g_hash_table_lookup (arp_sockets, GINT_TO_POINTER (sock->ifindex)) == sock)
+		g_hash_table_remove (arp_sockets, GINT_TO_POINTER (sock->ifindex));
+	nm_clear_g_source (&sock->watch_id);
+	g_io_channel_unref (sock->channel);
+	close (sock->fd);
+	g_slice_free (ArpSocket, sock);
+}
+
+static gboolean
+arp_socket_send (ArpSocket *sock,
+                 guint16 op,
+                 in_addr_t sender_ip,
+                 const guint8 *target_hw,
+                 in_addr_t target_ip,
+                 GError **error)
+{
+	struct ether_arp arp = { };
+	struct sockaddr_ll dst = { };
+
+	arp.arp_hrd = htons (ARPHRD_ETHER);
+	arp.arp_pro = htons (ETHERTYPE_IP);
+	arp.arp_hln = ETH_ALEN;
+	arp.arp_pln = sizeof (in_addr_t);
+	arp.arp_op = htons (op);
+	memcpy (arp.arp_sha, sock->hwaddr, ETH_ALEN);
+	memcpy (arp.arp_spa, &sender_ip, sizeof (in_addr_t));
+	if (target_hw)
+		memcpy (arp.arp_tha, target_hw, ETH_ALEN);
+	memcpy (arp.arp_tpa, &target_ip, sizeof (in_addr_t));
+
+	dst.sll_family = AF_PACKET;
+	dst.sll_protocol = htons (ETH_P_ARP);
+	dst.sll_ifindex = sock->ifindex;
+	dst.sll_halen = ETH_ALEN;
+	memset (dst.sll_addr, 0xff, ETH_ALEN);
+
+	if (sendto (sock->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &dst, sizeof (dst)) < 0) {
+		int errsv = errno;
+
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "%s", g_strerror (errsv));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+release_socket (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	if (priv->socket) {
+		priv->socket->managers = g_slist_remove (priv->socket->managers, self);
+		arp_socket_release (priv->socket);
+		priv->socket = NULL;
+	}
+}
+
+static gboolean
+acquire_socket (NMArpingManager *self, GError **error)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	if (!priv->socket) {
+		priv->socket = arp_socket_acquire (priv->ifindex, error);
+		if (!priv->socket)
+			return FALSE;
+		priv->socket->managers = g_slist_prepend (priv->socket->managers, self);
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
 /**
  * nm_arping_manager_add_address:
  * @self: a #NMArpingManager
@@ -127,62 +356,142 @@ nm_arping_manager_add_address (NMArpingManager *self, in_addr_t address)
 	return TRUE;
 }
 
+static gboolean
+probe_done_cb (gpointer user_data)
+{
+	NMArpingManager *self = user_data;
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	priv->timer = 0;
+
+	_LOGD ("DAD finished after %u probes, %u of %u addresses duplicate",
+	       priv->probes_sent, priv->n_duplicates,
+	       g_hash_table_size (priv->addresses));
+
+	release_socket (self);
+	priv->state = STATE_PROBE_DONE;
+	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+
+	return G_SOURCE_REMOVE;
+}
+
 static void
-arping_watch_cb (GPid pid, gint status, gpointer user_data)
+send_probes (NMArpingManager *self)
 {
-	AddressInfo *info = user_data;
-	NMArpingManager *self = info->manager;
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *addr;
-
-	info->pid = 0;
-	info->watch = 0;
-	addr = nm_utils_inet4_ntop (info->address, NULL);
-
-	if (WIFEXITED (status)) {
-		if (WEXITSTATUS (status) != 0) {
-			_LOGD ("%s already used in the %s network",
-			       addr, nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
-			info->duplicate = TRUE;
-		} else
-			_LOGD ("DAD succeeded for %s", addr);
-	} else {
-		_LOGD ("stopped unexpectedly with status %d for %s", status, addr);
-	}
+	GHashTableIter iter;
+	AddressInfo *info;
 
-	if (++priv->completed == g_hash_table_size (priv->addresses)) {
-		priv->state = STATE_PROBE_DONE;
-		nm_clear_g_source (&priv->timer);
-		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		gs_free_error GError *error = NULL;
+
+		if (info->duplicate)
+			continue;
+
+		if (!arp_socket_send (priv->socket, ARPOP_REQUEST, 0, NULL, info->address, &error)) {
+			_LOGD ("could not send probe for %s: %s",
+			       nm_utils_inet4_ntop (info->address, NULL), error->message);
+		}
 	}
+	priv->probes_sent++;
 }
 
 static gboolean
-arping_timeout_cb (gpointer user_data)
+probe_timeout_cb (gpointer user_data)
 {
 	NMArpingManager *self = user_data;
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	GHashTableIter iter;
-	AddressInfo *info;
 
 	priv->timer = 0;
 
-	g_hash_table_iter_init (&iter, priv->addresses);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		nm_clear_g_source (&info->watch);
-		if (info->pid) {
-			_LOGD ("DAD timed out for %s",
-			       nm_utils_inet4_ntop (info->address, NULL));
-			nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4,
-			                           "arping", 1000, NULL, NULL);
-			info->pid = 0;
-		}
+	if (priv->probes_sent < PROBE_NUM) {
+		send_probes (self);
+		priv->timer = g_timeout_add (  priv->probes_sent < PROBE_NUM
+		                             ? priv->probe_interval
+		                             : priv->probe_timeout - (PROBE_NUM - 1) * priv->probe_interval,
+		                             probe_timeout_cb, self);
+		return G_SOURCE_REMOVE;
 	}
 
-	priv->state = STATE_PROBE_DONE;
-	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	return probe_done_cb (self);
+}
 
-	return G_SOURCE_REMOVE;
+static void
+manager_handle_packet (NMArpingManager *self, const struct ether_arp *arp)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	AddressInfo *info;
+	in_addr_t sender_ip, target_ip;
+	char sbuf[NM_UTILS_HWADDR_LEN_MAX * 3];
+
+	if (priv->state != STATE_PROBING)
+		return;
+
+	memcpy (&sender_ip, arp->arp_spa, sizeof (in_addr_t));
+	memcpy (&target_ip, arp->arp_tpa, sizeof (in_addr_t));
+
+	/* RFC 5227, 2.1.1: any ARP packet from another host claiming the address
+	 * as sender, or another host probing for the same address, is a conflict. */
+	if (sender_ip)
+		info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (sender_ip));
+	else if (ntohs (arp->arp_op) == ARPOP_REQUEST)
+		info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (target_ip));
+	else
+		info = NULL;
+
+	if (!info || info->duplicate)
+		return;
+
+	_LOGD ("%s already used in the %s network by %s",
+	       nm_utils_inet4_ntop (info->address, NULL),
+	       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+	       nm_utils_hwaddr_ntoa_buf (arp->arp_sha, ETH_ALEN, FALSE, sbuf, sizeof (sbuf)));
+	info->duplicate = TRUE;
+
+	if (++priv->n_duplicates == g_hash_table_size (priv->addresses)) {
+		/* Nothing left to probe. Complete from an idle handler so that
+		 * PROBE_TERMINATED is not emitted while dispatching socket events. */
+		nm_clear_g_source (&priv->timer);
+		priv->timer = g_idle_add (probe_done_cb, self);
+	}
+}
+
+static void
+arp_socket_handle_packet (ArpSocket *sock, const struct ether_arp *arp)
+{
+	GSList *iter;
+
+	for (iter = sock->managers; iter; iter = iter->next)
+		manager_handle_packet (iter->data, arp);
+}
+
+static void
+manager_handle_socket_failure (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	if (priv->state != STATE_PROBING)
+		return;
+
+	/* Like a failed arping process, an aborted probe leaves the addresses
+	 * not duplicate. */
+	_LOGD ("DAD aborted after %u probes", priv->probes_sent);
+	nm_clear_g_source (&priv->timer);
+	priv->timer = g_idle_add (probe_done_cb, self);
+}
+
+static void
+arp_socket_handle_failure (ArpSocket *sock)
+{
+	GSList *iter;
+
+	/* Managers keep their reference until they are done with the socket,
+	 * but new users must get a fresh one. */
+	g_hash_table_remove (arp_sockets, GINT_TO_POINTER (sock->ifindex));
+
+	for (iter = sock->managers; iter; iter = iter->next)
+		manager_handle_socket_failure (iter->data);
 }
 
 /**
@@ -199,12 +508,7 @@ arping_timeout_cb (gpointer user_data)
 gboolean
 nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **error)
 {
-	const char *argv[] = { NULL, "-D", "-q", "-I", NULL, "-c", NULL, "-w", NULL, NULL, NULL };
 	NMArpingManagerPrivate *priv;
-	GHashTableIter iter;
-	AddressInfo *info;
-	gs_free char *timeout_str = NULL;
-	gboolean success = FALSE;
 
 	g_return_val_if_fail (NM_IS_ARPING_MANAGER (self), FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
@@ -213,54 +517,28 @@ nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **er
 	priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		             "can't find a name for ifindex %d", priv->ifindex);
-		return FALSE;
-	}
-
-	priv->completed = 0;
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
+	if (!g_hash_table_size (priv->addresses)) {
 		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "arping could not be found");
+		                     "no addresses to probe");
 		return FALSE;
 	}
 
-	timeout_str = g_strdup_printf ("%u", timeout / 1000 + 2);
-	argv[6] = timeout_str;
-	argv[8] = timeout_str;
+	if (!acquire_socket (self, error))
+		return FALSE;
 
-	g_hash_table_iter_init (&iter, priv->addresses);
+	priv->n_duplicates = 0;
+	priv->probes_sent = 0;
+	priv->probe_timeout = timeout;
+	priv->probe_interval = timeout / PROBE_NUM;
+	priv->state = STATE_PROBING;
 
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-
-		argv[9] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		if (g_spawn_async (NULL, (char **) argv, NULL,
-		                   G_SPAWN_STDOUT_TO_DEV_NULL |
-		                   G_SPAWN_STDERR_TO_DEV_NULL |
-		                   G_SPAWN_DO_NOT_REAP_CHILD,
-		                   NULL, NULL, &info->pid, NULL)) {
-			info->watch = g_child_watch_add (info->pid, arping_watch_cb, info);
-			success = TRUE;
-		}
-	}
+	_LOGD ("start probing %u addresses with timeout %u ms",
+	       g_hash_table_size (priv->addresses), timeout);
 
-	if (success) {
-		priv->timer = g_timeout_add (timeout, arping_timeout_cb, self);
-		priv->state = STATE_PROBING;
-	} else {
-		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "could not spawn arping process");
-	}
+	send_probes (self);
+	priv->timer = g_timeout_add (priv->probe_interval, probe_timeout_cb, self);
 
-	return success;
+	return TRUE;
 }
 
 /**
@@ -279,6 +557,7 @@ nm_arping_manager_reset (NMArpingManager *self)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	release_socket (self);
 	g_hash_table_remove_all (priv->addresses);
 
 	priv->state = STATE_INIT;
@@ -327,48 +606,33 @@ nm_arping_manager_check_address (NMArpingManager *self, in_addr_t address)
 }
 
 static void
-send_announcements (NMArpingManager *self, const char *mode_arg)
+send_announcements (NMArpingManager *self, guint16 op)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *argv[] = { NULL, mode_arg, "-q", "-I", NULL, "-c", "1", NULL, NULL };
-	int ip_arg = G_N_ELEMENTS (argv) - 2;
-	GError *error = NULL;
 	GHashTableIter iter;
 	AddressInfo *info;
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		_LOGW ("can't find a name for ifindex %d", priv->ifindex);
+	if (!priv->socket)
 		return;
-	}
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		_LOGW ("arping could not be found; no ARPs will be sent");
-		return;
-	}
 
 	g_hash_table_iter_init (&iter, priv->addresses);
 
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
+		gs_free_error GError *error = NULL;
 
 		if (info->duplicate)
 			continue;
 
-		argv[ip_arg] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL,
-		                         NULL, NULL, NULL, &error);
-		if (!success) {
-			_LOGW ("could not send ARP for address %s: %s", argv[ip_arg],
+		/* Gratuitous ARP: the address is both sender and target. A reply
+		 * carries our own hardware address as target, like "arping -A". */
+		_LOGD ("announce %s (%s)", nm_utils_inet4_ntop (info->address, NULL),
+		       op == ARPOP_REPLY ? "reply" : "request");
+		if (!arp_socket_send (priv->socket, op, info->address,
+		                      op == ARPOP_REPLY ? priv->socket->hwaddr : NULL,
+		                      info->address, &error)) {
+			_LOGW ("could not send ARP for address %s: %s",
+			       nm_utils_inet4_ntop (info->address, NULL),
 			       error->message);
-			g_clear_error (&error);
 		}
 	}
 }
@@ -379,7 +643,8 @@ arp_announce_round2 (gpointer self)
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE ((NMArpingManager *) self);
 
 	priv->round2_id = 0;
-	send_announcements (self, "-U");
+	send_announcements (self, ARPOP_REQUEST);
+	release_socket (self);
 	priv->state = STATE_INIT;
 	g_hash_table_remove_all (priv->addresses);
 
@@ -396,11 +661,15 @@ void
 nm_arping_manager_announce_addresses (NMArpingManager *self)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
 
 	g_return_if_fail (   priv->state == STATE_INIT
 	                  || priv->state == STATE_PROBE_DONE);
 
-	send_announcements (self, "-A");
+	if (!acquire_socket (self, &error))
+		_LOGW ("could not send ARPs: %s", error->message);
+
+	send_announcements (self, ARPOP_REPLY);
 	nm_clear_g_source (&priv->round2_id);
 	priv->round2_id = g_timeout_add_seconds (2, arp_announce_round2, self);
 	priv->state = STATE_ANNOUNCING;
@@ -411,13 +680,6 @@ destroy_address_info (gpointer data)
 {
 	AddressInfo *info = (AddressInfo *) data;
 
-	nm_clear_g_source (&info->watch);
-
-	if (info->pid) {
-		nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4, "arping",
-		                           1000, NULL, NULL);
-	}
-
 	g_slice_free (AddressInfo, info);
 }
 
@@ -453,6 +715,7 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	release_socket (self);
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_arping_manager_parent_class)->dispose (object);
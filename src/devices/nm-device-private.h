@@ -47,6 +47,8 @@ NMSettings *nm_device_get_settings (NMDevice *self);
 
 gboolean nm_device_set_ip_iface (NMDevice *self, const char *iface);
 
+void nm_device_sync_ip_config (NMDevice *self, int addr_family);
+
 void nm_device_activate_schedule_stage3_ip_config_start (NMDevice *device);
 
 gboolean nm_device_activate_stage3_ip4_start (NMDevice *self);
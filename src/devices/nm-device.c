@@ -66,6 +66,7 @@
 #include "nm-lldp-listener.h"
 #include "nm-audit-manager.h"
 #include "nm-arping-manager.h"
+#include "nm-perf-counters.h"
 
 #include "nm-device-logging.h"
 _LOG_DECLARE_SELF (NMDevice);
@@ -86,6 +87,12 @@ typedef void (*ActivationHandleFunc) (NMDevice *self);
 typedef struct {
 	ActivationHandleFunc func;
 	guint id;
+
+	/* link in the queue of the activation stage scheduler, see
+	 * activation_source_schedule(). */
+	GList lst;
+	GQueue *queue;
+	gint64 scheduled_at_us;
 } ActivationHandleData;
 
 typedef enum {
@@ -329,6 +336,7 @@ typedef struct _NMDevicePrivate {
 	NMIP4Config *   con_ip4_config; /* config from the setting */
 	NMIP4Config *   dev_ip4_config; /* Config from DHCP, PPP, LLv4, etc */
 	NMIP4Config *   ext_ip4_config; /* Stuff added outside NM */
+	guint64         ext_ip4_generation; /* platform generation of the last external sync */
 	NMIP4Config *   wwan_ip4_config; /* WWAN configuration */
 	GSList *        vpn4_configs;   /* VPNs which use this device */
 	struct {
@@ -390,6 +398,7 @@ typedef struct _NMDevicePrivate {
 	NMIP6Config *  wwan_ip6_config;
 	NMIP6Config *  ext_ip6_config; /* Stuff added outside NM */
 	NMIP6Config *  ext_ip6_config_captured; /* Configuration captured from platform. */
+	guint64        ext_ip6_generation; /* platform generation of the last external sync */
 	GSList *       vpn6_configs;   /* VPNs which use this device */
 	bool           nm_ipv6ll; /* TRUE if NM handles the device's IPv6LL address */
 	NMIP6Config *  dad6_ip6_config;
@@ -491,7 +500,8 @@ static void nm_device_set_autoconnect_both (NMDevice *self, gboolean autoconnect
 static void nm_device_set_autoconnect_full (NMDevice *self, int autoconnect_intern, int autoconnect_user);
 
 static const char *_activation_func_to_string (ActivationHandleFunc func);
-static void activation_source_handle_cb (NMDevice *self, int family);
+static guint _activation_func_to_stage (ActivationHandleFunc func);
+static const char *_activation_stage_to_string (guint stage);
 
 static void _set_state_full (NMDevice *self,
                              NMDeviceState state,
@@ -4135,86 +4145,154 @@ dnsmasq_state_changed_cb (NMDnsMasqManager *manager, guint32 status, gpointer us
 
 /*****************************************************************************/
 
-static gboolean
-activation_source_handle_cb4 (gpointer user_data)
-{
-	activation_source_handle_cb (user_data, AF_INET);
-	return G_SOURCE_REMOVE;
-}
+/* Activation stages of all devices are run by one scheduler instead of
+ * one idle source per device and stage. A dispatch runs the queued stage
+ * functions grouped by stage, in stage order, so that a bulk activation
+ * handles the same kind of work for all devices back to back. Functions
+ * that are scheduled during a dispatch run in the next one, which keeps
+ * the previous guarantee that a scheduled stage never runs synchronously.
+ *
+ * For each stage, the scheduler also keeps histograms of how long the
+ * functions waited in the queue and how long they ran. They are logged
+ * on SIGUSR2, see nm_device_activation_stage_stats_log(). */
 
-static gboolean
-activation_source_handle_cb6 (gpointer user_data)
+#define ACTIVATION_STAGE_HISTOGRAM_BUCKETS 20
+
+typedef struct {
+	GQueue queues[2];
+	guint64 n_runs;
+	guint64 wait_hist[ACTIVATION_STAGE_HISTOGRAM_BUCKETS];
+	guint64 run_hist[ACTIVATION_STAGE_HISTOGRAM_BUCKETS];
+} ActivationStageSched;
+
+enum {
+	ACTIVATION_STAGE_1_DEVICE_PREPARE,
+	ACTIVATION_STAGE_2_DEVICE_CONFIG,
+	ACTIVATION_STAGE_3_IP_CONFIG_START,
+	ACTIVATION_STAGE_4_IP4_CONFIG_TIMEOUT,
+	ACTIVATION_STAGE_4_IP6_CONFIG_TIMEOUT,
+	ACTIVATION_STAGE_5_IP4_CONFIG_COMMIT,
+	ACTIVATION_STAGE_5_IP6_CONFIG_COMMIT,
+	_ACTIVATION_STAGE_NUM,
+};
+
+static ActivationStageSched activation_sched[_ACTIVATION_STAGE_NUM];
+static guint activation_sched_queue_idx;
+static guint activation_sched_id;
+static guint activation_sched_last_id;
+
+static guint
+_histogram_bucket (gint64 usec)
 {
-	activation_source_handle_cb (user_data, AF_INET6);
-	return G_SOURCE_REMOVE;
+	guint b = 0;
+
+	/* bucket N counts durations below 2^N microseconds. */
+	while (   usec > 0
+	       && b < ACTIVATION_STAGE_HISTOGRAM_BUCKETS - 1) {
+		usec >>= 1;
+		b++;
+	}
+	return b;
 }
 
 static ActivationHandleData *
 activation_source_get_by_family (NMDevice *self,
-                                 int family,
-                                 GSourceFunc *out_idle_func)
+                                 int family)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
-	if (family == AF_INET6) {
-		NM_SET_OUT (out_idle_func, activation_source_handle_cb6);
+	if (family == AF_INET6)
 		return &priv->act_handle6;
-	} else {
-		NM_SET_OUT (out_idle_func, activation_source_handle_cb4);
+	else {
 		g_return_val_if_fail (family == AF_INET, &priv->act_handle4);
 		return &priv->act_handle4;
 	}
 }
 
+static void
+activation_source_unqueue (ActivationHandleData *act_data)
+{
+	g_queue_unlink (act_data->queue, &act_data->lst);
+	act_data->queue = NULL;
+	act_data->func = NULL;
+	act_data->id = 0;
+}
+
 static void
 activation_source_clear (NMDevice *self, int family)
 {
 	ActivationHandleData *act_data;
 
-	act_data = activation_source_get_by_family (self, family, NULL);
+	act_data = activation_source_get_by_family (self, family);
 
 	if (act_data->id) {
 		_LOGD (LOGD_DEVICE, "activation-stage: clear %s,%d (id %u)",
 		       _activation_func_to_string (act_data->func), family, act_data->id);
-		nm_clear_g_source (&act_data->id);
-		act_data->func = NULL;
+		activation_source_unqueue (act_data);
 	}
 }
 
 static void
-activation_source_handle_cb (NMDevice *self, int family)
+activation_source_handle (NMDevice *self, ActivationHandleData *act_data, int family, ActivationStageSched *sched)
 {
-	ActivationHandleData *act_data, a;
-
-	g_return_if_fail (NM_IS_DEVICE (self));
-
-	act_data = activation_source_get_by_family (self, family, NULL);
-
-	g_return_if_fail (act_data->id);
-	g_return_if_fail (act_data->func);
+	ActivationHandleData a;
+	gint64 now_us;
 
 	a = *act_data;
-
-	act_data->func = NULL;
-	act_data->id = 0;
+	activation_source_unqueue (act_data);
 
 	_LOGD (LOGD_DEVICE, "activation-stage: invoke %s,%d (id %u)",
 	       _activation_func_to_string (a.func), family, a.id);
 
+	now_us = nm_utils_get_monotonic_timestamp_us ();
+	sched->n_runs++;
+	sched->wait_hist[_histogram_bucket (now_us - a.scheduled_at_us)]++;
+
 	a.func (self);
 
+	sched->run_hist[_histogram_bucket (nm_utils_get_monotonic_timestamp_us () - now_us)]++;
+
 	_LOGD (LOGD_DEVICE, "activation-stage: complete %s,%d (id %u)",
 	       _activation_func_to_string (a.func), family, a.id);
 }
 
+static gboolean
+activation_sched_dispatch_cb (gpointer user_data)
+{
+	guint idx, i;
+
+	activation_sched_id = 0;
+
+	/* new schedules during this dispatch go to the other queue. */
+	idx = activation_sched_queue_idx;
+	activation_sched_queue_idx = !idx;
+
+	for (i = 0; i < _ACTIVATION_STAGE_NUM; i++) {
+		ActivationStageSched *sched = &activation_sched[i];
+		GList *lst;
+
+		while ((lst = g_queue_peek_head_link (&sched->queues[idx]))) {
+			NMDevice *self = lst->data;
+			ActivationHandleData *act_data = (ActivationHandleData *) (((char *) lst) - G_STRUCT_OFFSET (ActivationHandleData, lst));
+
+			activation_source_handle (self,
+			                          act_data,
+			                          act_data == &NM_DEVICE_GET_PRIVATE (self)->act_handle6 ? AF_INET6 : AF_INET,
+			                          sched);
+		}
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
 static void
 activation_source_schedule (NMDevice *self, ActivationHandleFunc func, int family)
 {
 	ActivationHandleData *act_data;
-	GSourceFunc source_func;
-	guint new_id = 0;
+	ActivationStageSched *sched;
+	guint new_id;
 
-	act_data = activation_source_get_by_family (self, family, &source_func);
+	act_data = activation_source_get_by_family (self, family);
 
 	if (act_data->id && act_data->func == func) {
 		/* Don't bother rescheduling the same function that's about to
@@ -4227,21 +4305,78 @@ activation_source_schedule (NMDevice *self, ActivationHandleFunc func, int famil
 		return;
 	}
 
-	new_id = g_idle_add (source_func, self);
+	new_id = ++activation_sched_last_id;
+	if (G_UNLIKELY (new_id == 0))
+		new_id = ++activation_sched_last_id;
 
 	if (act_data->id) {
 		_LOGW (LOGD_DEVICE, "activation-stage: schedule %s,%d which replaces %s,%d (id %u -> %u)",
 		       _activation_func_to_string (func), family,
 		       _activation_func_to_string (act_data->func), family,
 		       act_data->id, new_id);
-		nm_clear_g_source (&act_data->id);
+		activation_source_unqueue (act_data);
 	} else {
 		_LOGD (LOGD_DEVICE, "activation-stage: schedule %s,%d (id %u)",
 		       _activation_func_to_string (func), family, new_id);
 	}
 
+	sched = &activation_sched[_activation_func_to_stage (func)];
+
 	act_data->func = func;
 	act_data->id = new_id;
+	act_data->scheduled_at_us = nm_utils_get_monotonic_timestamp_us ();
+	act_data->lst.data = self;
+	act_data->queue = &sched->queues[activation_sched_queue_idx];
+	g_queue_push_tail_link (act_data->queue, &act_data->lst);
+
+	if (!activation_sched_id)
+		activation_sched_id = g_idle_add (activation_sched_dispatch_cb, NULL);
+}
+
+static void
+_histogram_to_string (GString *str, const guint64 *hist)
+{
+	guint i;
+
+	g_string_truncate (str, 0);
+	for (i = 0; i < ACTIVATION_STAGE_HISTOGRAM_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		g_string_append_printf (str, "%s%s%lluus:%llu",
+		                        str->len ? " " : "",
+		                        i == ACTIVATION_STAGE_HISTOGRAM_BUCKETS - 1 ? ">=" : "<",
+		                        (unsigned long long) (i == ACTIVATION_STAGE_HISTOGRAM_BUCKETS - 1 ? (1ULL << (i - 1)) : (1ULL << i)),
+		                        (unsigned long long) hist[i]);
+	}
+}
+
+/**
+ * nm_device_activation_stage_stats_log:
+ *
+ * Logs, for each activation stage, histograms of the time the stage
+ * functions spent queued and running.
+ */
+void
+nm_device_activation_stage_stats_log (void)
+{
+	nm_auto_free_gstring GString *wait_str = g_string_new (NULL);
+	nm_auto_free_gstring GString *run_str = g_string_new (NULL);
+	guint i;
+
+	for (i = 0; i < _ACTIVATION_STAGE_NUM; i++) {
+		const ActivationStageSched *sched = &activation_sched[i];
+
+		if (!sched->n_runs)
+			continue;
+
+		_histogram_to_string (wait_str, sched->wait_hist);
+		_histogram_to_string (run_str, sched->run_hist);
+		nm_log_info (LOGD_DEVICE, "activation-stage: %s: %llu runs; wait [%s]; run [%s]",
+		             _activation_stage_to_string (i),
+		             (unsigned long long) sched->n_runs,
+		             wait_str->str,
+		             run_str->str);
+	}
 }
 
 static gboolean
@@ -4249,10 +4384,19 @@ activation_source_is_scheduled (NMDevice *self, ActivationHandleFunc func, int f
 {
 	ActivationHandleData *act_data;
 
-	act_data = activation_source_get_by_family (self, family, NULL);
+	act_data = activation_source_get_by_family (self, family);
 	return act_data->func == func;
 }
 
+static void
+_activation_milestone (NMDevice *self, NMActivationMilestone milestone)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (priv->act_request)
+		nm_active_connection_record_milestone (NM_ACTIVE_CONNECTION (priv->act_request), milestone);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -4379,6 +4523,8 @@ activate_stage1_device_prepare (NMDevice *self)
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	NMActStageReturn ret = NM_ACT_STAGE_RETURN_SUCCESS;
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_PREPARE);
+
 	_set_ip_state (self, AF_INET, IP_NONE);
 	_set_ip_state (self, AF_INET6, IP_NONE);
 
@@ -4483,6 +4629,8 @@ activate_stage2_device_config (NMDevice *self)
 	gboolean no_firmware = FALSE;
 	GSList *iter;
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_CONFIG);
+
 	nm_device_state_changed (self, NM_DEVICE_STATE_CONFIG, NM_DEVICE_STATE_REASON_NONE);
 
 	/* Assumed connections were already set up outside NetworkManager */
@@ -4758,6 +4906,8 @@ arping_manager_probe_terminated (NMArpingManager *arping_manager, ArpingData *da
 		}
 	}
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_IP4_DAD_DONE);
+
 	data->callback (self, data->configs, success);
 
 	priv->arping.dad_list = g_slist_remove (priv->arping.dad_list, arping_manager);
@@ -5199,6 +5349,10 @@ ip4_config_merge_and_apply (NMDevice *self,
 	gboolean ignore_auto_dns = FALSE;
 	gboolean auto_method = FALSE;
 
+	/* the internal configs might have changed, the next external change
+	 * must sync them again with the platform. */
+	priv->ext_ip4_generation = 0;
+
 	/* Merge all the configs into the composite config */
 	if (config) {
 		g_clear_object (&priv->dev_ip4_config);
@@ -5484,6 +5638,8 @@ dhcp4_state_changed (NMDhcpClient *client,
 			break;
 		}
 
+		_activation_milestone (self, NM_ACTIVATION_MILESTONE_DHCP4_BOUND);
+
 		g_free (priv->dhcp4.pac_url);
 		priv->dhcp4.pac_url = g_strdup (g_hash_table_lookup (options, "wpad"));
 		nm_device_set_proxy_config (self, priv->dhcp4.pac_url);
@@ -5935,6 +6091,10 @@ ip6_config_merge_and_apply (NMDevice *self,
 	gboolean auto_method = FALSE;
 	const char *token = NULL;
 
+	/* the internal configs might have changed, the next external change
+	 * must sync them again with the platform. */
+	priv->ext_ip6_generation = 0;
+
 	/* Apply ignore-auto-routes and ignore-auto-dns settings */
 	connection = nm_device_get_applied_connection (self);
 	if (connection) {
@@ -6305,6 +6465,9 @@ dhcp6_state_changed (NMDhcpClient *client,
 
 		priv->dhcp6.num_tries_left = DHCP_NUM_TRIES_MAX;
 
+		if (priv->dhcp6.ip6_config)
+			_activation_milestone (self, NM_ACTIVATION_MILESTONE_DHCP6_BOUND);
+
 		if (priv->ip6_state == IP_CONF) {
 			if (priv->dhcp6.ip6_config == NULL) {
 				nm_device_ip_method_failed (self, AF_INET6, NM_DEVICE_STATE_REASON_DHCP_FAILED);
@@ -7620,6 +7783,8 @@ activate_stage3_ip_config_start (NMDevice *self)
 	NMActiveConnection *master;
 	NMDevice *master_device;
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_IP_CONFIG_START);
+
 	_set_ip_state (self, AF_INET, IP_WAIT);
 	_set_ip_state (self, AF_INET6, IP_WAIT);
 
@@ -8045,6 +8210,8 @@ activate_stage5_ip4_config_commit (NMDevice *self)
 	connection = nm_act_request_get_applied_connection (req);
 	g_assert (connection);
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_IP4_COMMIT);
+
 	/* Interface must be IFF_UP before IP config can be applied */
 	ip_ifindex = nm_device_get_ip_ifindex (self);
 	if (!nm_platform_link_is_up (NM_PLATFORM_GET, ip_ifindex) && !nm_device_sys_iface_state_is_external_or_assume (self)) {
@@ -8194,6 +8361,8 @@ activate_stage5_ip6_config_commit (NMDevice *self)
 	connection = nm_act_request_get_applied_connection (req);
 	g_assert (connection);
 
+	_activation_milestone (self, NM_ACTIVATION_MILESTONE_IP6_COMMIT);
+
 	/* Interface must be IFF_UP before IP config can be applied */
 	ip_ifindex = nm_device_get_ip_ifindex (self);
 	if (!nm_platform_link_is_up (NM_PLATFORM_GET, ip_ifindex) && !nm_device_sys_iface_state_is_external_or_assume (self)) {
@@ -8580,6 +8749,7 @@ nm_device_reactivate_ip4_config (NMDevice *self,
 	if (priv->ip4_state != IP_NONE) {
 		g_clear_object (&priv->con_ip4_config);
 		g_clear_object (&priv->ext_ip4_config);
+		priv->ext_ip4_generation = 0;
 		priv->con_ip4_config = nm_ip4_config_new (nm_device_get_ip_ifindex (self));
 		nm_ip4_config_merge_setting (priv->con_ip4_config,
 		                             s_ip4_new,
@@ -8622,6 +8792,7 @@ nm_device_reactivate_ip6_config (NMDevice *self,
 	if (priv->ip6_state != IP_NONE) {
 		g_clear_object (&priv->con_ip6_config);
 		g_clear_object (&priv->ext_ip6_config);
+		priv->ext_ip6_generation = 0;
 		priv->con_ip6_config = nm_ip6_config_new (nm_device_get_ip_ifindex (self));
 		nm_ip6_config_merge_setting (priv->con_ip6_config,
 		                             s_ip6_new,
@@ -9741,6 +9912,15 @@ dispatcher_cleanup (NMDevice *self)
 	}
 }
 
+static void
+dispatcher_up_done (guint call_id, gpointer user_data)
+{
+	gs_unref_object NMActiveConnection *ac = user_data;
+
+	if (ac)
+		nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_DISPATCHER_DONE);
+}
+
 static void
 dispatcher_complete_proceed_state (guint call_id, gpointer user_data)
 {
@@ -10278,6 +10458,7 @@ update_ip4_config (NMDevice *self, gboolean initial)
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	int ifindex;
 	gboolean capture_resolv_conf;
+	guint64 generation;
 
 	/* If a commit is scheduled, this function would potentially interfere with
 	 * it changing IP configurations before they are applied. Postpone the
@@ -10297,6 +10478,18 @@ update_ip4_config (NMDevice *self, gboolean initial)
 	if (!ifindex)
 		return;
 
+	/* If neither the addresses and routes of the link nor any of the internal
+	 * configs changed since the last sync, capturing again would yield the
+	 * same external config and the same composite. */
+	generation = nm_platform_cache_get_generation (NM_PLATFORM_GET, ifindex);
+	if (   !initial
+	    && generation
+	    && generation == priv->ext_ip4_generation) {
+		nm_perf_counter_inc (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED);
+		return;
+	}
+	nm_perf_counter_inc (NM_PERF_COUNTER_DEVICE_IP_SYNCS);
+
 	capture_resolv_conf =    initial
 	                      && nm_dns_manager_get_resolv_conf_explicit (nm_dns_manager_get ());
 
@@ -10342,6 +10535,7 @@ update_ip4_config (NMDevice *self, gboolean initial)
 			nm_ip4_config_subtract (priv->ext_ip4_config, priv->wwan_ip4_config);
 
 		ip4_config_merge_and_apply (self, NULL, FALSE);
+		priv->ext_ip4_generation = generation;
 	}
 }
 
@@ -10369,6 +10563,7 @@ update_ip6_config (NMDevice *self, gboolean initial)
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	int ifindex;
 	gboolean capture_resolv_conf;
+	guint64 generation;
 
 	/* If a commit is scheduled, this function would potentially interfere with
 	 * it changing IP configurations before they are applied. Postpone the
@@ -10388,6 +10583,16 @@ update_ip6_config (NMDevice *self, gboolean initial)
 	if (!ifindex)
 		return;
 
+	/* see update_ip4_config() */
+	generation = nm_platform_cache_get_generation (NM_PLATFORM_GET, ifindex);
+	if (   !initial
+	    && generation
+	    && generation == priv->ext_ip6_generation) {
+		nm_perf_counter_inc (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED);
+		goto CHECK_LINKLOCAL6;
+	}
+	nm_perf_counter_inc (NM_PERF_COUNTER_DEVICE_IP_SYNCS);
+
 	capture_resolv_conf =    initial
 	                      && nm_dns_manager_get_resolv_conf_explicit (nm_dns_manager_get ());
 
@@ -10427,8 +10632,10 @@ update_ip6_config (NMDevice *self, gboolean initial)
 		g_slist_foreach (priv->vpn6_configs, _ip6_config_subtract, priv->ext_ip6_config);
 
 		ip6_config_merge_and_apply (self, FALSE);
+		priv->ext_ip6_generation = generation;
 	}
 
+CHECK_LINKLOCAL6:
 	if (   priv->linklocal6_timeout_id
 	    && priv->ext_ip6_config_captured
 	    && nm_ip6_config_get_address_first_nontentative (priv->ext_ip6_config_captured, TRUE)) {
@@ -10446,6 +10653,21 @@ nm_device_capture_initial_config (NMDevice *self)
 	update_ip6_config (self, TRUE);
 }
 
+/* Syncs the IP configuration of @addr_family with the platform, like after
+ * an external change of the addresses or routes of the link. */
+void
+nm_device_sync_ip_config (NMDevice *self, int addr_family)
+{
+	g_return_if_fail (NM_IS_DEVICE (self));
+
+	if (addr_family == AF_INET)
+		update_ip4_config (self, FALSE);
+	else if (addr_family == AF_INET6)
+		update_ip6_config (self, FALSE);
+	else
+		g_return_if_reached ();
+}
+
 static gboolean
 queued_ip4_config_change (gpointer user_data)
 {
@@ -10531,6 +10753,7 @@ queued_ip6_config_change (gpointer user_data)
 		if (!nm_ip6_config_has_any_dad_pending (priv->ext_ip6_config_captured,
 		                                        priv->dad6_ip6_config)) {
 			_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD terminated");
+			_activation_milestone (self, NM_ACTIVATION_MILESTONE_IP6_DAD_DONE);
 			g_clear_object (&priv->dad6_ip6_config);
 			_set_ip_state (self, AF_INET6, IP_DONE);
 			check_ip_state (self, FALSE);
@@ -10839,8 +11062,8 @@ _set_unmanaged_flags (NMDevice *self,
 		if (!NM_FLAGS_HAS (flags, NM_UNMANAGED_USER_SETTINGS)) {
 			gboolean unmanaged;
 
-			unmanaged = nm_device_spec_match_list (self,
-			                                       nm_settings_get_unmanaged_specs (NM_DEVICE_GET_PRIVATE (self)->settings));
+			unmanaged = nm_device_spec_match_compiled (self,
+			                                           nm_settings_get_unmanaged_specs_compiled (NM_DEVICE_GET_PRIVATE (self)->settings));
 			nm_device_set_unmanaged_flags (self,
 			                               NM_UNMANAGED_USER_SETTINGS,
 			                               !!unmanaged);
@@ -10996,8 +11219,8 @@ nm_device_set_unmanaged_by_user_settings (NMDevice *self)
 		return;
 	}
 
-	unmanaged = nm_device_spec_match_list (self,
-	                                       nm_settings_get_unmanaged_specs (NM_DEVICE_GET_PRIVATE (self)->settings));
+	unmanaged = nm_device_spec_match_compiled (self,
+	                                           nm_settings_get_unmanaged_specs_compiled (NM_DEVICE_GET_PRIVATE (self)->settings));
 
 	nm_device_set_unmanaged_by_flags (self,
 	                                  NM_UNMANAGED_USER_SETTINGS,
@@ -11681,12 +11904,14 @@ _cleanup_generic_post (NMDevice *self, CleanupType cleanup_type)
 	g_clear_object (&priv->con_ip4_config);
 	g_clear_object (&priv->dev_ip4_config);
 	g_clear_object (&priv->ext_ip4_config);
+	priv->ext_ip4_generation = 0;
 	g_clear_object (&priv->wwan_ip4_config);
 	g_clear_object (&priv->ip4_config);
 	g_clear_object (&priv->con_ip6_config);
 	g_clear_object (&priv->ac_ip6_config);
 	g_clear_object (&priv->ext_ip6_config);
 	g_clear_object (&priv->ext_ip6_config_captured);
+	priv->ext_ip6_generation = 0;
 	g_clear_object (&priv->wwan_ip6_config);
 	g_clear_object (&priv->ip6_config);
 	g_clear_object (&priv->dad6_ip6_config);
@@ -12334,10 +12559,15 @@ _set_state_full (NMDevice *self,
 	case NM_DEVICE_STATE_ACTIVATED:
 		_LOGI (LOGD_DEVICE, "Activation: successful, device activated.");
 		nm_device_update_metered (self);
-		nm_dispatcher_call_device (NM_DISPATCHER_ACTION_UP,
-		                           self,
-		                           req,
-		                           NULL, NULL, NULL);
+		if (!nm_dispatcher_call_device (NM_DISPATCHER_ACTION_UP,
+		                                self,
+		                                req,
+		                                dispatcher_up_done,
+		                                req ? g_object_ref (req) : NULL,
+		                                NULL)) {
+			if (req)
+				g_object_unref (req);
+		}
 
 		if (priv->proxy_config) {
 			nm_pacrunner_manager_send (priv->pacrunner_manager,
@@ -13258,23 +13488,57 @@ nm_device_get_initial_hw_address (NMDevice *self)
 gboolean
 nm_device_spec_match_list (NMDevice *self, const GSList *specs)
 {
-	NMDeviceClass *klass;
 	NMMatchSpecMatchType m;
 
 	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
 
-	klass = NM_DEVICE_GET_CLASS (self);
-
 	m = nm_match_spec_device (specs,
 	                          nm_device_get_iface (self),
 	                          nm_device_get_type_description (self),
 	                          nm_device_get_driver (self),
 	                          nm_device_get_driver_version (self),
 	                          nm_device_get_permanent_hw_address (self),
-	                          klass->get_s390_subchannels ? klass->get_s390_subchannels (self) : NULL);
+	                          nm_device_get_s390_subchannels (self));
 	return m == NM_MATCH_SPEC_MATCH;
 }
 
+/**
+ * nm_device_spec_match_compiled:
+ * @self: an #NMDevice
+ * @compiled: specs compiled with nm_match_spec_compile()
+ *
+ * Like nm_device_spec_match_list(), but for specs that were parsed in advance.
+ *
+ * Returns: #TRUE if @self matches @compiled
+ */
+gboolean
+nm_device_spec_match_compiled (NMDevice *self, const NMMatchSpecCompiled *compiled)
+{
+	NMMatchSpecMatchType m;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+
+	m = nm_match_spec_compiled_match_device (compiled,
+	                                         nm_device_get_iface (self),
+	                                         nm_device_get_type_description (self),
+	                                         nm_device_get_driver (self),
+	                                         nm_device_get_driver_version (self),
+	                                         nm_device_get_permanent_hw_address (self),
+	                                         nm_device_get_s390_subchannels (self));
+	return m == NM_MATCH_SPEC_MATCH;
+}
+
+const char *
+nm_device_get_s390_subchannels (NMDevice *self)
+{
+	NMDeviceClass *klass;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+
+	klass = NM_DEVICE_GET_CLASS (self);
+	return klass->get_s390_subchannels ? klass->get_s390_subchannels (self) : NULL;
+}
+
 guint
 nm_device_get_supplicant_timeout (NMDevice *self)
 {
@@ -13322,6 +13586,35 @@ _activation_func_to_string (ActivationHandleFunc func)
 	g_return_val_if_reached ("unknown");
 }
 
+static const ActivationHandleFunc _activation_stage_funcs[_ACTIVATION_STAGE_NUM] = {
+	[ACTIVATION_STAGE_1_DEVICE_PREPARE]      = activate_stage1_device_prepare,
+	[ACTIVATION_STAGE_2_DEVICE_CONFIG]       = activate_stage2_device_config,
+	[ACTIVATION_STAGE_3_IP_CONFIG_START]     = activate_stage3_ip_config_start,
+	[ACTIVATION_STAGE_4_IP4_CONFIG_TIMEOUT]  = activate_stage4_ip4_config_timeout,
+	[ACTIVATION_STAGE_4_IP6_CONFIG_TIMEOUT]  = activate_stage4_ip6_config_timeout,
+	[ACTIVATION_STAGE_5_IP4_CONFIG_COMMIT]   = activate_stage5_ip4_config_commit,
+	[ACTIVATION_STAGE_5_IP6_CONFIG_COMMIT]   = activate_stage5_ip6_config_commit,
+};
+
+static guint
+_activation_func_to_stage (ActivationHandleFunc func)
+{
+	guint i;
+
+	for (i = 0; i < _ACTIVATION_STAGE_NUM; i++) {
+		if (_activation_stage_funcs[i] == func)
+			return i;
+	}
+	g_return_val_if_reached (ACTIVATION_STAGE_1_DEVICE_PREPARE);
+}
+
+static const char *
+_activation_stage_to_string (guint stage)
+{
+	g_return_val_if_fail (stage < _ACTIVATION_STAGE_NUM, "unknown");
+	return _activation_func_to_string (_activation_stage_funcs[stage]);
+}
+
 /*****************************************************************************/
 
 static void
@@ -13485,6 +13778,9 @@ dispose (GObject *object)
 
 	g_hash_table_remove_all (priv->ip6_saved_properties);
 
+	activation_source_clear (self, AF_INET);
+	activation_source_clear (self, AF_INET6);
+
 	nm_clear_g_source (&priv->recheck_assume_id);
 	nm_clear_g_source (&priv->recheck_available.call_id);
 
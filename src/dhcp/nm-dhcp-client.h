@@ -176,6 +176,8 @@ typedef struct {
 	                                 const char *uuid,
 	                                 gboolean ipv6,
 	                                 guint32 default_route_metric);
+	void    (*load_leases) (void);
+	void    (*flush_leases) (void);
 } NMDhcpClientFactory;
 
 extern const NMDhcpClientFactory _nm_dhcp_client_factory_dhclient;
@@ -401,6 +401,9 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 	priv->clients = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 	                                       NULL,
 	                                       (GDestroyNotify) g_object_unref);
+
+	if (client_factory->load_leases)
+		client_factory->load_leases ();
 }
 
 static void
@@ -416,6 +419,10 @@ dispose (GObject *object)
 		g_list_free (values);
 	}
 
+	if (   priv->client_factory
+	    && priv->client_factory->flush_leases)
+		priv->client_factory->flush_leases ();
+
 	G_OBJECT_CLASS (nm_dhcp_manager_parent_class)->dispose (object);
 }
 
@@ -26,6 +26,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <net/if_arp.h>
 
 #include "nm-utils.h"
@@ -56,6 +58,13 @@ typedef struct {
 	sd_dhcp6_client *client6;
 	char *lease_file;
 
+	/* a still fresh lease from the lease store, configured while the
+	 * client confirms it with the server. */
+	sd_dhcp_lease *cached_lease;
+	guint32 cached_lease_elapsed;
+	guint cached_lease_id;
+	guint cached_lease_expire_id;
+
 	guint request_count;
 
 	gboolean privacy;
@@ -220,6 +229,7 @@ static NMIP4Config *
 lease_to_ip4_config (const char *iface,
                      int ifindex,
                      sd_dhcp_lease *lease,
+                     guint32 elapsed,
                      GHashTable *options,
                      guint32 default_priority,
                      gboolean log_lease,
@@ -266,6 +276,8 @@ lease_to_ip4_config (const char *iface,
 
 	/* Lease time */
 	sd_dhcp_lease_get_lifetime (lease, &lifetime);
+	if (lifetime != NM_PLATFORM_LIFETIME_PERMANENT)
+		lifetime = lifetime > elapsed ? lifetime - elapsed : 0;
 	address.timestamp = nm_utils_get_monotonic_timestamp_s ();
 	address.lifetime = address.preferred = lifetime;
 	end_time = (guint64) time (NULL) + lifetime;
@@ -423,6 +435,193 @@ get_leasefile_path (const char *iface, const char *uuid, gboolean ipv6)
 	                        iface);
 }
 
+/*****************************************************************************/
+
+/* The IPv4 leases of all interfaces are kept in memory. The lease files
+ * are read once when the DHCP manager starts, and renewed leases are
+ * written back by a single deferred flush, so that a burst of renewals
+ * costs one round of writes and fsync() instead of one per event. */
+
+#define LEASE_STORE_FLUSH_DELAY_SEC 2
+
+typedef struct {
+	sd_dhcp_lease *lease;
+	gint64 saved_at;     /* wall clock time when the lease was obtained */
+	bool dirty:1;
+} LeaseEntry;
+
+static GHashTable *lease_store;
+static guint lease_store_flush_id;
+
+static void
+_lease_entry_free (gpointer data)
+{
+	LeaseEntry *entry = data;
+
+	sd_dhcp_lease_unref (entry->lease);
+	g_slice_free (LeaseEntry, entry);
+}
+
+static void
+nm_dhcp_systemd_load_leases (void)
+{
+	GDir *dir;
+	const char *name;
+
+	if (lease_store)
+		return;
+
+	lease_store = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _lease_entry_free);
+
+	dir = g_dir_open (NMSTATEDIR, 0, NULL);
+	if (!dir)
+		return;
+
+	while ((name = g_dir_read_name (dir))) {
+		gs_free char *path = NULL;
+		sd_dhcp_lease *lease = NULL;
+		LeaseEntry *entry;
+		struct stat st;
+
+		/* only IPv4 leases, see get_leasefile_path() */
+		if (   !g_str_has_prefix (name, "internal-")
+		    || !g_str_has_suffix (name, ".lease"))
+			continue;
+
+		path = g_build_filename (NMSTATEDIR, name, NULL);
+		if (   stat (path, &st) != 0
+		    || !S_ISREG (st.st_mode))
+			continue;
+		if (   dhcp_lease_load (&lease, path) < 0
+		    || !lease)
+			continue;
+
+		entry = g_slice_new0 (LeaseEntry);
+		entry->lease = lease;
+		entry->saved_at = st.st_mtime;
+		g_hash_table_insert (lease_store, g_steal_pointer (&path), entry);
+	}
+	g_dir_close (dir);
+
+	nm_log_dbg (LOGD_DHCP4, "dhcp4: loaded %u lease(s) from %s",
+	            g_hash_table_size (lease_store), NMSTATEDIR);
+}
+
+static void
+_fsync_path (const char *path, int flags)
+{
+	int fd;
+
+	fd = open (path, O_RDONLY | O_CLOEXEC | flags);
+	if (fd < 0)
+		return;
+	fsync (fd);
+	close (fd);
+}
+
+static void
+nm_dhcp_systemd_flush_leases (void)
+{
+	GHashTableIter iter;
+	const char *path;
+	LeaseEntry *entry;
+	guint n_saved = 0;
+
+	nm_clear_g_source (&lease_store_flush_id);
+
+	if (!lease_store)
+		return;
+
+	g_hash_table_iter_init (&iter, lease_store);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &path, (gpointer *) &entry)) {
+		if (!entry->dirty)
+			continue;
+		entry->dirty = FALSE;
+		if (dhcp_lease_save (entry->lease, path) < 0)
+			continue;
+		_fsync_path (path, 0);
+		n_saved++;
+	}
+
+	if (n_saved) {
+		/* make the renames durable too */
+		_fsync_path (NMSTATEDIR, O_DIRECTORY);
+		nm_log_dbg (LOGD_DHCP4, "dhcp4: saved %u lease(s)", n_saved);
+	}
+}
+
+static gboolean
+lease_store_flush_cb (gpointer user_data)
+{
+	lease_store_flush_id = 0;
+	nm_dhcp_systemd_flush_leases ();
+	return G_SOURCE_REMOVE;
+}
+
+static LeaseEntry *
+lease_store_lookup (const char *path)
+{
+	nm_dhcp_systemd_load_leases ();
+	return g_hash_table_lookup (lease_store, path);
+}
+
+static void
+lease_store_set (const char *path, sd_dhcp_lease *lease)
+{
+	LeaseEntry *entry;
+
+	entry = lease_store_lookup (path);
+	if (!entry) {
+		entry = g_slice_new0 (LeaseEntry);
+		g_hash_table_insert (lease_store, g_strdup (path), entry);
+	}
+
+	lease = sd_dhcp_lease_ref (lease);
+	sd_dhcp_lease_unref (entry->lease);
+	entry->lease = lease;
+	entry->saved_at = time (NULL);
+	entry->dirty = TRUE;
+
+	if (!lease_store_flush_id) {
+		lease_store_flush_id = g_timeout_add_seconds (LEASE_STORE_FLUSH_DELAY_SEC,
+		                                              lease_store_flush_cb,
+		                                              NULL);
+	}
+}
+
+/* A stored lease is considered fresh until its renewal time T1 passed.
+ * Until then the server is expected to still honor it, so it can be
+ * configured right away while the client confirms it in the background. */
+static gboolean
+lease_entry_is_fresh (const LeaseEntry *entry, guint32 *out_elapsed, guint32 *out_remaining)
+{
+	guint32 lifetime = 0, t1 = 0;
+	gint64 now = time (NULL);
+
+	if (   sd_dhcp_lease_get_lifetime (entry->lease, &lifetime) < 0
+	    || lifetime == 0)
+		return FALSE;
+
+	if (lifetime == NM_PLATFORM_LIFETIME_PERMANENT) {
+		*out_elapsed = 0;
+		*out_remaining = NM_PLATFORM_LIFETIME_PERMANENT;
+		return TRUE;
+	}
+
+	if (   sd_dhcp_lease_get_t1 (entry->lease, &t1) < 0
+	    || t1 == 0
+	    || t1 > lifetime)
+		t1 = lifetime / 2;
+
+	if (   now < entry->saved_at
+	    || now - entry->saved_at >= t1)
+		return FALSE;
+
+	*out_elapsed = now - entry->saved_at;
+	*out_remaining = lifetime - *out_elapsed;
+	return TRUE;
+}
+
 static GSList *
 nm_dhcp_systemd_get_lease_ip_configs (const char *iface,
                                       int ifindex,
@@ -432,20 +631,18 @@ nm_dhcp_systemd_get_lease_ip_configs (const char *iface,
 {
 	GSList *leases = NULL;
 	gs_free char *path = NULL;
-	sd_dhcp_lease *lease = NULL;
+	LeaseEntry *entry;
 	NMIP4Config *ip4_config;
-	int r;
 
 	if (ipv6)
 		return NULL;
 
 	path = get_leasefile_path (iface, uuid, FALSE);
-	r = dhcp_lease_load (&lease, path);
-	if (r == 0 && lease) {
-		ip4_config = lease_to_ip4_config (iface, ifindex, lease, NULL, default_route_metric, FALSE, NULL);
+	entry = lease_store_lookup (path);
+	if (entry) {
+		ip4_config = lease_to_ip4_config (iface, ifindex, entry->lease, 0, NULL, default_route_metric, FALSE, NULL);
 		if (ip4_config)
 			leases = g_slist_append (leases, ip4_config);
-		sd_dhcp_lease_unref (lease);
 	}
 
 	return leases;
@@ -475,6 +672,76 @@ _save_client_id (NMDhcpSystemd *self,
 	}
 }
 
+static void
+cached_lease_clear (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->cached_lease_id);
+	nm_clear_g_source (&priv->cached_lease_expire_id);
+	if (priv->cached_lease)
+		priv->cached_lease = sd_dhcp_lease_unref (priv->cached_lease);
+}
+
+static gboolean
+cached_lease_expire_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self = NM_DHCP_SYSTEMD (user_data);
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+
+	priv->cached_lease_expire_id = 0;
+	cached_lease_clear (self);
+
+	_LOGW ("stored lease expired before the server confirmed it");
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_EXPIRE, NULL, NULL);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+cached_lease_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self = NM_DHCP_SYSTEMD (user_data);
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	const char *iface = nm_dhcp_client_get_iface (NM_DHCP_CLIENT (self));
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+	gs_unref_hashtable GHashTable *options = NULL;
+	gs_free_error GError *error = NULL;
+	guint32 lifetime = 0;
+
+	priv->cached_lease_id = 0;
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	ip4_config = lease_to_ip4_config (iface,
+	                                  nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (self)),
+	                                  priv->cached_lease,
+	                                  priv->cached_lease_elapsed,
+	                                  options,
+	                                  nm_dhcp_client_get_priority (NM_DHCP_CLIENT (self)),
+	                                  TRUE,
+	                                  &error);
+	if (!ip4_config) {
+		_LOGD ("stored lease not usable: %s", error->message);
+		cached_lease_clear (self);
+		return G_SOURCE_REMOVE;
+	}
+
+	add_requests_to_options (options, dhcp4_requests);
+
+	sd_dhcp_lease_get_lifetime (priv->cached_lease, &lifetime);
+	if (lifetime != NM_PLATFORM_LIFETIME_PERMANENT) {
+		priv->cached_lease_expire_id = g_timeout_add_seconds (lifetime - priv->cached_lease_elapsed,
+		                                                      cached_lease_expire_cb,
+		                                                      self);
+	}
+
+	_LOGI ("using stored lease while confirming it with the server");
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self),
+	                          NM_DHCP_STATE_BOUND,
+	                          G_OBJECT (ip4_config),
+	                          options);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 bound4_handle (NMDhcpSystemd *self)
 {
@@ -486,6 +753,8 @@ bound4_handle (NMDhcpSystemd *self)
 	GError *error = NULL;
 	int r;
 
+	cached_lease_clear (self);
+
 	r = sd_dhcp_client_get_lease (priv->client4, &lease);
 	if (r < 0 || !lease) {
 		_LOGW ("no lease!");
@@ -499,6 +768,7 @@ bound4_handle (NMDhcpSystemd *self)
 	ip4_config = lease_to_ip4_config (iface,
 	                                  nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (self)),
 	                                  lease,
+	                                  0,
 	                                  options,
 	                                  nm_dhcp_client_get_priority (NM_DHCP_CLIENT (self)),
 	                                  TRUE,
@@ -509,7 +779,7 @@ bound4_handle (NMDhcpSystemd *self)
 		uint8_t type = 0;
 
 		add_requests_to_options (options, dhcp4_requests);
-		dhcp_lease_save (lease, priv->lease_file);
+		lease_store_set (priv->lease_file, lease);
 
 		sd_dhcp_client_get_client_id(priv->client4, &type, &client_id, &client_id_len);
 		if (client_id)
@@ -541,9 +811,11 @@ dhcp_event_cb (sd_dhcp_client *client, int event, gpointer user_data)
 
 	switch (event) {
 	case SD_DHCP_CLIENT_EVENT_EXPIRED:
+		cached_lease_clear (self);
 		nm_dhcp_client_set_state (NM_DHCP_CLIENT (user_data), NM_DHCP_STATE_EXPIRE, NULL, NULL);
 		break;
 	case SD_DHCP_CLIENT_EVENT_STOP:
+		cached_lease_clear (self);
 		nm_dhcp_client_set_state (NM_DHCP_CLIENT (user_data), NM_DHCP_STATE_FAIL, NULL, NULL);
 		break;
 	case SD_DHCP_CLIENT_EVENT_RENEW:
@@ -576,6 +848,8 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 	const char *iface = nm_dhcp_client_get_iface (client);
 	const GByteArray *hwaddr;
 	sd_dhcp_lease *lease = NULL;
+	LeaseEntry *entry;
+	guint32 elapsed = 0, remaining = 0;
 	GBytes *override_client_id;
 	const uint8_t *client_id = NULL;
 	size_t client_id_len = 0;
@@ -641,7 +915,9 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 		goto error;
 	}
 
-	dhcp_lease_load (&lease, priv->lease_file);
+	entry = lease_store_lookup (priv->lease_file);
+	if (entry)
+		lease = sd_dhcp_lease_ref (entry->lease);
 
 	if (last_ip4_address)
 		inet_pton (AF_INET, last_ip4_address, &last_addr);
@@ -721,6 +997,24 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 
 	nm_dhcp_client_start_timeout (client);
 
+	/* After a reboot, configure a lease that is still fresh immediately
+	 * instead of waiting for the server. The client requests the same
+	 * address, and the outcome replaces the stored lease once it arrives. */
+	if (   entry
+	    && lease_entry_is_fresh (entry, &elapsed, &remaining)) {
+		struct in_addr lease_addr = { 0 };
+
+		sd_dhcp_lease_get_address (lease, &lease_addr);
+		if (   lease_addr.s_addr
+		    && lease_addr.s_addr == last_addr.s_addr) {
+			_LOGD ("stored lease is fresh (%u seconds old, expires in %u seconds)",
+			       (guint) elapsed, (guint) remaining);
+			priv->cached_lease = sd_dhcp_lease_ref (lease);
+			priv->cached_lease_elapsed = elapsed;
+			priv->cached_lease_id = g_idle_add (cached_lease_cb, self);
+		}
+	}
+
 	success = TRUE;
 
 error:
@@ -1008,6 +1302,8 @@ stop (NMDhcpClient *client, gboolean release, const GByteArray *duid)
 	       priv->client4 ? '4' : '6',
 	       priv->client4 ? (gpointer) priv->client4 : (gpointer) priv->client6);
 
+	cached_lease_clear (self);
+
 	if (priv->client4) {
 		sd_dhcp_client_set_callback (priv->client4, NULL, NULL);
 		r = sd_dhcp_client_stop (priv->client4);
@@ -1032,6 +1328,7 @@ dispose (GObject *object)
 {
 	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE ((NMDhcpSystemd *) object);
 
+	cached_lease_clear ((NMDhcpSystemd *) object);
 	g_clear_pointer (&priv->lease_file, g_free);
 
 	if (priv->client4) {
@@ -1067,4 +1364,6 @@ const NMDhcpClientFactory _nm_dhcp_client_factory_internal = {
 	.get_type = nm_dhcp_systemd_get_type,
 	.get_path = NULL,
 	.get_lease_ip_configs = nm_dhcp_systemd_get_lease_ip_configs,
+	.load_leases = nm_dhcp_systemd_load_leases,
+	.flush_leases = nm_dhcp_systemd_flush_leases,
 };
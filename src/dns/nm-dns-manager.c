@@ -48,6 +48,7 @@
 #include "nm-config.h"
 #include "devices/nm-device.h"
 #include "nm-manager.h"
+#include "nm-perf-counters.h"
 
 #include "nm-dns-plugin.h"
 #include "nm-dns-dnsmasq.h"
@@ -571,6 +572,8 @@ write_resolv_conf_contents (FILE *f,
 {
 	int errsv;
 
+	nm_perf_counter_inc (NM_PERF_COUNTER_RESOLV_CONF_WRITES);
+
 	if (fprintf (f, "%s", content) < 0) {
 		errsv = errno;
 		g_set_error (error,
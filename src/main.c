@@ -388,6 +388,10 @@ main (int argc, char *argv[])
 	}
 
 	/* Set up platform interaction layer */
+	nm_linux_platform_set_ignored_route_protocols (nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                                                NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                                NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_ROUTE_PROTOCOLS,
+	                                                                                NM_CONFIG_GET_VALUE_STRIP));
 	nm_linux_platform_setup ();
 
 	NM_UTILS_KEEP_ALIVE (config, NM_PLATFORM_GET, "NMConfig-depends-on-NMPlatform");
@@ -38,11 +38,20 @@
 
 /*****************************************************************************/
 
+/* One libndp handle (and thus one raw ICMPv6 socket) per network namespace,
+ * shared by all NMLndpNDisc instances in it. libndp dispatches received
+ * messages to the handlers registered for the message's ifindex. */
 typedef struct {
+	NMPNetns *netns;
 	struct ndp *ndp;
-
 	GIOChannel *event_channel;
 	guint event_id;
+	guint ref_count;
+} NdpHandle;
+
+typedef struct {
+	NdpHandle *handle;
+	struct ndp *ndp;
 } NMLndpNDiscPrivate;
 
 /*****************************************************************************/
@@ -473,35 +482,87 @@ receive_rs (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
 	return 0;
 }
 
+/*****************************************************************************/
+
+static GSList *ndp_handles = NULL;
+
 static gboolean
-event_ready (GIOChannel *source, GIOCondition condition, NMNDisc *ndisc)
+ndp_handle_event_ready (GIOChannel *source, GIOCondition condition, gpointer user_data)
 {
+	NdpHandle *handle = user_data;
 	nm_auto_pop_netns NMPNetns *netns = NULL;
-	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
-
-	_LOGD ("processing libndp events");
 
-	if (!nm_ndisc_netns_push (ndisc, &netns))
-		return G_SOURCE_CONTINUE;
+	if (handle->netns) {
+		if (!nmp_netns_push (handle->netns))
+			return G_SOURCE_CONTINUE;
+		netns = handle->netns;
+	}
 
-	ndp_callall_eventfd_handler (priv->ndp);
+	ndp_callall_eventfd_handler (handle->ndp);
 	return G_SOURCE_CONTINUE;
 }
 
+/* must be called with @netns being the current network namespace. */
+static NdpHandle *
+ndp_handle_acquire (NMPNetns *netns, GError **error)
+{
+	NdpHandle *handle;
+	GSList *iter;
+	int errsv;
+
+	for (iter = ndp_handles; iter; iter = iter->next) {
+		handle = iter->data;
+		if (handle->netns == netns) {
+			handle->ref_count++;
+			return handle;
+		}
+	}
+
+	handle = g_slice_new0 (NdpHandle);
+	errsv = ndp_open (&handle->ndp);
+	if (errsv != 0) {
+		errsv = errsv > 0 ? errsv : -errsv;
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "failure creating libndp socket: %s (%d)",
+		             g_strerror (errsv), errsv);
+		g_slice_free (NdpHandle, handle);
+		return NULL;
+	}
+
+	handle->ref_count = 1;
+	handle->netns = netns ? g_object_ref (netns) : NULL;
+	handle->event_channel = g_io_channel_unix_new (ndp_get_eventfd (handle->ndp));
+	handle->event_id = g_io_add_watch (handle->event_channel, G_IO_IN, ndp_handle_event_ready, handle);
+
+	ndp_handles = g_slist_prepend (ndp_handles, handle);
+	return handle;
+}
+
 static void
-start (NMNDisc *ndisc)
+ndp_handle_release (NdpHandle *handle)
 {
-	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
-	int fd = ndp_get_eventfd (priv->ndp);
+	nm_assert (handle && handle->ref_count > 0);
 
-	g_return_if_fail (!priv->event_channel);
-	g_return_if_fail (!priv->event_id);
+	if (--handle->ref_count > 0)
+		return;
 
-	priv->event_channel = g_io_channel_unix_new (fd);
-	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, (GIOFunc) event_ready, ndisc);
+	ndp_handles = g_slist_remove (ndp_handles, handle);
+	nm_clear_g_source (&handle->event_id);
+	g_io_channel_unref (handle->event_channel);
+	ndp_close (handle->ndp);
+	g_clear_object (&handle->netns);
+	g_slice_free (NdpHandle, handle);
+}
+
+/*****************************************************************************/
+
+static void
+start (NMNDisc *ndisc)
+{
+	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
 
 	/* Flush any pending messages to avoid using obsolete information */
-	event_ready (priv->event_channel, 0, ndisc);
+	ndp_handle_event_ready (priv->handle->event_channel, 0, priv->handle);
 
 	switch (nm_ndisc_get_node_type (ndisc)) {
 	case NM_NDISC_NODE_TYPE_HOST:
@@ -546,7 +607,6 @@ nm_lndp_ndisc_new (NMPlatform *platform,
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMNDisc *ndisc;
 	NMLndpNDiscPrivate *priv;
-	int errsv;
 
 	g_return_val_if_fail (NM_IS_PLATFORM (platform), NULL);
 	g_return_val_if_fail (!error || !*error, NULL);
@@ -576,16 +636,12 @@ nm_lndp_ndisc_new (NMPlatform *platform,
 
 	priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
 
-	errsv = ndp_open (&priv->ndp);
-
-	if (errsv != 0) {
-		errsv = errsv > 0 ? errsv : -errsv;
-		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
-		             "failure creating libndp socket: %s (%d)",
-		             g_strerror (errsv), errsv);
+	priv->handle = ndp_handle_acquire (nm_ndisc_netns_get (ndisc), error);
+	if (!priv->handle) {
 		g_object_unref (ndisc);
 		return NULL;
 	}
+	priv->ndp = priv->handle->ndp;
 	return ndisc;
 }
 
@@ -595,10 +651,7 @@ dispose (GObject *object)
 	NMNDisc *ndisc = (NMNDisc *) object;
 	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
 
-	nm_clear_g_source (&priv->event_id);
-	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
-
-	if (priv->ndp) {
+	if (priv->handle) {
 		switch (nm_ndisc_get_node_type (ndisc)) {
 		case NM_NDISC_NODE_TYPE_HOST:
 			ndp_msgrcv_handler_unregister (priv->ndp, receive_ra, NDP_MSG_RA, nm_ndisc_get_ifindex (ndisc), ndisc);
@@ -609,7 +662,8 @@ dispose (GObject *object)
 		default:
 			g_assert_not_reached ();
 		}
-		ndp_close (priv->ndp);
+		ndp_handle_release (priv->handle);
+		priv->handle = NULL;
 		priv->ndp = NULL;
 	}
 
@@ -53,6 +53,10 @@ typedef struct _NMActiveConnectionPrivate {
 
 	NMActivationType activation_type:3;
 
+	/* monotonic timestamps in microseconds, zero if not yet reached. */
+	gint64 created_at_us;
+	gint64 milestones[_NM_ACTIVATION_MILESTONE_NUM];
+
 	NMAuthSubject *subject;
 	NMActiveConnection *master;
 
@@ -81,6 +85,7 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMActiveConnection,
 	PROP_DHCP6_CONFIG,
 	PROP_VPN,
 	PROP_MASTER,
+	PROP_TIMINGS,
 
 	PROP_INT_SETTINGS_CONNECTION,
 	PROP_INT_APPLIED_CONNECTION,
@@ -145,6 +150,212 @@ NM_UTILS_LOOKUP_STR_DEFINE_STATIC (_state_to_string, NMActiveConnectionState,
 );
 #define state_to_string(state) NM_UTILS_LOOKUP_STR (_state_to_string, state)
 
+NM_UTILS_LOOKUP_STR_DEFINE_STATIC (_milestone_to_string, NMActivationMilestone,
+	NM_UTILS_LOOKUP_DEFAULT_WARN (NULL),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_PREPARE,         "prepare"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_CONFIG,          "config"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_IP_CONFIG_START, "ip-config"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_DHCP4_BOUND,     "dhcp4-bound"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_DHCP6_BOUND,     "dhcp6-bound"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_IP4_DAD_DONE,    "ip4-dad"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_IP6_DAD_DONE,    "ip6-dad"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_IP4_COMMIT,      "ip4-commit"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_IP6_COMMIT,      "ip6-commit"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_ACTIVATED,       "activated"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_ACTIVATION_MILESTONE_DISPATCHER_DONE, "dispatcher"),
+);
+
+/*****************************************************************************/
+
+/* Time from the creation of an active connection until it is activated,
+ * summarized per device type. The histograms are logged on SIGUSR2 and
+ * are part of the performance counters on D-Bus. */
+
+#define ACTIVATION_HISTOGRAM_BUCKETS 16
+
+typedef struct {
+	guint64 n;
+	guint64 sum_msec;
+	guint64 buckets[ACTIVATION_HISTOGRAM_BUCKETS];
+} ActivationHistogram;
+
+static GHashTable *activation_histograms;
+
+static void
+_activation_histogram_add (const char *type, gint64 msec)
+{
+	ActivationHistogram *hist;
+	gint64 v = msec;
+	guint b = 0;
+
+	if (G_UNLIKELY (activation_histograms == NULL))
+		activation_histograms = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	hist = g_hash_table_lookup (activation_histograms, type);
+	if (!hist) {
+		hist = g_new0 (ActivationHistogram, 1);
+		g_hash_table_insert (activation_histograms, g_strdup (type), hist);
+	}
+
+	/* bucket N counts durations below 2^N milliseconds. */
+	while (   v > 0
+	       && b < ACTIVATION_HISTOGRAM_BUCKETS - 1) {
+		v >>= 1;
+		b++;
+	}
+	hist->n++;
+	hist->sum_msec += msec;
+	hist->buckets[b]++;
+}
+
+/* the upper bound of a bucket, or the lower bound for the last one. */
+static guint64
+_activation_histogram_bucket_msec (guint i)
+{
+	return i == ACTIVATION_HISTOGRAM_BUCKETS - 1 ? (1ULL << (i - 1)) : (1ULL << i);
+}
+
+/**
+ * nm_active_connection_activation_stats_log:
+ *
+ * Logs, per device type, a histogram of the time it took active
+ * connections to become activated.
+ */
+void
+nm_active_connection_activation_stats_log (void)
+{
+	GHashTableIter iter;
+	const char *type;
+	const ActivationHistogram *hist;
+	nm_auto_free_gstring GString *str = NULL;
+	guint i;
+
+	if (!activation_histograms)
+		return;
+
+	str = g_string_new (NULL);
+	g_hash_table_iter_init (&iter, activation_histograms);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &type, (gpointer *) &hist)) {
+		g_string_truncate (str, 0);
+		for (i = 0; i < ACTIVATION_HISTOGRAM_BUCKETS; i++) {
+			if (!hist->buckets[i])
+				continue;
+			g_string_append_printf (str, "%s%s%llums:%llu",
+			                        str->len ? " " : "",
+			                        i == ACTIVATION_HISTOGRAM_BUCKETS - 1 ? ">=" : "<",
+			                        (unsigned long long) _activation_histogram_bucket_msec (i),
+			                        (unsigned long long) hist->buckets[i]);
+		}
+		nm_log_info (LOGD_DEVICE, "activation: %s: %llu activations, average %llums; [%s]",
+		             type,
+		             (unsigned long long) hist->n,
+		             (unsigned long long) (hist->sum_msec / hist->n),
+		             str->str);
+	}
+}
+
+/**
+ * nm_active_connection_activation_stats_add_counters:
+ * @builder: a #GVariantBuilder of type "a{st}"
+ *
+ * Adds the activation histograms to @builder. For each device type,
+ * "activation-<type>-count" is the number of activations and
+ * "activation-<type>-msec" the sum of their durations. Each non-empty
+ * bucket of the histogram is added as "activation-<type>-lt-<N>ms",
+ * or "activation-<type>-ge-<N>ms" for the last one.
+ */
+void
+nm_active_connection_activation_stats_add_counters (GVariantBuilder *builder)
+{
+	GHashTableIter iter;
+	const char *type;
+	const ActivationHistogram *hist;
+	char buf[100];
+	guint i;
+
+	if (!activation_histograms)
+		return;
+
+	g_hash_table_iter_init (&iter, activation_histograms);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &type, (gpointer *) &hist)) {
+		g_variant_builder_add (builder, "{st}",
+		                       nm_sprintf_buf (buf, "activation-%s-count", type),
+		                       hist->n);
+		g_variant_builder_add (builder, "{st}",
+		                       nm_sprintf_buf (buf, "activation-%s-msec", type),
+		                       hist->sum_msec);
+		for (i = 0; i < ACTIVATION_HISTOGRAM_BUCKETS; i++) {
+			if (!hist->buckets[i])
+				continue;
+			g_variant_builder_add (builder, "{st}",
+			                       nm_sprintf_buf (buf, "activation-%s-%s-%llums",
+			                                       type,
+			                                       i == ACTIVATION_HISTOGRAM_BUCKETS - 1 ? "ge" : "lt",
+			                                       (unsigned long long) _activation_histogram_bucket_msec (i)),
+			                       hist->buckets[i]);
+		}
+	}
+}
+
+/**
+ * nm_active_connection_record_milestone:
+ * @self: the #NMActiveConnection
+ * @milestone: the point of the activation that was reached
+ *
+ * Records when @milestone was first reached, relative to the creation
+ * of @self. The timings are exported as the "Timings" property.
+ */
+void
+nm_active_connection_record_milestone (NMActiveConnection *self,
+                                       NMActivationMilestone milestone)
+{
+	NMActiveConnectionPrivate *priv;
+	gint64 now;
+
+	g_return_if_fail (NM_IS_ACTIVE_CONNECTION (self));
+	g_return_if_fail (milestone < _NM_ACTIVATION_MILESTONE_NUM);
+
+	priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+
+	if (priv->milestones[milestone])
+		return;
+
+	now = nm_utils_get_monotonic_timestamp_us ();
+	priv->milestones[milestone] = now;
+
+	_LOGT ("activation milestone %s after %lld usec",
+	       _milestone_to_string (milestone),
+	       (long long) (now - priv->created_at_us));
+
+	if (   milestone == NM_ACTIVATION_MILESTONE_ACTIVATED
+	    && priv->activation_type == NM_ACTIVATION_TYPE_MANAGED) {
+		_activation_histogram_add (priv->vpn
+		                             ? "vpn"
+		                             : (priv->device ? nm_device_get_type_description (priv->device) : "unknown"),
+		                           (now - priv->created_at_us) / 1000);
+	}
+
+	_notify (self, PROP_TIMINGS);
+}
+
+static GVariant *
+_timings_to_variant (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+	for (i = 0; i < _NM_ACTIVATION_MILESTONE_NUM; i++) {
+		if (!priv->milestones[i])
+			continue;
+		g_variant_builder_add (&builder, "{st}",
+		                       _milestone_to_string (i),
+		                       (guint64) (priv->milestones[i] - priv->created_at_us));
+	}
+	return g_variant_builder_end (&builder);
+}
+
 /*****************************************************************************/
 
 static void
@@ -231,6 +442,11 @@ nm_active_connection_set_state (NMActiveConnection *self,
 	       state_to_string (new_state),
 	       state_to_string (priv->state));
 
+	/* record before an assumed activation turns into a managed one, so that
+	 * it does not count towards the activation histograms. */
+	if (new_state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED)
+		nm_active_connection_record_milestone (self, NM_ACTIVATION_MILESTONE_ACTIVATED);
+
 	if (   new_state == NM_ACTIVE_CONNECTION_STATE_ACTIVATED
 	    && priv->activation_type == NM_ACTIVATION_TYPE_ASSUME) {
 		/* assuming connections mean to gracefully take over an externally
@@ -1094,6 +1310,9 @@ get_property (GObject *object, guint prop_id,
 			master_device = nm_active_connection_get_device (priv->master);
 		nm_utils_g_value_set_object_path (value, master_device);
 		break;
+	case PROP_TIMINGS:
+		g_value_set_variant (value, _timings_to_variant ((NMActiveConnection *) object));
+		break;
 	case PROP_INT_SUBJECT:
 		g_value_set_object (value, priv->subject);
 		break;
@@ -1186,6 +1405,7 @@ nm_active_connection_init (NMActiveConnection *self)
 
 	priv->activation_type = NM_ACTIVATION_TYPE_MANAGED;
 	priv->version_id = _version_id_new ();
+	priv->created_at_us = nm_utils_get_monotonic_timestamp_us ();
 }
 
 static void
@@ -1354,6 +1574,13 @@ nm_active_connection_class_init (NMActiveConnectionClass *ac_class)
 	                          G_PARAM_READABLE |
 	                          G_PARAM_STATIC_STRINGS);
 
+	obj_properties[PROP_TIMINGS] =
+	     g_param_spec_variant (NM_ACTIVE_CONNECTION_TIMINGS, "", "",
+	                           G_VARIANT_TYPE ("a{st}"),
+	                           NULL,
+	                           G_PARAM_READABLE |
+	                           G_PARAM_STATIC_STRINGS);
+
 	/* Internal properties */
 	obj_properties[PROP_INT_SETTINGS_CONNECTION] =
 	     g_param_spec_object (NM_ACTIVE_CONNECTION_INT_SETTINGS_CONNECTION, "", "",
@@ -47,6 +47,7 @@
 #define NM_ACTIVE_CONNECTION_DHCP6_CONFIG    "dhcp6-config"
 #define NM_ACTIVE_CONNECTION_VPN             "vpn"
 #define NM_ACTIVE_CONNECTION_MASTER          "master"
+#define NM_ACTIVE_CONNECTION_TIMINGS         "timings"
 
 /* Internal non-exported properties */
 #define NM_ACTIVE_CONNECTION_INT_SETTINGS_CONNECTION "int-settings-connection"
@@ -65,6 +66,21 @@
 #define NM_ACTIVE_CONNECTION_DEVICE_METERED_CHANGED  "device-metered-changed"
 #define NM_ACTIVE_CONNECTION_PARENT_ACTIVE           "parent-active"
 
+typedef enum {
+	NM_ACTIVATION_MILESTONE_PREPARE,
+	NM_ACTIVATION_MILESTONE_CONFIG,
+	NM_ACTIVATION_MILESTONE_IP_CONFIG_START,
+	NM_ACTIVATION_MILESTONE_DHCP4_BOUND,
+	NM_ACTIVATION_MILESTONE_DHCP6_BOUND,
+	NM_ACTIVATION_MILESTONE_IP4_DAD_DONE,
+	NM_ACTIVATION_MILESTONE_IP6_DAD_DONE,
+	NM_ACTIVATION_MILESTONE_IP4_COMMIT,
+	NM_ACTIVATION_MILESTONE_IP6_COMMIT,
+	NM_ACTIVATION_MILESTONE_ACTIVATED,
+	NM_ACTIVATION_MILESTONE_DISPATCHER_DONE,
+	_NM_ACTIVATION_MILESTONE_NUM,
+} NMActivationMilestone;
+
 struct _NMActiveConnectionPrivate;
 
 struct _NMActiveConnection {
@@ -167,4 +183,11 @@ NMActivationType nm_active_connection_get_activation_type (NMActiveConnection *s
 
 void          nm_active_connection_clear_secrets (NMActiveConnection *self);
 
+void          nm_active_connection_record_milestone (NMActiveConnection *self,
+                                                     NMActivationMilestone milestone);
+
+void          nm_active_connection_activation_stats_log (void);
+
+void          nm_active_connection_activation_stats_add_counters (GVariantBuilder *builder);
+
 #endif /* __NETWORKMANAGER_ACTIVE_CONNECTION_H__ */
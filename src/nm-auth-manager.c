@@ -30,6 +30,11 @@
 #define POLKIT_OBJECT_PATH                  "/org/freedesktop/PolicyKit1/Authority"
 #define POLKIT_INTERFACE                    "org.freedesktop.PolicyKit1.Authority"
 
+/* How long a non-interactive CheckAuthorization result is reused for the
+ * same subject and action. polkit's "Changed" signal flushes the cache earlier. */
+#define CACHE_TTL_MSEC                      5000
+#define CACHE_PRUNE_SIZE                    256
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE_BASE (
@@ -50,6 +55,10 @@ typedef struct {
 	GCancellable *new_proxy_cancellable;
 	GSList *queued_calls;
 	GDBusProxy *proxy;
+	GHashTable *cache;
+	guint cache_generation;
+	guint cache_hits;
+	guint cache_misses;
 #endif
 } NMAuthManagerPrivate;
 
@@ -111,8 +120,20 @@ typedef struct {
 	gchar *cancellation_id;
 	GVariant *dbus_parameters;
 	GCancellable *cancellable;
+	char *cache_key;
+	guint cache_generation;
 } CheckAuthData;
 
+typedef struct {
+	gboolean is_authorized;
+	gboolean is_challenge;
+} CheckAuthorizationResult;
+
+typedef struct {
+	CheckAuthorizationResult result;
+	gint64 expiry_msec;
+} CacheEntry;
+
 static void
 _check_auth_data_free (CheckAuthData *data)
 {
@@ -122,9 +143,81 @@ _check_auth_data_free (CheckAuthData *data)
 	g_object_unref (data->simple);
 	g_clear_object (&data->cancellable);
 	g_free (data->cancellation_id);
+	g_free (data->cache_key);
 	g_free (data);
 }
 
+/*****************************************************************************/
+
+static void
+_cache_entry_free (gpointer data)
+{
+	g_slice_free (CacheEntry, data);
+}
+
+static void
+_cache_flush (NMAuthManager *self)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	/* in-flight calls started before the flush must not repopulate the cache. */
+	priv->cache_generation++;
+
+	if (priv->cache && g_hash_table_size (priv->cache)) {
+		_LOGD ("flush %u cached authorization results (hits=%u, misses=%u)",
+		       g_hash_table_size (priv->cache), priv->cache_hits, priv->cache_misses);
+		g_hash_table_remove_all (priv->cache);
+	}
+}
+
+static const CheckAuthorizationResult *
+_cache_lookup (NMAuthManager *self, const char *key)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->cache, key);
+	if (!entry)
+		return NULL;
+	if (entry->expiry_msec <= nm_utils_get_monotonic_timestamp_ms ()) {
+		g_hash_table_remove (priv->cache, key);
+		return NULL;
+	}
+	return &entry->result;
+}
+
+static void
+_cache_add (NMAuthManager *self, CheckAuthData *data, const CheckAuthorizationResult *result)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CacheEntry *entry;
+	gint64 now;
+
+	if (   !data->cache_key
+	    || data->cache_generation != priv->cache_generation)
+		return;
+
+	now = nm_utils_get_monotonic_timestamp_ms ();
+
+	if (g_hash_table_size (priv->cache) >= CACHE_PRUNE_SIZE) {
+		GHashTableIter iter;
+
+		g_hash_table_iter_init (&iter, priv->cache);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+			if (entry->expiry_msec <= now)
+				g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	entry = g_slice_new (CacheEntry);
+	entry->result = *result;
+	entry->expiry_msec = now + CACHE_TTL_MSEC;
+	g_hash_table_insert (priv->cache, data->cache_key, entry);
+	data->cache_key = NULL;
+}
+
+/*****************************************************************************/
+
 static void
 _call_check_authorization_complete_with_error (CheckAuthData *data,
                                                const char *error_message)
@@ -163,11 +256,6 @@ cancel_check_authorization_cb (GDBusProxy *proxy,
 	g_object_unref (self);
 }
 
-typedef struct {
-	gboolean is_authorized;
-	gboolean is_challenge;
-} CheckAuthorizationResult;
-
 static void
 check_authorization_cb (GDBusProxy *proxy,
                         GAsyncResult *res,
@@ -215,6 +303,7 @@ check_authorization_cb (GDBusProxy *proxy,
 		g_variant_unref (value);
 
 		_LOGD ("call[%u]: CheckAuthorization succeeded: (is_authorized=%d, is_challenge=%d)", data->call_id, result->is_authorized, result->is_challenge);
+		_cache_add (self, data, result);
 		g_simple_async_result_set_op_res_gpointer (data->simple, result, g_free);
 	}
 
@@ -256,6 +345,7 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 	GVariant *subject_value;
 	GVariant *details_value;
 	CheckAuthData *data;
+	gs_free char *cache_key = NULL;
 
 	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
 	g_return_if_fail (NM_IS_AUTH_SUBJECT (subject));
@@ -267,6 +357,37 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 
 	g_return_if_fail (priv->polkit_enabled);
 
+	/* Only non-interactive checks are cached: an interactive one may involve
+	 * authentication that the policy wants to repeat for every request. */
+	if (!allow_user_interaction) {
+		const CheckAuthorizationResult *cached;
+
+		cache_key = g_strdup_printf ("%s:%s",
+		                             nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)),
+		                             action_id);
+		cached = _cache_lookup (self, cache_key);
+		if (cached) {
+			GSimpleAsyncResult *simple;
+
+			priv->cache_hits++;
+			_LOGD ("call[-]: CheckAuthorization(%s), subject=%s (cached: is_authorized=%d, is_challenge=%d; hits=%u, misses=%u)",
+			       action_id, subject_buf, cached->is_authorized, cached->is_challenge,
+			       priv->cache_hits, priv->cache_misses);
+
+			simple = g_simple_async_result_new (G_OBJECT (self),
+			                                    callback,
+			                                    user_data,
+			                                    nm_auth_manager_polkit_authority_check_authorization);
+			g_simple_async_result_set_op_res_gpointer (simple,
+			                                           g_memdup (cached, sizeof (*cached)),
+			                                           g_free);
+			g_simple_async_result_complete_in_idle (simple);
+			g_object_unref (simple);
+			return;
+		}
+		priv->cache_misses++;
+	}
+
 	flags = allow_user_interaction
 	    ? POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION
 	    : POLKIT_CHECK_AUTHORIZATION_FLAGS_NONE;
@@ -289,6 +410,8 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 		data->cancellation_id = g_strdup_printf ("cancellation-id-%u", data->call_id);
 		data->cancellable = g_object_ref (cancellable);
 	}
+	data->cache_key = g_steal_pointer (&cache_key);
+	data->cache_generation = priv->cache_generation;
 
 	data->dbus_parameters = g_variant_new ("(@(sa{sv})s@a{ss}us)",
 	                                       subject_value,
@@ -387,6 +510,7 @@ _dbus_on_name_owner_notify_cb (GObject    *object,
 	if (!name_owner) {
 		/* when the name disappears, we also want to raise a emit signal.
 		 * When it appears, we raise one already. */
+		_cache_flush (self);
 		_emit_changed_signal (self);
 	}
 
@@ -403,6 +527,7 @@ _dbus_on_changed_signal_cb (GDBusProxy *proxy,
 	g_return_if_fail (priv->proxy == proxy);
 
 	_LOGD ("dbus signal: \"Changed\"");
+	_cache_flush (self);
 	_emit_changed_signal (self);
 }
 
@@ -523,6 +648,11 @@ set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *p
 static void
 nm_auth_manager_init (NMAuthManager *self)
 {
+#if WITH_POLKIT
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	priv->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _cache_entry_free);
+#endif
 }
 
 static void
@@ -601,6 +731,8 @@ dispose (GObject *object)
 		g_signal_handlers_disconnect_by_data (priv->proxy, self);
 		g_clear_object (&priv->proxy);
 	}
+
+	g_clear_pointer (&priv->cache, g_hash_table_unref);
 #endif
 
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->dispose (object);
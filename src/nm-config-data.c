@@ -40,10 +40,34 @@ typedef struct {
 		 * value %NULL does not necessarily mean, that the property
 		 * "match-device" was unspecified. */
 		gboolean has;
-		GSList *spec;
+		NMMatchSpecCompiled *spec;
 	} match_device;
+
+	/* index into MatchCacheEntry.results */
+	guint cache_idx;
 } MatchSectionInfo;
 
+typedef enum {
+	MATCH_CACHE_UNKNOWN = 0,
+	MATCH_CACHE_MATCH,
+	MATCH_CACHE_NO_MATCH,
+} MatchCacheResult;
+
+/* The match-device results of all [connection*] and [device*] sections
+ * for one device. They stay valid as long as the device properties that
+ * can be matched against don't change. */
+typedef struct {
+	NMConfigData *self;
+	NMDevice *device;
+	char *interface_name;
+	char *device_type;
+	char *driver;
+	char *driver_version;
+	char *hwaddr;
+	char *s390_subchannels;
+	guint8 *results;
+} MatchCacheEntry;
+
 struct _NMGlobalDnsDomain {
 	char *name;
 	char **servers;
@@ -87,6 +111,10 @@ typedef struct {
 	 * [device] sections. This is to speed up lookup. */
 	MatchSectionInfo *device_infos;
 
+	/* NMDevice -> MatchCacheEntry */
+	GHashTable *match_cache;
+	guint n_match_sections;
+
 	struct {
 		char *uri;
 		char *response;
@@ -97,10 +125,12 @@ typedef struct {
 		char **arr;
 		GSList *specs;
 		GSList *specs_config;
+		NMMatchSpecCompiled *specs_compiled;
+		NMMatchSpecCompiled *specs_config_compiled;
 	} no_auto_default;
 
-	GSList *ignore_carrier;
-	GSList *assume_ipv6ll_only;
+	NMMatchSpecCompiled *ignore_carrier;
+	NMMatchSpecCompiled *assume_ipv6ll_only;
 
 	char *dns_mode;
 	char *rc_manager;
@@ -279,8 +309,8 @@ nm_config_data_get_no_auto_default_for_device (const NMConfigData *self, NMDevic
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
-	return    nm_device_spec_match_list (device, priv->no_auto_default.specs)
-	       || nm_device_spec_match_list (device, priv->no_auto_default.specs_config);
+	return    nm_device_spec_match_compiled (device, priv->no_auto_default.specs_compiled)
+	       || nm_device_spec_match_compiled (device, priv->no_auto_default.specs_config_compiled);
 }
 
 const char *
@@ -312,7 +342,7 @@ nm_config_data_get_ignore_carrier (const NMConfigData *self, NMDevice *device)
 	if (has_match)
 		return nm_config_parse_boolean (value, FALSE);
 
-	return nm_device_spec_match_list (device, NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier);
+	return nm_device_spec_match_compiled (device, NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier);
 }
 
 gboolean
@@ -321,7 +351,7 @@ nm_config_data_get_assume_ipv6ll_only (const NMConfigData *self, NMDevice *devic
 	g_return_val_if_fail (NM_IS_CONFIG_DATA (self), FALSE);
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
-	return nm_device_spec_match_list (device, NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only);
+	return nm_device_spec_match_compiled (device, NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only);
 }
 
 GKeyFile *
@@ -1161,13 +1191,126 @@ global_dns_equal (NMGlobalDnsConfig *old, NMGlobalDnsConfig *new)
 
 /*****************************************************************************/
 
+static void
+_match_cache_entry_clear_identity (MatchCacheEntry *entry)
+{
+	g_free (entry->interface_name);
+	g_free (entry->device_type);
+	g_free (entry->driver);
+	g_free (entry->driver_version);
+	g_free (entry->hwaddr);
+	g_free (entry->s390_subchannels);
+}
+
+static void
+_match_cache_entry_free (gpointer data)
+{
+	MatchCacheEntry *entry = data;
+
+	_match_cache_entry_clear_identity (entry);
+	g_free (entry->results);
+	g_slice_free (MatchCacheEntry, entry);
+}
+
+static void
+_match_cache_device_finalized (gpointer data, GObject *where_the_object_was)
+{
+	MatchCacheEntry *entry = data;
+	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (entry->self);
+
+	g_hash_table_remove (priv->match_cache, where_the_object_was);
+}
+
+static void
+_match_cache_clear (NMConfigData *self)
+{
+	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+	GHashTableIter iter;
+	MatchCacheEntry *entry;
+
+	if (!priv->match_cache)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->match_cache);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+		g_object_weak_unref (G_OBJECT (entry->device), _match_cache_device_finalized, entry);
+	g_clear_pointer (&priv->match_cache, g_hash_table_unref);
+}
+
+static MatchCacheEntry *
+_match_cache_get (const NMConfigData *self, NMDevice *device)
+{
+	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+	MatchCacheEntry *entry;
+	const char *interface_name = nm_device_get_iface (device);
+	const char *device_type = nm_device_get_type_description (device);
+	const char *driver = nm_device_get_driver (device);
+	const char *driver_version = nm_device_get_driver_version (device);
+	const char *hwaddr = nm_device_get_permanent_hw_address (device);
+	const char *s390_subchannels = nm_device_get_s390_subchannels (device);
+
+	if (G_UNLIKELY (!priv->match_cache))
+		priv->match_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, _match_cache_entry_free);
+
+	entry = g_hash_table_lookup (priv->match_cache, device);
+	if (!entry) {
+		entry = g_slice_new0 (MatchCacheEntry);
+		entry->self = (NMConfigData *) self;
+		entry->device = device;
+		entry->results = g_new0 (guint8, priv->n_match_sections);
+		g_object_weak_ref (G_OBJECT (device), _match_cache_device_finalized, entry);
+		g_hash_table_insert (priv->match_cache, device, entry);
+	} else if (   nm_streq0 (entry->interface_name, interface_name)
+	           && nm_streq0 (entry->device_type, device_type)
+	           && nm_streq0 (entry->driver, driver)
+	           && nm_streq0 (entry->driver_version, driver_version)
+	           && nm_streq0 (entry->hwaddr, hwaddr)
+	           && nm_streq0 (entry->s390_subchannels, s390_subchannels))
+		return entry;
+	else {
+		_match_cache_entry_clear_identity (entry);
+		memset (entry->results, 0, priv->n_match_sections);
+	}
+
+	entry->interface_name = g_strdup (interface_name);
+	entry->device_type = g_strdup (device_type);
+	entry->driver = g_strdup (driver);
+	entry->driver_version = g_strdup (driver_version);
+	entry->hwaddr = g_strdup (hwaddr);
+	entry->s390_subchannels = g_strdup (s390_subchannels);
+	return entry;
+}
+
+static gboolean
+_match_section_info_match_device (const NMConfigData *self,
+                                  const MatchSectionInfo *match_section_info,
+                                  NMDevice *device,
+                                  MatchCacheEntry **p_cache_entry)
+{
+	MatchCacheEntry *entry;
+	gboolean match;
+
+	if (!*p_cache_entry)
+		*p_cache_entry = _match_cache_get (self, device);
+	entry = *p_cache_entry;
+
+	if (entry->results[match_section_info->cache_idx] == MATCH_CACHE_UNKNOWN) {
+		match = nm_device_spec_match_compiled (device, match_section_info->match_device.spec);
+		entry->results[match_section_info->cache_idx] = match ? MATCH_CACHE_MATCH : MATCH_CACHE_NO_MATCH;
+	}
+	return entry->results[match_section_info->cache_idx] == MATCH_CACHE_MATCH;
+}
+
 static const MatchSectionInfo *
-_match_section_infos_lookup (const MatchSectionInfo *match_section_infos,
+_match_section_infos_lookup (const NMConfigData *self,
+                             const MatchSectionInfo *match_section_infos,
                              GKeyFile *keyfile,
                              const char *property,
                              NMDevice *device,
                              char **out_value)
 {
+	MatchCacheEntry *cache_entry = NULL;
+
 	if (!match_section_infos)
 		return NULL;
 
@@ -1188,7 +1331,7 @@ _match_section_infos_lookup (const MatchSectionInfo *match_section_infos,
 
 		match = TRUE;
 		if (match_section_infos->match_device.has)
-			match = device && nm_device_spec_match_list (device, match_section_infos->match_device.spec);
+			match = device && _match_section_info_match_device (self, match_section_infos, device, &cache_entry);
 
 		if (match) {
 			*out_value = value;
@@ -1214,7 +1357,8 @@ nm_config_data_get_device_config (const NMConfigData *self,
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
 
-	connection_info = _match_section_infos_lookup (&priv->device_infos[0],
+	connection_info = _match_section_infos_lookup (self,
+	                                               &priv->device_infos[0],
 	                                               priv->keyfile,
 	                                               property,
 	                                               device,
@@ -1253,7 +1397,8 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
 
-	_match_section_infos_lookup (&priv->connection_infos[0],
+	_match_section_infos_lookup (self,
+	                             &priv->connection_infos[0],
 	                             priv->keyfile,
 	                             property,
 	                             device,
@@ -1262,16 +1407,22 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 }
 
 static void
-_get_connection_info_init (MatchSectionInfo *connection_info, GKeyFile *keyfile, char *group)
+_get_connection_info_init (MatchSectionInfo *connection_info, GKeyFile *keyfile, char *group, guint *cache_idx)
 {
+	GSList *spec;
+
 	/* pass ownership of @group on... */
 	connection_info->group_name = group;
 
-	connection_info->match_device.spec = nm_config_get_match_spec (keyfile,
-	                                                               group,
-	                                                               "match-device",
-	                                                               &connection_info->match_device.has);
+	spec = nm_config_get_match_spec (keyfile,
+	                                 group,
+	                                 "match-device",
+	                                 &connection_info->match_device.has);
+	if (connection_info->match_device.has)
+		connection_info->match_device.spec = nm_match_spec_compile (spec);
+	g_slist_free_full (spec, g_free);
 	connection_info->stop_match = nm_config_keyfile_get_boolean (keyfile, group, "stop-match", FALSE);
+	connection_info->cache_idx = (*cache_idx)++;
 }
 
 static void
@@ -1283,13 +1434,13 @@ _match_section_infos_free (MatchSectionInfo *match_section_infos)
 		return;
 	for (i = 0; match_section_infos[i].group_name; i++) {
 		g_free (match_section_infos[i].group_name);
-		g_slist_free_full (match_section_infos[i].match_device.spec, g_free);
+		nm_match_spec_compiled_free (match_section_infos[i].match_device.spec);
 	}
 	g_free (match_section_infos);
 }
 
 static MatchSectionInfo *
-_match_section_infos_construct (GKeyFile *keyfile, const char *prefix)
+_match_section_infos_construct (GKeyFile *keyfile, const char *prefix, guint *cache_idx)
 {
 	char **groups;
 	gsize i, j, ngroups;
@@ -1328,11 +1479,11 @@ _match_section_infos_construct (GKeyFile *keyfile, const char *prefix)
 	match_section_infos = g_new0 (MatchSectionInfo, ngroups + 1 + (connection_tag ? 1 : 0));
 	for (i = 0; i < ngroups; i++) {
 		/* pass ownership of @group on... */
-		_get_connection_info_init (&match_section_infos[i], keyfile, groups[ngroups - i - 1]);
+		_get_connection_info_init (&match_section_infos[i], keyfile, groups[ngroups - i - 1], cache_idx);
 	}
 	if (connection_tag) {
 		/* pass ownership of @connection_tag on... */
-		_get_connection_info_init (&match_section_infos[i], keyfile, connection_tag);
+		_get_connection_info_init (&match_section_infos[i], keyfile, connection_tag, cache_idx);
 	}
 	g_free (groups);
 
@@ -1493,6 +1644,18 @@ set_property (GObject *object,
 
 /*****************************************************************************/
 
+static NMMatchSpecCompiled *
+_match_spec_compile_from_keyfile (GKeyFile *keyfile, const char *group, const char *key)
+{
+	NMMatchSpecCompiled *compiled;
+	GSList *specs;
+
+	specs = nm_config_get_match_spec (keyfile, group, key, NULL);
+	compiled = nm_match_spec_compile (specs);
+	g_slist_free_full (specs, g_free);
+	return compiled;
+}
+
 static void
 nm_config_data_init (NMConfigData *self)
 {
@@ -1507,8 +1670,8 @@ constructed (GObject *object)
 
 	priv->keyfile = _merge_keyfiles (priv->keyfile_user, priv->keyfile_intern);
 
-	priv->connection_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_CONNECTION);
-	priv->device_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_DEVICE);
+	priv->connection_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_CONNECTION, &priv->n_match_sections);
+	priv->device_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_DEVICE, &priv->n_match_sections);
 
 	priv->connectivity.uri = nm_strstrip (g_key_file_get_string (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_CONNECTIVITY, "uri", NULL));
 	priv->connectivity.response = g_key_file_get_string (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_CONNECTIVITY, "response", NULL);
@@ -1524,10 +1687,12 @@ constructed (GObject *object)
 	priv->dns_mode = nm_strstrip (g_key_file_get_string (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "dns", NULL));
 	priv->rc_manager = nm_strstrip (g_key_file_get_string (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "rc-manager", NULL));
 
-	priv->ignore_carrier = nm_config_get_match_spec (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "ignore-carrier", NULL);
-	priv->assume_ipv6ll_only = nm_config_get_match_spec (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "assume-ipv6ll-only", NULL);
+	priv->ignore_carrier = _match_spec_compile_from_keyfile (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "ignore-carrier");
+	priv->assume_ipv6ll_only = _match_spec_compile_from_keyfile (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "assume-ipv6ll-only");
 
 	priv->no_auto_default.specs_config = nm_config_get_match_spec (priv->keyfile, NM_CONFIG_KEYFILE_GROUP_MAIN, "no-auto-default", NULL);
+	priv->no_auto_default.specs_compiled = nm_match_spec_compile (priv->no_auto_default.specs);
+	priv->no_auto_default.specs_config_compiled = nm_match_spec_compile (priv->no_auto_default.specs_config);
 
 	priv->global_dns = load_global_dns (priv->keyfile_user, FALSE);
 	if (!priv->global_dns)
@@ -1599,11 +1764,15 @@ finalize (GObject *gobject)
 	g_free (priv->dns_mode);
 	g_free (priv->rc_manager);
 
-	g_slist_free_full (priv->ignore_carrier, g_free);
-	g_slist_free_full (priv->assume_ipv6ll_only, g_free);
+	nm_match_spec_compiled_free (priv->no_auto_default.specs_compiled);
+	nm_match_spec_compiled_free (priv->no_auto_default.specs_config_compiled);
+
+	nm_match_spec_compiled_free (priv->ignore_carrier);
+	nm_match_spec_compiled_free (priv->assume_ipv6ll_only);
 
 	nm_global_dns_config_free (priv->global_dns);
 
+	_match_cache_clear ((NMConfigData *) gobject);
 	_match_section_infos_free (priv->connection_infos);
 	_match_section_infos_free (priv->device_infos);
 
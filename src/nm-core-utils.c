@@ -1304,11 +1304,8 @@ match_device_s390_subchannels_parse (const char *s390_subchannels, guint32 *out_
 }
 
 static gboolean
-match_data_s390_subchannels_eval (const char *spec_str,
-                                  MatchDeviceData *match_data)
+match_data_s390_subchannels_parse (MatchDeviceData *match_data)
 {
-	guint32 a, b, c;
-
 	if (G_UNLIKELY (!match_data->s390_subchannels.is_parsed)) {
 		match_data->s390_subchannels.is_parsed = TRUE;
 
@@ -1322,6 +1319,17 @@ match_data_s390_subchannels_eval (const char *spec_str,
 		}
 	} else if (!match_data->s390_subchannels.value)
 		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+match_data_s390_subchannels_eval (const char *spec_str,
+                                  MatchDeviceData *match_data)
+{
+	guint32 a, b, c;
+
+	if (!match_data_s390_subchannels_parse (match_data))
+		return FALSE;
 
 	if (!match_device_s390_subchannels_parse (spec_str, &a, &b, &c))
 		return FALSE;
@@ -1331,8 +1339,7 @@ match_data_s390_subchannels_eval (const char *spec_str,
 }
 
 static gboolean
-match_device_hwaddr_eval (const char *spec_str,
-                          MatchDeviceData *match_data)
+match_data_hwaddr_parse (MatchDeviceData *match_data)
 {
 	if (G_UNLIKELY (!match_data->hwaddr.is_parsed)) {
 		match_data->hwaddr.is_parsed = TRUE;
@@ -1347,6 +1354,15 @@ match_device_hwaddr_eval (const char *spec_str,
 			return FALSE;
 	} else if (!match_data->hwaddr.len)
 		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+match_device_hwaddr_eval (const char *spec_str,
+                          MatchDeviceData *match_data)
+{
+	if (!match_data_hwaddr_parse (match_data))
+		return FALSE;
 
 	return nm_utils_hwaddr_matches (spec_str, -1, match_data->hwaddr.bin, match_data->hwaddr.len);
 }
@@ -1525,6 +1541,459 @@ nm_match_spec_device (const GSList *specs,
 	return match;
 }
 
+/*****************************************************************************/
+
+typedef enum {
+	MATCH_COMPILED_TYPE_ALL,
+	MATCH_COMPILED_TYPE_DEVICE_TYPE,
+	MATCH_COMPILED_TYPE_HWADDR,
+	MATCH_COMPILED_TYPE_INTERFACE_NAME,
+	MATCH_COMPILED_TYPE_DRIVER,
+	MATCH_COMPILED_TYPE_S390_SUBCHANNELS,
+	MATCH_COMPILED_TYPE_FUZZY,
+} MatchCompiledType;
+
+typedef struct {
+	MatchCompiledType type;
+	char *str;
+
+	/* INTERFACE_NAME: the glob, unless the spec requested an exact match.
+	 * DRIVER: the glob for the driver version, if any. */
+	GPatternSpec *pattern;
+
+	/* DRIVER: length of the driver part before the last '/'. */
+	gsize driver_len;
+
+	/* HWADDR, and FUZZY if @str is a valid hardware address. */
+	guint hwaddr_len;
+	guint8 hwaddr[NM_UTILS_HWADDR_LEN_MAX];
+
+	guint32 s390_subchannels[3];
+} MatchCompiledSpec;
+
+/* The specs of one kind (either "except:" or not), indexed so that the
+ * cost of a lookup does not grow with the number of exact-match specs. */
+typedef struct {
+	gboolean all;
+
+	/* exact interface names. */
+	GHashTable *interface_names;
+
+	/* interface name globs, keyed by their literal prefix up to the first
+	 * wildcard. Values are a GSList of GPatternSpec. */
+	GHashTable *interface_patterns;
+
+	/* see _match_hwaddr_key(). */
+	GHashTable *hwaddrs;
+
+	GHashTable *device_types;
+
+	/* drivers without version glob. */
+	GHashTable *drivers;
+
+	/* everything else is evaluated one by one. */
+	GArray *specs;
+} MatchIndex;
+
+struct _NMMatchSpecCompiled {
+	MatchIndex except;
+	MatchIndex normal;
+};
+
+static gboolean
+match_compiled_spec_init (MatchCompiledSpec *spec, const char *spec_str, gboolean except)
+{
+	gsize l;
+
+	memset (spec, 0, sizeof (*spec));
+
+	if (spec_str[0] == '*' && spec_str[1] == '\0') {
+		spec->type = MATCH_COMPILED_TYPE_ALL;
+		return TRUE;
+	}
+
+	if (_MATCH_CHECK (spec_str, DEVICE_TYPE_TAG)) {
+		spec->type = MATCH_COMPILED_TYPE_DEVICE_TYPE;
+		spec->str = g_strdup (spec_str);
+		return TRUE;
+	}
+
+	if (_MATCH_CHECK (spec_str, MAC_TAG)) {
+		if (!_nm_utils_hwaddr_aton (spec_str, spec->hwaddr, sizeof (spec->hwaddr), &l))
+			return FALSE;
+		spec->type = MATCH_COMPILED_TYPE_HWADDR;
+		spec->hwaddr_len = l;
+		return TRUE;
+	}
+
+	if (_MATCH_CHECK (spec_str, INTERFACE_NAME_TAG)) {
+		spec->type = MATCH_COMPILED_TYPE_INTERFACE_NAME;
+		if (spec_str[0] == '=')
+			spec->str = g_strdup (&spec_str[1]);
+		else {
+			if (spec_str[0] == '~')
+				spec_str += 1;
+			spec->str = g_strdup (spec_str);
+			spec->pattern = g_pattern_spec_new (spec_str);
+		}
+		return TRUE;
+	}
+
+	if (_MATCH_CHECK (spec_str, DRIVER_TAG)) {
+		const char *t;
+
+		spec->type = MATCH_COMPILED_TYPE_DRIVER;
+		spec->str = g_strdup (spec_str);
+		t = strrchr (spec_str, '/');
+		if (t) {
+			spec->driver_len = t - spec_str;
+			spec->pattern = g_pattern_spec_new (&t[1]);
+		}
+		return TRUE;
+	}
+
+	if (_MATCH_CHECK (spec_str, SUBCHAN_TAG)) {
+		if (!match_device_s390_subchannels_parse (spec_str,
+		                                          &spec->s390_subchannels[0],
+		                                          &spec->s390_subchannels[1],
+		                                          &spec->s390_subchannels[2]))
+			return FALSE;
+		spec->type = MATCH_COMPILED_TYPE_S390_SUBCHANNELS;
+		return TRUE;
+	}
+
+	/* untagged specs only match for non-except entries. */
+	if (except)
+		return FALSE;
+
+	spec->type = MATCH_COMPILED_TYPE_FUZZY;
+	spec->str = g_strdup (spec_str);
+	if (_nm_utils_hwaddr_aton (spec_str, spec->hwaddr, sizeof (spec->hwaddr), &l))
+		spec->hwaddr_len = l;
+	return TRUE;
+}
+
+static void
+_match_compiled_spec_clear (MatchCompiledSpec *spec)
+{
+	g_free (spec->str);
+	if (spec->pattern)
+		g_pattern_spec_free (spec->pattern);
+}
+
+static void
+_match_patterns_free (gpointer data)
+{
+	g_slist_free_full (data, (GDestroyNotify) g_pattern_spec_free);
+}
+
+/* Hardware addresses are compared like nm_utils_hwaddr_matches() does:
+ * of InfiniBand addresses only the last 8 bytes are significant. */
+static const char *
+_match_hwaddr_key (const guint8 *hwaddr, guint len, char *buf, gsize buf_len)
+{
+	if (len == INFINIBAND_ALEN) {
+		buf[0] = 'i';
+		nm_utils_hwaddr_ntoa_buf (&hwaddr[INFINIBAND_ALEN - 8], 8, FALSE, &buf[1], buf_len - 1);
+	} else {
+		buf[0] = 'e';
+		nm_utils_hwaddr_ntoa_buf (hwaddr, len, FALSE, &buf[1], buf_len - 1);
+	}
+	return buf;
+}
+
+#define MATCH_HWADDR_KEY_LEN (1 + NM_UTILS_HWADDR_LEN_MAX * 3)
+
+static void
+_match_index_add_string (GHashTable **p_table, char *str)
+{
+	if (!*p_table)
+		*p_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_add (*p_table, str);
+}
+
+static void
+_match_index_add_hwaddr (MatchIndex *idx, const guint8 *hwaddr, guint len)
+{
+	char buf[MATCH_HWADDR_KEY_LEN];
+
+	_match_index_add_string (&idx->hwaddrs,
+	                         g_strdup (_match_hwaddr_key (hwaddr, len, buf, sizeof (buf))));
+}
+
+static void
+_match_index_add (MatchIndex *idx, MatchCompiledSpec *spec)
+{
+	switch (spec->type) {
+	case MATCH_COMPILED_TYPE_ALL:
+		idx->all = TRUE;
+		break;
+	case MATCH_COMPILED_TYPE_DEVICE_TYPE:
+		_match_index_add_string (&idx->device_types, g_steal_pointer (&spec->str));
+		break;
+	case MATCH_COMPILED_TYPE_HWADDR:
+		_match_index_add_hwaddr (idx, spec->hwaddr, spec->hwaddr_len);
+		break;
+	case MATCH_COMPILED_TYPE_INTERFACE_NAME: {
+		gsize prefix_len;
+		GSList *list;
+		char *prefix;
+
+		prefix_len = strcspn (spec->str, "*?");
+		if (!spec->pattern || !spec->str[prefix_len]) {
+			/* without wildcards the glob is an exact match. */
+			_match_index_add_string (&idx->interface_names, g_steal_pointer (&spec->str));
+			break;
+		}
+
+		if (!idx->interface_patterns)
+			idx->interface_patterns = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _match_patterns_free);
+		prefix = g_strndup (spec->str, prefix_len);
+		list = g_hash_table_lookup (idx->interface_patterns, prefix);
+		if (list) {
+			/* the list head stays the same, the hash table keeps owning it. */
+			list->next = g_slist_prepend (list->next, g_steal_pointer (&spec->pattern));
+			g_free (prefix);
+		} else {
+			g_hash_table_insert (idx->interface_patterns, prefix,
+			                     g_slist_prepend (NULL, g_steal_pointer (&spec->pattern)));
+		}
+		break;
+	}
+	case MATCH_COMPILED_TYPE_DRIVER:
+		if (!spec->pattern) {
+			_match_index_add_string (&idx->drivers, g_steal_pointer (&spec->str));
+			break;
+		}
+		goto linear;
+	case MATCH_COMPILED_TYPE_FUZZY:
+		if (spec->hwaddr_len)
+			_match_index_add_hwaddr (idx, spec->hwaddr, spec->hwaddr_len);
+		_match_index_add_string (&idx->interface_names, g_steal_pointer (&spec->str));
+		break;
+	case MATCH_COMPILED_TYPE_S390_SUBCHANNELS:
+		goto linear;
+	}
+
+	_match_compiled_spec_clear (spec);
+	return;
+
+linear:
+	if (!idx->specs)
+		idx->specs = g_array_new (FALSE, FALSE, sizeof (MatchCompiledSpec));
+	g_array_append_val (idx->specs, *spec);
+}
+
+static void
+_match_index_clear (MatchIndex *idx)
+{
+	guint i;
+
+	if (idx->interface_names)
+		g_hash_table_unref (idx->interface_names);
+	if (idx->interface_patterns)
+		g_hash_table_unref (idx->interface_patterns);
+	if (idx->hwaddrs)
+		g_hash_table_unref (idx->hwaddrs);
+	if (idx->device_types)
+		g_hash_table_unref (idx->device_types);
+	if (idx->drivers)
+		g_hash_table_unref (idx->drivers);
+	if (idx->specs) {
+		for (i = 0; i < idx->specs->len; i++)
+			_match_compiled_spec_clear (&g_array_index (idx->specs, MatchCompiledSpec, i));
+		g_array_free (idx->specs, TRUE);
+	}
+}
+
+/**
+ * nm_match_spec_compile:
+ * @specs: a list of device match specs
+ *
+ * Parses @specs once, so that they can be evaluated repeatedly with
+ * nm_match_spec_compiled_match_device(). That gives the same result as
+ * nm_match_spec_device() on @specs, without re-parsing tags, hardware
+ * addresses and globs for every device.
+ *
+ * Exact interface names, hardware addresses, device types and drivers
+ * are put in hash tables and interface name globs are indexed by their
+ * literal prefix, so evaluating a device costs about the same regardless
+ * of the number of specs.
+ *
+ * Returns: (transfer full): the compiled specs. Free with
+ *   nm_match_spec_compiled_free().
+ */
+NMMatchSpecCompiled *
+nm_match_spec_compile (const GSList *specs)
+{
+	NMMatchSpecCompiled *compiled;
+	const GSList *iter;
+
+	compiled = g_slice_new0 (NMMatchSpecCompiled);
+
+	for (iter = specs; iter; iter = iter->next) {
+		const char *spec_str = iter->data;
+		MatchCompiledSpec spec;
+		gboolean except;
+
+		if (!spec_str || !*spec_str)
+			continue;
+
+		spec_str = match_except (spec_str, &except);
+		if (!match_compiled_spec_init (&spec, spec_str, except))
+			continue;
+
+		_match_index_add (except ? &compiled->except : &compiled->normal, &spec);
+	}
+
+	return compiled;
+}
+
+void
+nm_match_spec_compiled_free (NMMatchSpecCompiled *compiled)
+{
+	if (!compiled)
+		return;
+
+	_match_index_clear (&compiled->except);
+	_match_index_clear (&compiled->normal);
+	g_slice_free (NMMatchSpecCompiled, compiled);
+}
+
+static gboolean
+match_compiled_eval (const MatchCompiledSpec *spec,
+                     MatchDeviceData *match_data)
+{
+	switch (spec->type) {
+	case MATCH_COMPILED_TYPE_DRIVER:
+		if (!match_data->driver)
+			return FALSE;
+		return    strncmp (spec->str, match_data->driver, spec->driver_len) == 0
+		       && g_pattern_match_string (spec->pattern,
+		                                  match_data->driver_version ?: "");
+	case MATCH_COMPILED_TYPE_S390_SUBCHANNELS:
+		return    match_data_s390_subchannels_parse (match_data)
+		       && match_data->s390_subchannels.a == spec->s390_subchannels[0]
+		       && match_data->s390_subchannels.b == spec->s390_subchannels[1]
+		       && match_data->s390_subchannels.c == spec->s390_subchannels[2];
+	default:
+		break;
+	}
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+match_index_interface_patterns_eval (GHashTable *patterns, const char *interface_name)
+{
+	char buf_stack[64];
+	gs_free char *buf_heap = NULL;
+	char *buf;
+	gsize len;
+	GSList *iter;
+
+	len = strlen (interface_name);
+	if (len < sizeof (buf_stack))
+		buf = memcpy (buf_stack, interface_name, len + 1);
+	else
+		buf = buf_heap = g_strdup (interface_name);
+
+	/* look up every prefix of the name, from the longest to the empty one. */
+	for (;;) {
+		buf[len] = '\0';
+		for (iter = g_hash_table_lookup (patterns, buf); iter; iter = iter->next) {
+			if (g_pattern_match_string (iter->data, interface_name))
+				return TRUE;
+		}
+		if (len == 0)
+			return FALSE;
+		len--;
+	}
+}
+
+static gboolean
+match_index_eval (const MatchIndex *idx, MatchDeviceData *match_data)
+{
+	guint i;
+
+	if (idx->all)
+		return TRUE;
+
+	if (match_data->interface_name) {
+		if (   idx->interface_names
+		    && g_hash_table_contains (idx->interface_names, match_data->interface_name))
+			return TRUE;
+		if (   idx->interface_patterns
+		    && match_index_interface_patterns_eval (idx->interface_patterns, match_data->interface_name))
+			return TRUE;
+	}
+
+	if (   idx->hwaddrs
+	    && match_data_hwaddr_parse (match_data)) {
+		char buf[MATCH_HWADDR_KEY_LEN];
+
+		if (g_hash_table_contains (idx->hwaddrs,
+		                           _match_hwaddr_key (match_data->hwaddr.bin, match_data->hwaddr.len,
+		                                              buf, sizeof (buf))))
+			return TRUE;
+	}
+
+	if (   idx->device_types
+	    && match_data->device_type
+	    && g_hash_table_contains (idx->device_types, match_data->device_type))
+		return TRUE;
+
+	if (   idx->drivers
+	    && match_data->driver
+	    && g_hash_table_contains (idx->drivers, match_data->driver))
+		return TRUE;
+
+	if (idx->specs) {
+		for (i = 0; i < idx->specs->len; i++) {
+			if (match_compiled_eval (&g_array_index (idx->specs, MatchCompiledSpec, i), match_data))
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+NMMatchSpecMatchType
+nm_match_spec_compiled_match_device (const NMMatchSpecCompiled *compiled,
+                                     const char *interface_name,
+                                     const char *device_type,
+                                     const char *driver,
+                                     const char *driver_version,
+                                     const char *hwaddr,
+                                     const char *s390_subchannels)
+{
+	MatchDeviceData match_data = {
+	    .interface_name = interface_name,
+	    .device_type = nm_str_not_empty (device_type),
+	    .driver = nm_str_not_empty (driver),
+	    .driver_version = nm_str_not_empty (driver_version),
+	    .hwaddr = {
+	        .value = hwaddr,
+	    },
+	    .s390_subchannels = {
+	        .value = s390_subchannels,
+	    },
+	};
+
+	nm_assert (!hwaddr || nm_utils_hwaddr_valid (hwaddr, -1));
+
+	if (!compiled)
+		return NM_MATCH_SPEC_NO_MATCH;
+
+	/* any matching "except:" spec wins. */
+	if (match_index_eval (&compiled->except, &match_data))
+		return NM_MATCH_SPEC_NEG_MATCH;
+	if (match_index_eval (&compiled->normal, &match_data))
+		return NM_MATCH_SPEC_MATCH;
+	return NM_MATCH_SPEC_NO_MATCH;
+}
+
+/*****************************************************************************/
+
 static gboolean
 match_config_eval (const char *str, const char *tag, guint cur_nm_version)
 {
@@ -149,6 +149,17 @@ NMMatchSpecMatchType nm_match_spec_device (const GSList *specs,
                                            const char *device_type,
                                            const char *hwaddr,
                                            const char *s390_subchannels);
+
+NMMatchSpecCompiled *nm_match_spec_compile (const GSList *specs);
+void nm_match_spec_compiled_free (NMMatchSpecCompiled *compiled);
+NMMatchSpecMatchType nm_match_spec_compiled_match_device (const NMMatchSpecCompiled *compiled,
+                                                          const char *interface_name,
+                                                          const char *device_type,
+                                                          const char *driver,
+                                                          const char *driver_version,
+                                                          const char *hwaddr,
+                                                          const char *s390_subchannels);
+
 NMMatchSpecMatchType nm_match_spec_config (const GSList *specs,
                                            guint nm_version,
                                            const char *env);
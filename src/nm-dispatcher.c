@@ -41,6 +41,7 @@
 #include "settings/nm-settings-connection.h"
 #include "platform/nm-platform.h"
 #include "nm-core-internal.h"
+#include "nm-perf-counters.h"
 
 #define CALL_TIMEOUT (1000 * 60 * 10)  /* 10 minutes for all scripts */
 
@@ -616,6 +617,8 @@ _dispatcher_call (NMDispatcherAction action,
 	if (!device_dhcp6_props)
 		device_dhcp6_props = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0));
 
+	nm_perf_counter_inc (NM_PERF_COUNTER_DISPATCHER_RUNS);
+
 	/* Send the action to the dispatcher */
 	if (blocking) {
 		GVariant *ret;
@@ -29,6 +29,7 @@
 
 #include "devices/nm-device.h"
 #include "nm-active-connection.h"
+#include "nm-perf-counters.h"
 #include "introspection/org.freedesktop.NetworkManager.Device.Statistics.h"
 
 #if NM_MORE_ASSERTS >= 2
@@ -197,6 +198,7 @@ nm_exported_object_signal_hook (GSignalInvocationHint *ihint,
 	}
 
 	g_signal_emitv (dbus_param_values, signal_info->signal_id, 0, NULL);
+	nm_perf_counter_inc (NM_PERF_COUNTER_DBUS_SIGNALS);
 
 	for (i = 0; i < n_param_values; i++)
 		g_value_unset (&dbus_param_values[i]);
@@ -850,6 +852,7 @@ idle_emit_properties_changed (gpointer self)
 		}
 
 		g_signal_emit (ifdata->interface, ifdata->property_changed_signal_id, 0, variant);
+		nm_perf_counter_inc (NM_PERF_COUNTER_DBUS_SIGNALS);
 
 		g_hash_table_remove_all (ifdata->pending_notifies);
 	}
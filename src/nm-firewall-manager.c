@@ -44,6 +44,10 @@ typedef struct {
 	gboolean        running;
 
 	GHashTable     *pending_calls;
+
+	/* requests that wait to be sent to firewalld, see _queue_flush(). */
+	GQueue          queued_calls;
+	guint           queue_flush_id;
 } NMFirewallManagerPrivate;
 
 struct _NMFirewallManager {
@@ -85,10 +89,9 @@ struct _NMFirewallManagerCallId {
 	NMFirewallManagerAddRemoveCallback callback;
 	gpointer user_data;
 
+	char *zone;
+
 	union {
-		struct {
-			GCancellable *cancellable;
-		} dbus;
 		struct {
 			guint id;
 		} idle;
@@ -96,6 +99,14 @@ struct _NMFirewallManagerCallId {
 };
 typedef struct _NMFirewallManagerCallId CBInfo;
 
+/* one D-Bus call to firewalld, shared by identical requests for the same
+ * interface that were queued in the same main loop iteration. */
+typedef struct {
+	NMFirewallManager *self;
+	CBInfoOpsType ops_type;
+	GSList *infos;
+} CBBatch;
+
 /*****************************************************************************/
 
 static const char *
@@ -150,6 +161,7 @@ static CBInfo *
 _cb_info_create (NMFirewallManager *self,
                  CBInfoOpsType ops_type,
                  const char *iface,
+                 const char *zone,
                  NMFirewallManagerAddRemoveCallback callback,
                  gpointer user_data)
 {
@@ -160,13 +172,13 @@ _cb_info_create (NMFirewallManager *self,
 	info->self = g_object_ref (self);
 	info->ops_type = ops_type;
 	info->iface = g_strdup (iface);
+	info->zone = g_strdup (zone);
 	info->callback = callback;
 	info->user_data = user_data;
 
-	if (priv->running) {
+	if (priv->running)
 		info->mode = CB_INFO_MODE_DBUS;
-		info->dbus.cancellable = g_cancellable_new ();
-	} else
+	else
 		info->mode = CB_INFO_MODE_IDLE;
 
 	if (!nm_g_hash_table_add (priv->pending_calls, info))
@@ -178,9 +190,8 @@ _cb_info_create (NMFirewallManager *self,
 static void
 _cb_info_free (CBInfo *info)
 {
-	if (!_cb_info_is_idle (info))
-		g_object_unref (info->dbus.cancellable);
 	g_free (info->iface);
+	g_free (info->zone);
 	if (info->self)
 		g_object_unref (info->self);
 	g_slice_free (CBInfo, info);
@@ -225,47 +236,137 @@ _handle_idle (gpointer user_data)
 static void
 _handle_dbus (GObject *proxy, GAsyncResult *result, gpointer user_data)
 {
-	NMFirewallManager *self;
-	CBInfo *info = user_data;
+	CBBatch *batch = user_data;
+	NMFirewallManager *self = batch->self;
 	gs_free_error GError *error = NULL;
 	gs_unref_variant GVariant *ret = NULL;
-
-	if (info->mode != CB_INFO_MODE_DBUS) {
-		_cb_info_free (info);
-		return;
-	}
-
-	self = info->self;
+	gboolean non_error = FALSE;
+	GSList *iter;
 
 	ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), result, &error);
 
 	if (error) {
-		const char *non_error = NULL;
-
 		g_dbus_error_strip_remote_error (error);
 
-		switch (info->ops_type) {
+		switch (batch->ops_type) {
 		case CB_INFO_OPS_ADD:
 		case CB_INFO_OPS_CHANGE:
-			non_error = "ZONE_ALREADY_SET";
+			non_error = nm_streq (error->message, "ZONE_ALREADY_SET");
 			break;
 		case CB_INFO_OPS_REMOVE:
-			non_error = "UNKNOWN_INTERFACE";
+			non_error = nm_streq (error->message, "UNKNOWN_INTERFACE");
 			break;
 		}
-		if (!g_strcmp0 (error->message, non_error)) {
-			_LOGD (info, "complete: request failed with a non-error (%s)", error->message);
+	}
+
+	for (iter = batch->infos; iter; iter = iter->next) {
+		CBInfo *info = iter->data;
 
+		if (info->mode != CB_INFO_MODE_DBUS) {
+			_cb_info_free (info);
+			continue;
+		}
+
+		if (!error)
+			_LOGD (info, "complete: success");
+		else if (non_error) {
 			/* The operation failed with an error reason that we don't want
 			 * to propagate. Instead, signal success. */
-			g_clear_error (&error);
-		}
-		else
+			_LOGD (info, "complete: request failed with a non-error (%s)", error->message);
+		} else
 			_LOGW (info, "complete: request failed (%s)", error->message);
-	} else
-		_LOGD (info, "complete: success");
 
-	_cb_info_complete_normal (info, error);
+		_cb_info_complete_normal (info, non_error ? NULL : error);
+	}
+
+	g_slist_free (batch->infos);
+	g_object_unref (batch->self);
+	g_slice_free (CBBatch, batch);
+}
+
+static const char *
+_ops_type_to_dbus_method (CBInfoOpsType ops_type)
+{
+	switch (ops_type) {
+	case CB_INFO_OPS_ADD:    return "addInterface";
+	case CB_INFO_OPS_CHANGE: return "changeZone";
+	case CB_INFO_OPS_REMOVE: return "removeInterface";
+	default: g_return_val_if_reached (NULL);
+	}
+}
+
+/* Requests are not sent right away but collected until the main loop
+ * becomes idle. Then all of them are sent at once, so that their calls
+ * are in flight concurrently. firewalld has no API to handle several
+ * interfaces in one call, but repeated identical requests for the same
+ * interface (like a device reapplying its zone) share one call.
+ * Requests that were cancelled in the meantime are not sent at all. */
+static gboolean
+_queue_flush (gpointer user_data)
+{
+	NMFirewallManager *self = user_data;
+	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *last_batch = NULL;
+	GSList *batches = NULL, *iter;
+	CBInfo *info;
+	guint n_requests = 0;
+
+	priv->queue_flush_id = 0;
+
+	last_batch = g_hash_table_new (g_str_hash, g_str_equal);
+
+	while ((info = g_queue_pop_head (&priv->queued_calls))) {
+		CBBatch *batch;
+
+		if (info->mode != CB_INFO_MODE_DBUS) {
+			/* cancelled before it was sent. */
+			_cb_info_free (info);
+			continue;
+		}
+
+		n_requests++;
+
+		/* only merge into the last request for the interface, so that
+		 * the order of different operations is preserved. */
+		batch = g_hash_table_lookup (last_batch, info->iface);
+		if (   batch
+		    && batch->ops_type == info->ops_type
+		    && nm_streq0 (((CBInfo *) batch->infos->data)->zone, info->zone)) {
+			_LOGD (info, "merged with identical request");
+			batch->infos = g_slist_prepend (batch->infos, info);
+			continue;
+		}
+
+		batch = g_slice_new0 (CBBatch);
+		batch->self = g_object_ref (self);
+		batch->ops_type = info->ops_type;
+		batch->infos = g_slist_prepend (NULL, info);
+		g_hash_table_insert (last_batch, info->iface, batch);
+		batches = g_slist_prepend (batches, batch);
+	}
+
+	batches = g_slist_reverse (batches);
+
+	_LOGD (NULL, "sending %u request(s) in %u call(s)",
+	       n_requests, g_slist_length (batches));
+
+	for (iter = batches; iter; iter = iter->next) {
+		CBBatch *batch = iter->data;
+
+		batch->infos = g_slist_reverse (batch->infos);
+		info = batch->infos->data;
+
+		g_dbus_proxy_call (priv->proxy,
+		                   _ops_type_to_dbus_method (batch->ops_type),
+		                   g_variant_new ("(ss)", info->zone ? info->zone : "", info->iface),
+		                   G_DBUS_CALL_FLAGS_NONE, 10000,
+		                   NULL,
+		                   _handle_dbus,
+		                   batch);
+	}
+	g_slist_free (batches);
+
+	return G_SOURCE_REMOVE;
 }
 
 static NMFirewallManagerCallId
@@ -278,14 +379,13 @@ _start_request (NMFirewallManager *self,
 {
 	NMFirewallManagerPrivate *priv;
 	CBInfo *info;
-	const char *dbus_method;
 
 	g_return_val_if_fail (NM_IS_FIREWALL_MANAGER (self), NULL);
 	g_return_val_if_fail (iface && *iface, NULL);
 
 	priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
 
-	info = _cb_info_create (self, ops_type, iface, callback, user_data);
+	info = _cb_info_create (self, ops_type, iface, zone, callback, user_data);
 
 	_LOGD (info, "firewall zone %s %s:%s%s%s%s",
 	       _ops_type_to_string (info->ops_type),
@@ -294,28 +394,9 @@ _start_request (NMFirewallManager *self,
 	       _cb_info_is_idle (info) ? " (not running, simulate success)" : "");
 
 	if (!_cb_info_is_idle (info)) {
-
-		switch (ops_type) {
-		case CB_INFO_OPS_ADD:
-			dbus_method = "addInterface";
-			break;
-		case CB_INFO_OPS_CHANGE:
-			dbus_method = "changeZone";
-			break;
-		case CB_INFO_OPS_REMOVE:
-			dbus_method = "removeInterface";
-			break;
-		default:
-			g_assert_not_reached ();
-		}
-
-		g_dbus_proxy_call (priv->proxy,
-		                   dbus_method,
-		                   g_variant_new ("(ss)", zone ? zone : "", iface),
-		                   G_DBUS_CALL_FLAGS_NONE, 10000,
-		                   info->dbus.cancellable,
-		                   _handle_dbus,
-		                   info);
+		g_queue_push_tail (&priv->queued_calls, info);
+		if (!priv->queue_flush_id)
+			priv->queue_flush_id = g_idle_add (_queue_flush, self);
 
 		if (!info->callback) {
 			/* if the user did not provide a callback, the call_id is useless.
@@ -397,8 +478,9 @@ nm_firewall_manager_cancel_call (NMFirewallManagerCallId call)
 		g_source_remove (info->idle.id);
 		_cb_info_free (info);
 	} else {
+		/* the info is freed once its call completes, or when the
+		 * queue is flushed if the call was not yet sent. */
 		info->mode = CB_INFO_MODE_DBUS_COMPLETED;
-		g_cancellable_cancel (info->dbus.cancellable);
 		g_clear_object (&info->self);
 	}
 }
@@ -458,6 +540,7 @@ nm_firewall_manager_init (NMFirewallManager * self)
 	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
 
 	priv->pending_calls = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_queue_init (&priv->queued_calls);
 }
 
 static void
@@ -494,6 +577,15 @@ dispose (GObject *object)
 {
 	NMFirewallManager *self = NM_FIREWALL_MANAGER (object);
 	NMFirewallManagerPrivate *priv = NM_FIREWALL_MANAGER_GET_PRIVATE (self);
+	CBInfo *info;
+
+	/* queued requests keep a reference to the manager until they are
+	 * cancelled. Only cancelled ones can be left. */
+	nm_clear_g_source (&priv->queue_flush_id);
+	while ((info = g_queue_pop_head (&priv->queued_calls))) {
+		nm_assert (info->mode == CB_INFO_MODE_DBUS_COMPLETED);
+		_cb_info_free (info);
+	}
 
 	if (priv->pending_calls) {
 		/* as every pending operation takes a reference to the manager,
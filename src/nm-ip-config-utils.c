@@ -0,0 +1,252 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-ip-config-utils.h"
+
+#include <string.h>
+
+#include "platform/nm-platform.h"
+
+/*****************************************************************************/
+
+/* An open addressing hash table of positions in the indexed array. The
+ * entries are not copied: hashing and comparing a bucket dereferences the
+ * array, so positions must stay valid, which is why the index is dropped
+ * whenever entries are removed or reordered. */
+struct _NMIPConfigIdIndex {
+	GHashFunc hash_func;
+	GEqualFunc equal_func;
+
+	/* array position + 1 of the first entry with a given id, or 0 */
+	guint *buckets;
+	guint mask;
+	guint n_entries;
+};
+
+#define ID_INDEX_MIN_BUCKETS 32
+
+static inline gconstpointer
+_id_index_elt (GArray *array, guint pos)
+{
+	return &array->data[pos * g_array_get_element_size (array)];
+}
+
+static inline guint
+_id_index_bucket (const NMIPConfigIdIndex *idx, gconstpointer needle)
+{
+	guint32 h = idx->hash_func (needle);
+
+	/* the id hashes keep addresses in network byte order and vary mostly
+	 * in their high bits. Mix them before masking (murmur3 finalizer). */
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h & idx->mask;
+}
+
+static guint *
+_id_index_find (const NMIPConfigIdIndex *idx, GArray *array, gconstpointer needle)
+{
+	guint i;
+
+	/* linear probing. The table is kept at most half full, so there is
+	 * always an empty bucket to stop at. */
+	for (i = _id_index_bucket (idx, needle); ; i = (i + 1) & idx->mask) {
+		guint pos = idx->buckets[i];
+
+		if (   !pos
+		    || idx->equal_func (_id_index_elt (array, pos - 1), needle))
+			return &idx->buckets[i];
+	}
+}
+
+static void
+_id_index_resize (NMIPConfigIdIndex *idx, GArray *array, guint n_buckets)
+{
+	guint *old_buckets = idx->buckets;
+	guint old_n_buckets = old_buckets ? idx->mask + 1 : 0;
+	guint i;
+
+	nm_assert (n_buckets >= ID_INDEX_MIN_BUCKETS && nm_utils_is_power_of_two (n_buckets));
+
+	idx->buckets = g_new0 (guint, n_buckets);
+	idx->mask = n_buckets - 1;
+
+	for (i = 0; i < old_n_buckets; i++) {
+		if (old_buckets[i])
+			*_id_index_find (idx, array, _id_index_elt (array, old_buckets[i] - 1)) = old_buckets[i];
+	}
+	g_free (old_buckets);
+}
+
+static void
+_id_index_add (NMIPConfigIdIndex *idx, GArray *array, guint pos)
+{
+	guint *bucket;
+
+	if ((idx->n_entries + 1) * 2 > idx->mask + 1)
+		_id_index_resize (idx, array, (idx->mask + 1) * 2);
+
+	/* like the linear search, the index refers to the first entry with a given id. */
+	bucket = _id_index_find (idx, array, _id_index_elt (array, pos));
+	if (!*bucket) {
+		*bucket = pos + 1;
+		idx->n_entries++;
+	}
+}
+
+/**
+ * nm_ip_config_id_index_lookup:
+ * @p_idx: the index of @array, built on first use
+ * @array: the array of addresses or routes
+ * @needle: the entry to look up
+ * @hash_func: hashes the id of an entry
+ * @equal_func: compares the ids of two entries
+ *
+ * Returns: the position of the first entry in @array with the same id
+ *   as @needle, or -1
+ */
+int
+nm_ip_config_id_index_lookup (NMIPConfigIdIndex **p_idx,
+                              GArray *array,
+                              gconstpointer needle,
+                              GHashFunc hash_func,
+                              GEqualFunc equal_func)
+{
+	NMIPConfigIdIndex *idx = *p_idx;
+	guint n_buckets;
+	guint i;
+
+	if (!idx) {
+		idx = g_slice_new0 (NMIPConfigIdIndex);
+		idx->hash_func = hash_func;
+		idx->equal_func = equal_func;
+
+		n_buckets = ID_INDEX_MIN_BUCKETS;
+		while (n_buckets < array->len * 2)
+			n_buckets *= 2;
+		_id_index_resize (idx, array, n_buckets);
+
+		for (i = 0; i < array->len; i++)
+			_id_index_add (idx, array, i);
+		*p_idx = idx;
+	}
+
+	nm_assert (idx->hash_func == hash_func && idx->equal_func == equal_func);
+
+	return ((int) *_id_index_find (idx, array, needle)) - 1;
+}
+
+/**
+ * nm_ip_config_id_index_append:
+ * @idx: (allow-none): the index of @array
+ * @array: the array of addresses or routes
+ *
+ * Adds the last entry of @array to @idx, after it was appended.
+ */
+void
+nm_ip_config_id_index_append (NMIPConfigIdIndex *idx, GArray *array)
+{
+	if (idx)
+		_id_index_add (idx, array, array->len - 1);
+}
+
+void
+nm_ip_config_id_index_free (NMIPConfigIdIndex *idx)
+{
+	g_free (idx->buckets);
+	g_slice_free (NMIPConfigIdIndex, idx);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	guint8 digest[NM_IP_CONFIG_COMMIT_DIGEST_LEN];
+	guint64 generation;
+} CommitState;
+
+#define COMMIT_STATES_MIN_PRUNE_SIZE 64
+
+gboolean
+nm_ip_config_commit_state_unchanged (const NMIPConfigCommitStates *states,
+                                     int ifindex,
+                                     const guint8 *digest)
+{
+	const CommitState *state;
+
+	if (!states->states)
+		return FALSE;
+
+	state = g_hash_table_lookup (states->states, GINT_TO_POINTER (ifindex));
+	return    state
+	       && state->generation == nm_platform_cache_get_generation (NM_PLATFORM_GET, ifindex)
+	       && memcmp (state->digest, digest, NM_IP_CONFIG_COMMIT_DIGEST_LEN) == 0;
+}
+
+/**
+ * nm_ip_config_commit_state_set:
+ * @states: the commit states of an address family
+ * @ifindex: the ifindex committed to
+ * @digest: (allow-none): the digest of the committed input, or %NULL
+ *   if the commit failed and must not be skipped next time
+ */
+void
+nm_ip_config_commit_state_set (NMIPConfigCommitStates *states,
+                               int ifindex,
+                               const guint8 *digest)
+{
+	CommitState *state;
+	GHashTableIter iter;
+	gpointer key;
+	guint64 generation;
+
+	if (!states->states) {
+		states->states = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+		states->prune_size = COMMIT_STATES_MIN_PRUNE_SIZE;
+	}
+
+	generation = digest ? nm_platform_cache_get_generation (NM_PLATFORM_GET, ifindex) : 0;
+	if (!generation) {
+		g_hash_table_remove (states->states, GINT_TO_POINTER (ifindex));
+		return;
+	}
+
+	state = g_hash_table_lookup (states->states, GINT_TO_POINTER (ifindex));
+	if (!state) {
+		if (g_hash_table_size (states->states) >= states->prune_size) {
+			/* drop states that can no longer match, because their link
+			 * changed or is gone. */
+			g_hash_table_iter_init (&iter, states->states);
+			while (g_hash_table_iter_next (&iter, &key, (gpointer *) &state)) {
+				if (state->generation != nm_platform_cache_get_generation (NM_PLATFORM_GET, GPOINTER_TO_INT (key)))
+					g_hash_table_iter_remove (&iter);
+			}
+			states->prune_size = MAX (COMMIT_STATES_MIN_PRUNE_SIZE, 2 * g_hash_table_size (states->states));
+		}
+		state = g_new (CommitState, 1);
+		g_hash_table_insert (states->states, GINT_TO_POINTER (ifindex), state);
+	}
+	memcpy (state->digest, digest, NM_IP_CONFIG_COMMIT_DIGEST_LEN);
+	state->generation = generation;
+}
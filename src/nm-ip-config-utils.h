@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#ifndef __NM_IP_CONFIG_UTILS_H__
+#define __NM_IP_CONFIG_UTILS_H__
+
+/*****************************************************************************/
+
+/* Small configs are searched linearly. Starting with this many entries,
+ * addresses and routes are looked up by their id through a hash index
+ * that is built on first use and dropped whenever entries are removed
+ * or reordered. */
+#define NM_IP_CONFIG_ID_INDEX_MIN_LEN 16
+
+typedef struct _NMIPConfigIdIndex NMIPConfigIdIndex;
+
+int nm_ip_config_id_index_lookup (NMIPConfigIdIndex **p_idx,
+                                  GArray *array,
+                                  gconstpointer needle,
+                                  GHashFunc hash_func,
+                                  GEqualFunc equal_func);
+
+void nm_ip_config_id_index_append (NMIPConfigIdIndex *idx, GArray *array);
+
+void nm_ip_config_id_index_free (NMIPConfigIdIndex *idx);
+
+/*****************************************************************************/
+
+/* For each ifindex, the digest of what the last successful commit synced
+ * and the generation of the platform cache for the ifindex afterwards.
+ * Committing the same input again while the platform state is unchanged
+ * has nothing to do. Each address family keeps its own states. */
+#define NM_IP_CONFIG_COMMIT_DIGEST_LEN 20
+
+typedef struct {
+	GHashTable *states;
+	guint prune_size;
+} NMIPConfigCommitStates;
+
+gboolean nm_ip_config_commit_state_unchanged (const NMIPConfigCommitStates *states,
+                                              int ifindex,
+                                              const guint8 *digest);
+
+void nm_ip_config_commit_state_set (NMIPConfigCommitStates *states,
+                                    int ifindex,
+                                    const guint8 *digest);
+
+/*****************************************************************************/
+
+#endif /* __NM_IP_CONFIG_UTILS_H__ */
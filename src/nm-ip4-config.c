@@ -31,6 +31,8 @@
 #include "platform/nm-platform-utils.h"
 #include "NetworkManagerUtils.h"
 #include "nm-route-manager.h"
+#include "nm-perf-counters.h"
+#include "nm-ip-config-utils.h"
 #include "nm-core-internal.h"
 
 #include "introspection/org.freedesktop.NetworkManager.IP4Config.h"
@@ -71,6 +73,8 @@ typedef struct {
 	gint64 route_metric;
 	GArray *addresses;
 	GArray *routes;
+	NMIPConfigIdIndex *addresses_idx;
+	NMIPConfigIdIndex *routes_idx;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -195,6 +199,39 @@ routes_are_duplicate (const NMPlatformIP4Route *a, const NMPlatformIP4Route *b,
 
 /*****************************************************************************/
 
+static guint
+_addresses_id_hash (gconstpointer key)
+{
+	const NMPlatformIP4Address *a = key;
+	guint h;
+
+	h = a->address;
+	h = (h * 33) + (a->peer_address & nm_utils_ip4_prefix_to_netmask (a->plen));
+	return (h * 33) + a->plen;
+}
+
+static gboolean
+_addresses_id_equal (gconstpointer a, gconstpointer b)
+{
+	return addresses_are_duplicate (a, b);
+}
+
+static guint
+_routes_id_hash (gconstpointer key)
+{
+	const NMPlatformIP4Route *r = key;
+
+	return (((guint) r->network) * 33) + r->plen;
+}
+
+static gboolean
+_routes_id_equal (gconstpointer a, gconstpointer b)
+{
+	return routes_are_duplicate (a, b, FALSE);
+}
+
+/*****************************************************************************/
+
 static gint
 _addresses_sort_cmp_get_prio (in_addr_t addr)
 {
@@ -330,18 +367,51 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	return config;
 }
 
+/*****************************************************************************/
+
+static NMIPConfigCommitStates commit_states;
+
+static void
+_commit_digest (const NMIP4Config *config, gboolean routes_full_sync, gint64 default_route_metric, guint8 *digest)
+{
+	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	GChecksum *sum;
+	gsize len = NM_IP_CONFIG_COMMIT_DIGEST_LEN;
+
+	/* hash the plain structs. Stray padding bytes can only make two equal
+	 * configs look different, which merely costs a needless sync. */
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (sum, (const guint8 *) &routes_full_sync, sizeof (routes_full_sync));
+	g_checksum_update (sum, (const guint8 *) &default_route_metric, sizeof (default_route_metric));
+	g_checksum_update (sum, (const guint8 *) &priv->addresses->len, sizeof (priv->addresses->len));
+	g_checksum_update (sum, (const guint8 *) priv->addresses->data, priv->addresses->len * sizeof (NMPlatformIP4Address));
+	g_checksum_update (sum, (const guint8 *) &priv->routes->len, sizeof (priv->routes->len));
+	g_checksum_update (sum, (const guint8 *) priv->routes->data, priv->routes->len * sizeof (NMPlatformIP4Route));
+	g_checksum_get_digest (sum, digest, &len);
+	g_checksum_free (sum);
+}
+
 gboolean
 nm_ip4_config_commit (const NMIP4Config *config, int ifindex, gboolean routes_full_sync, gint64 default_route_metric)
 {
 	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 	gs_unref_ptrarray GPtrArray *added_addresses = NULL;
+	guint8 digest[NM_IP_CONFIG_COMMIT_DIGEST_LEN];
+	gboolean addresses_synced;
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
 
+	_commit_digest (config, routes_full_sync, default_route_metric, digest);
+	if (nm_ip_config_commit_state_unchanged (&commit_states, ifindex, digest)) {
+		nm_perf_counter_inc (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED);
+		return TRUE;
+	}
+	nm_perf_counter_inc (NM_PERF_COUNTER_IP_CONFIG_COMMITS);
+
 	/* Addresses */
-	nm_platform_ip4_address_sync (NM_PLATFORM_GET, ifindex, priv->addresses,
-	                              default_route_metric >= 0 ? &added_addresses : NULL);
+	addresses_synced = nm_platform_ip4_address_sync (NM_PLATFORM_GET, ifindex, priv->addresses,
+	                                                 default_route_metric >= 0 ? &added_addresses : NULL);
 
 	/* Routes */
 	{
@@ -405,10 +475,17 @@ nm_ip4_config_commit (const NMIP4Config *config, int ifindex, gboolean routes_fu
 
 		success = nm_route_manager_ip4_route_sync (nm_route_manager_get (), ifindex, routes, default_route_metric < 0, routes_full_sync);
 		g_array_unref (routes);
-		if (!success)
+		if (!success) {
+			nm_ip_config_commit_state_set (&commit_states, ifindex, NULL);
 			return FALSE;
+		}
 	}
 
+	/* failing to sync addresses does not fail the commit, but it must
+	 * be retried next time. Take the generation only after the events
+	 * caused by this commit were processed. */
+	nm_platform_process_events (NM_PLATFORM_GET);
+	nm_ip_config_commit_state_set (&commit_states, ifindex, addresses_synced ? digest : NULL);
 	return TRUE;
 }
 
@@ -772,9 +849,14 @@ nm_ip4_config_merge (NMIP4Config *dst, const NMIP4Config *src, NMIPConfigMergeFl
 static int
 _addresses_get_index (const NMIP4Config *self, const NMPlatformIP4Address *addr)
 {
-	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) self);
 	guint i;
 
+	if (priv->addresses->len >= NM_IP_CONFIG_ID_INDEX_MIN_LEN) {
+		return nm_ip_config_id_index_lookup (&priv->addresses_idx, priv->addresses, addr,
+		                                     _addresses_id_hash, _addresses_id_equal);
+	}
+
 	for (i = 0; i < priv->addresses->len; i++) {
 		const NMPlatformIP4Address *a = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
 
@@ -802,9 +884,14 @@ _nameservers_get_index (const NMIP4Config *self, guint32 ns)
 static int
 _routes_get_index (const NMIP4Config *self, const NMPlatformIP4Route *route)
 {
-	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (self);
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE ((NMIP4Config *) self);
 	guint i;
 
+	if (priv->routes->len >= NM_IP_CONFIG_ID_INDEX_MIN_LEN) {
+		return nm_ip_config_id_index_lookup (&priv->routes_idx, priv->routes, route,
+		                                     _routes_id_hash, _routes_id_equal);
+	}
+
 	for (i = 0; i < priv->routes->len; i++) {
 		const NMPlatformIP4Route *r = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 
@@ -890,6 +977,94 @@ _wins_get_index (const NMIP4Config *self, guint32 wins_server)
 	return -1;
 }
 
+/* In a single pass over @dst, removes for each entry of @src the first
+ * remaining entry of @dst with the same id (@in_src), or removes all entries
+ * of @dst whose id is not present in @src (!@in_src). A config can hold
+ * several entries with the same id, like routes to the same network with
+ * different metrics, so subtracting one of them must not remove the others. */
+static void
+_addresses_filter (NMIP4Config *dst, const NMIP4Config *src, gboolean in_src)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (dst);
+	const NMIP4ConfigPrivate *src_priv = NM_IP4_CONFIG_GET_PRIVATE (src);
+	guint *n_remove = NULL;
+	guint i, j;
+	int idx;
+
+	if (in_src) {
+		/* how many entries to remove for each id, counted at the
+		 * position of the first entry of @src with that id. */
+		n_remove = g_new0 (guint, src_priv->addresses->len + 1);
+		for (i = 0; i < src_priv->addresses->len; i++)
+			n_remove[_addresses_get_index (src, &g_array_index (src_priv->addresses, NMPlatformIP4Address, i))]++;
+	}
+
+	for (i = 0, j = 0; i < priv->addresses->len; i++) {
+		const NMPlatformIP4Address *a = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+
+		idx = _addresses_get_index (src, a);
+		if (in_src) {
+			if (idx >= 0 && n_remove[idx] > 0) {
+				n_remove[idx]--;
+				continue;
+			}
+		} else if (idx < 0)
+			continue;
+		if (i != j)
+			g_array_index (priv->addresses, NMPlatformIP4Address, j) = *a;
+		j++;
+	}
+	g_free (n_remove);
+
+	if (j != priv->addresses->len) {
+		g_array_set_size (priv->addresses, j);
+		g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
+		notify_addresses (dst);
+	}
+}
+
+static void
+_routes_filter (NMIP4Config *dst, const NMIP4Config *src, gboolean in_src)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (dst);
+	const NMIP4ConfigPrivate *src_priv = NM_IP4_CONFIG_GET_PRIVATE (src);
+	guint *n_remove = NULL;
+	guint i, j;
+	int idx;
+
+	if (in_src) {
+		/* how many entries to remove for each id, counted at the
+		 * position of the first entry of @src with that id. */
+		n_remove = g_new0 (guint, src_priv->routes->len + 1);
+		for (i = 0; i < src_priv->routes->len; i++)
+			n_remove[_routes_get_index (src, &g_array_index (src_priv->routes, NMPlatformIP4Route, i))]++;
+	}
+
+	for (i = 0, j = 0; i < priv->routes->len; i++) {
+		const NMPlatformIP4Route *r = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+
+		idx = _routes_get_index (src, r);
+		if (in_src) {
+			if (idx >= 0 && n_remove[idx] > 0) {
+				n_remove[idx]--;
+				continue;
+			}
+		} else if (idx < 0)
+			continue;
+		if (i != j)
+			g_array_index (priv->routes, NMPlatformIP4Route, j) = *r;
+		j++;
+	}
+	g_free (n_remove);
+
+	if (j != priv->routes->len) {
+		g_array_set_size (priv->routes, j);
+		g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
+		_notify (dst, PROP_ROUTE_DATA);
+		_notify (dst, PROP_ROUTES);
+	}
+}
+
 /*****************************************************************************/
 
 /**
@@ -911,11 +1086,7 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (src); i++) {
-		idx = _addresses_get_index (dst, nm_ip4_config_get_address (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_address (dst, idx);
-	}
+	_addresses_filter (dst, src, TRUE);
 
 	/* nameservers */
 	for (i = 0; i < nm_ip4_config_get_num_nameservers (src); i++) {
@@ -935,11 +1106,7 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 	/* ignore route_metric */
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (src); i++) {
-		idx = _routes_get_index (dst, nm_ip4_config_get_route (src, i));
-		if (idx >= 0)
-			nm_ip4_config_del_route (dst, idx);
-	}
+	_routes_filter (dst, src, TRUE);
 
 	/* domains */
 	for (i = 0; i < nm_ip4_config_get_num_domains (src); i++) {
@@ -998,22 +1165,13 @@ nm_ip4_config_subtract (NMIP4Config *dst, const NMIP4Config *src)
 void
 nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 {
-	guint32 i;
-	gint idx;
-
 	g_return_if_fail (src != NULL);
 	g_return_if_fail (dst != NULL);
 
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip4_config_get_num_addresses (dst); ) {
-		idx = _addresses_get_index (src, nm_ip4_config_get_address (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_address (dst, i);
-		else
-			i++;
-	}
+	_addresses_filter (dst, src, FALSE);
 
 	/* ignore route_metric */
 	/* ignore nameservers */
@@ -1026,13 +1184,7 @@ nm_ip4_config_intersect (NMIP4Config *dst, const NMIP4Config *src)
 	}
 
 	/* routes */
-	for (i = 0; i < nm_ip4_config_get_num_routes (dst); ) {
-		idx = _routes_get_index (src, nm_ip4_config_get_route (dst, i));
-		if (idx < 0)
-			nm_ip4_config_del_route (dst, i);
-		else
-			i++;
-	}
+	_routes_filter (dst, src, FALSE);
 
 	/* ignore domains */
 	/* ignore dns searches */
@@ -1497,6 +1649,7 @@ nm_ip4_config_reset_addresses (NMIP4Config *config)
 
 	if (priv->addresses->len != 0) {
 		g_array_set_size (priv->addresses, 0);
+		g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
 		notify_addresses (config);
 	}
 }
@@ -1520,39 +1673,39 @@ nm_ip4_config_add_address (NMIP4Config *config, const NMPlatformIP4Address *new)
 
 	g_return_if_fail (new != NULL);
 
-	for (i = 0; i < priv->addresses->len; i++ ) {
+	i = _addresses_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Address *item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
 
-		if (addresses_are_duplicate (item, new)) {
-			if (nm_platform_ip4_address_cmp (item, new) == 0)
-				return;
-
-			/* remember the old values. */
-			item_old = *item;
-			/* Copy over old item to get new lifetime, timestamp, preferred */
-			*item = *new;
-
-			/* But restore highest priority source */
-			item->addr_source = MAX (item_old.addr_source, new->addr_source);
-
-			/* for addresses that we read from the kernel, we keep the timestamps as defined
-			 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
-			 * with "what should be" and the kernel values are "what turned out after configuring it".
-			 *
-			 * For other sources, the longer lifetime wins. */
-			if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
-			    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
-				item->timestamp = item_old.timestamp;
-				item->lifetime = item_old.lifetime;
-				item->preferred = item_old.preferred;
-			}
-			if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
-				return;
-			goto NOTIFY;
+		if (nm_platform_ip4_address_cmp (item, new) == 0)
+			return;
+
+		/* remember the old values. */
+		item_old = *item;
+		/* Copy over old item to get new lifetime, timestamp, preferred */
+		*item = *new;
+
+		/* But restore highest priority source */
+		item->addr_source = MAX (item_old.addr_source, new->addr_source);
+
+		/* for addresses that we read from the kernel, we keep the timestamps as defined
+		 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
+		 * with "what should be" and the kernel values are "what turned out after configuring it".
+		 *
+		 * For other sources, the longer lifetime wins. */
+		if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
+		    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
+			item->timestamp = item_old.timestamp;
+			item->lifetime = item_old.lifetime;
+			item->preferred = item_old.preferred;
 		}
+		if (nm_platform_ip4_address_cmp (&item_old, item) == 0)
+			return;
+		goto NOTIFY;
 	}
 
 	g_array_append_val (priv->addresses, *new);
+	nm_ip_config_id_index_append (priv->addresses_idx, priv->addresses);
 NOTIFY:
 	notify_addresses (config);
 }
@@ -1565,6 +1718,7 @@ nm_ip4_config_del_address (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->addresses->len);
 
 	g_array_remove_index (priv->addresses, i);
+	g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
 
 	notify_addresses (config);
 }
@@ -1601,6 +1755,7 @@ nm_ip4_config_reset_routes (NMIP4Config *config)
 
 	if (priv->routes->len != 0) {
 		g_array_set_size (priv->routes, 0);
+		g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 		_notify (config, PROP_ROUTE_DATA);
 		_notify (config, PROP_ROUTES);
 	}
@@ -1627,23 +1782,23 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 	g_return_if_fail (new->plen > 0 && new->plen <= 32);
 	g_return_if_fail (priv->ifindex > 0);
 
-	for (i = 0; i < priv->routes->len; i++ ) {
+	i = _routes_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP4Route *item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 
-		if (routes_are_duplicate (item, new, FALSE)) {
-			if (nm_platform_ip4_route_cmp (item, new) == 0)
-				return;
-			old_source = item->rt_source;
-			memcpy (item, new, sizeof (*item));
-			/* Restore highest priority source */
-			item->rt_source = MAX (old_source, new->rt_source);
-			item->ifindex = priv->ifindex;
-			goto NOTIFY;
-		}
+		if (nm_platform_ip4_route_cmp (item, new) == 0)
+			return;
+		old_source = item->rt_source;
+		memcpy (item, new, sizeof (*item));
+		/* Restore highest priority source */
+		item->rt_source = MAX (old_source, new->rt_source);
+		item->ifindex = priv->ifindex;
+		goto NOTIFY;
 	}
 
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP4Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	nm_ip_config_id_index_append (priv->routes_idx, priv->routes);
 NOTIFY:
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
@@ -1657,6 +1812,7 @@ nm_ip4_config_del_route (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->routes->len);
 
 	g_array_remove_index (priv->routes, i);
+	g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
 }
@@ -2502,6 +2658,8 @@ finalize (GObject *object)
 	nm_clear_g_variant (&priv->addresses_variant);
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
+	g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
@@ -30,6 +30,8 @@
 #include "platform/nm-platform.h"
 #include "platform/nm-platform-utils.h"
 #include "nm-route-manager.h"
+#include "nm-perf-counters.h"
+#include "nm-ip-config-utils.h"
 #include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
 
@@ -47,6 +49,8 @@ typedef struct {
 	struct in6_addr gateway;
 	GArray *addresses;
 	GArray *routes;
+	NMIPConfigIdIndex *addresses_idx;
+	NMIPConfigIdIndex *routes_idx;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -192,6 +196,47 @@ routes_are_duplicate (const NMPlatformIP6Route *a, const NMPlatformIP6Route *b,
 	            && nm_utils_ip6_route_metric_normalize (a->metric) == nm_utils_ip6_route_metric_normalize (b->metric)));
 }
 
+/*****************************************************************************/
+
+static guint
+_in6_addr_hash (const struct in6_addr *addr)
+{
+	guint h = 5381;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (addr->s6_addr32); i++)
+		h = (h * 33) + addr->s6_addr32[i];
+	return h;
+}
+
+static guint
+_addresses_id_hash (gconstpointer key)
+{
+	const NMPlatformIP6Address *a = key;
+
+	return _in6_addr_hash (&a->address);
+}
+
+static gboolean
+_addresses_id_equal (gconstpointer a, gconstpointer b)
+{
+	return addresses_are_duplicate (a, b);
+}
+
+static guint
+_routes_id_hash (gconstpointer key)
+{
+	const NMPlatformIP6Route *r = key;
+
+	return (_in6_addr_hash (&r->network) * 33) + r->plen;
+}
+
+static gboolean
+_routes_id_equal (gconstpointer a, gconstpointer b)
+{
+	return routes_are_duplicate (a, b, FALSE);
+}
+
 static gint
 _addresses_sort_cmp_get_prio (const struct in6_addr *addr)
 {
@@ -288,6 +333,7 @@ nm_ip6_config_addresses_sort (NMIP6Config *self)
 
 		g_array_sort_with_data (priv->addresses, _addresses_sort_cmp,
 		                        GINT_TO_POINTER (priv->privacy));
+		g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
 
 		changed = memcmp (data_pre, priv->addresses->data, data_len) != 0;
 		g_free (data_pre);
@@ -385,17 +431,49 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 	return config;
 }
 
+/*****************************************************************************/
+
+static NMIPConfigCommitStates commit_states;
+
+static void
+_commit_digest (const NMIP6Config *config, gboolean routes_full_sync, guint8 *digest)
+{
+	const NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+	GChecksum *sum;
+	gsize len = NM_IP_CONFIG_COMMIT_DIGEST_LEN;
+
+	/* hash the plain structs. Stray padding bytes can only make two equal
+	 * configs look different, which merely costs a needless sync. */
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (sum, (const guint8 *) &routes_full_sync, sizeof (routes_full_sync));
+	g_checksum_update (sum, (const guint8 *) &priv->addresses->len, sizeof (priv->addresses->len));
+	g_checksum_update (sum, (const guint8 *) priv->addresses->data, priv->addresses->len * sizeof (NMPlatformIP6Address));
+	g_checksum_update (sum, (const guint8 *) &priv->routes->len, sizeof (priv->routes->len));
+	g_checksum_update (sum, (const guint8 *) priv->routes->data, priv->routes->len * sizeof (NMPlatformIP6Route));
+	g_checksum_get_digest (sum, digest, &len);
+	g_checksum_free (sum);
+}
+
 gboolean
 nm_ip6_config_commit (const NMIP6Config *config, int ifindex, gboolean routes_full_sync)
 {
 	const NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 	gboolean success;
+	guint8 digest[NM_IP_CONFIG_COMMIT_DIGEST_LEN];
+	gboolean addresses_synced;
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
 	g_return_val_if_fail (config != NULL, FALSE);
 
+	_commit_digest (config, routes_full_sync, digest);
+	if (nm_ip_config_commit_state_unchanged (&commit_states, ifindex, digest)) {
+		nm_perf_counter_inc (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED);
+		return TRUE;
+	}
+	nm_perf_counter_inc (NM_PERF_COUNTER_IP_CONFIG_COMMITS);
+
 	/* Addresses */
-	nm_platform_ip6_address_sync (NM_PLATFORM_GET, ifindex, priv->addresses, TRUE);
+	addresses_synced = nm_platform_ip6_address_sync (NM_PLATFORM_GET, ifindex, priv->addresses, TRUE);
 
 	/* Routes */
 	{
@@ -413,7 +491,17 @@ nm_ip6_config_commit (const NMIP6Config *config, int ifindex, gboolean routes_fu
 		g_array_unref (routes);
 	}
 
-	return success;
+	if (!success) {
+		nm_ip_config_commit_state_set (&commit_states, ifindex, NULL);
+		return FALSE;
+	}
+
+	/* failing to sync addresses does not fail the commit, but it must
+	 * be retried next time. Take the generation only after the events
+	 * caused by this commit were processed. */
+	nm_platform_process_events (NM_PLATFORM_GET);
+	nm_ip_config_commit_state_set (&commit_states, ifindex, addresses_synced ? digest : NULL);
+	return TRUE;
 }
 
 static void
@@ -792,9 +880,14 @@ nm_ip6_config_destination_is_direct (const NMIP6Config *config, const struct in6
 static int
 _addresses_get_index (const NMIP6Config *self, const NMPlatformIP6Address *addr)
 {
-	const NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (self);
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE ((NMIP6Config *) self);
 	guint i;
 
+	if (priv->addresses->len >= NM_IP_CONFIG_ID_INDEX_MIN_LEN) {
+		return nm_ip_config_id_index_lookup (&priv->addresses_idx, priv->addresses, addr,
+		                                     _addresses_id_hash, _addresses_id_equal);
+	}
+
 	for (i = 0; i < priv->addresses->len; i++) {
 		const NMPlatformIP6Address *a = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
 
@@ -822,9 +915,14 @@ _nameservers_get_index (const NMIP6Config *self, const struct in6_addr *ns)
 static int
 _routes_get_index (const NMIP6Config *self, const NMPlatformIP6Route *route)
 {
-	const NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (self);
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE ((NMIP6Config *) self);
 	guint i;
 
+	if (priv->routes->len >= NM_IP_CONFIG_ID_INDEX_MIN_LEN) {
+		return nm_ip_config_id_index_lookup (&priv->routes_idx, priv->routes, route,
+		                                     _routes_id_hash, _routes_id_equal);
+	}
+
 	for (i = 0; i < priv->routes->len; i++) {
 		const NMPlatformIP6Route *r = &g_array_index (priv->routes, NMPlatformIP6Route, i);
 
@@ -879,6 +977,94 @@ _dns_options_get_index (const NMIP6Config *self, const char *option)
 	return -1;
 }
 
+/* In a single pass over @dst, removes for each entry of @src the first
+ * remaining entry of @dst with the same id (@in_src), or removes all entries
+ * of @dst whose id is not present in @src (!@in_src). A config can hold
+ * several entries with the same id, like routes to the same network with
+ * different metrics, so subtracting one of them must not remove the others. */
+static void
+_addresses_filter (NMIP6Config *dst, const NMIP6Config *src, gboolean in_src)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (dst);
+	const NMIP6ConfigPrivate *src_priv = NM_IP6_CONFIG_GET_PRIVATE (src);
+	guint *n_remove = NULL;
+	guint i, j;
+	int idx;
+
+	if (in_src) {
+		/* how many entries to remove for each id, counted at the
+		 * position of the first entry of @src with that id. */
+		n_remove = g_new0 (guint, src_priv->addresses->len + 1);
+		for (i = 0; i < src_priv->addresses->len; i++)
+			n_remove[_addresses_get_index (src, &g_array_index (src_priv->addresses, NMPlatformIP6Address, i))]++;
+	}
+
+	for (i = 0, j = 0; i < priv->addresses->len; i++) {
+		const NMPlatformIP6Address *a = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
+
+		idx = _addresses_get_index (src, a);
+		if (in_src) {
+			if (idx >= 0 && n_remove[idx] > 0) {
+				n_remove[idx]--;
+				continue;
+			}
+		} else if (idx < 0)
+			continue;
+		if (i != j)
+			g_array_index (priv->addresses, NMPlatformIP6Address, j) = *a;
+		j++;
+	}
+	g_free (n_remove);
+
+	if (j != priv->addresses->len) {
+		g_array_set_size (priv->addresses, j);
+		g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
+		notify_addresses (dst);
+	}
+}
+
+static void
+_routes_filter (NMIP6Config *dst, const NMIP6Config *src, gboolean in_src)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (dst);
+	const NMIP6ConfigPrivate *src_priv = NM_IP6_CONFIG_GET_PRIVATE (src);
+	guint *n_remove = NULL;
+	guint i, j;
+	int idx;
+
+	if (in_src) {
+		/* how many entries to remove for each id, counted at the
+		 * position of the first entry of @src with that id. */
+		n_remove = g_new0 (guint, src_priv->routes->len + 1);
+		for (i = 0; i < src_priv->routes->len; i++)
+			n_remove[_routes_get_index (src, &g_array_index (src_priv->routes, NMPlatformIP6Route, i))]++;
+	}
+
+	for (i = 0, j = 0; i < priv->routes->len; i++) {
+		const NMPlatformIP6Route *r = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+
+		idx = _routes_get_index (src, r);
+		if (in_src) {
+			if (idx >= 0 && n_remove[idx] > 0) {
+				n_remove[idx]--;
+				continue;
+			}
+		} else if (idx < 0)
+			continue;
+		if (i != j)
+			g_array_index (priv->routes, NMPlatformIP6Route, j) = *r;
+		j++;
+	}
+	g_free (n_remove);
+
+	if (j != priv->routes->len) {
+		g_array_set_size (priv->routes, j);
+		g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
+		_notify (dst, PROP_ROUTE_DATA);
+		_notify (dst, PROP_ROUTES);
+	}
+}
+
 /*****************************************************************************/
 
 /**
@@ -901,11 +1087,7 @@ nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip6_config_get_num_addresses (src); i++) {
-		idx = _addresses_get_index (dst, nm_ip6_config_get_address (src, i));
-		if (idx >= 0)
-			nm_ip6_config_del_address (dst, idx);
-	}
+	_addresses_filter (dst, src, TRUE);
 
 	/* nameservers */
 	for (i = 0; i < nm_ip6_config_get_num_nameservers (src); i++) {
@@ -926,11 +1108,7 @@ nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src)
 	/* ignore route_metric */
 
 	/* routes */
-	for (i = 0; i < nm_ip6_config_get_num_routes (src); i++) {
-		idx = _routes_get_index (dst, nm_ip6_config_get_route (src, i));
-		if (idx >= 0)
-			nm_ip6_config_del_route (dst, idx);
-	}
+	_routes_filter (dst, src, TRUE);
 
 	/* domains */
 	for (i = 0; i < nm_ip6_config_get_num_domains (src); i++) {
@@ -966,8 +1144,6 @@ nm_ip6_config_subtract (NMIP6Config *dst, const NMIP6Config *src)
 void
 nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src)
 {
-	guint i;
-	gint idx;
 	const struct in6_addr *dst_tmp, *src_tmp;
 
 	g_return_if_fail (src != NULL);
@@ -976,13 +1152,7 @@ nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src)
 	g_object_freeze_notify (G_OBJECT (dst));
 
 	/* addresses */
-	for (i = 0; i < nm_ip6_config_get_num_addresses (dst); ) {
-		idx = _addresses_get_index (src, nm_ip6_config_get_address (dst, i));
-		if (idx < 0)
-			nm_ip6_config_del_address (dst, i);
-		else
-			i++;
-	}
+	_addresses_filter (dst, src, FALSE);
 
 	/* ignore route_metric */
 	/* ignore nameservers */
@@ -998,13 +1168,7 @@ nm_ip6_config_intersect (NMIP6Config *dst, const NMIP6Config *src)
 	}
 
 	/* routes */
-	for (i = 0; i < nm_ip6_config_get_num_routes (dst); ) {
-		idx = _routes_get_index (src, nm_ip6_config_get_route (dst, i));
-		if (idx < 0)
-			nm_ip6_config_del_route (dst, i);
-		else
-			i++;
-	}
+	_routes_filter (dst, src, FALSE);
 
 	/* ignore domains */
 	/* ignore dns searches */
@@ -1344,6 +1508,7 @@ nm_ip6_config_reset_addresses (NMIP6Config *config)
 
 	if (priv->addresses->len != 0) {
 		g_array_set_size (priv->addresses, 0);
+		g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
 		notify_addresses (config);
 	}
 }
@@ -1367,39 +1532,39 @@ nm_ip6_config_add_address (NMIP6Config *config, const NMPlatformIP6Address *new)
 
 	g_return_if_fail (new != NULL);
 
-	for (i = 0; i < priv->addresses->len; i++ ) {
+	i = _addresses_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP6Address *item = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
 
-		if (addresses_are_duplicate (item, new)) {
-			if (nm_platform_ip6_address_cmp (item, new) == 0)
-				return;
-
-			/* remember the old values. */
-			item_old = *item;
-			/* Copy over old item to get new lifetime, timestamp, preferred */
-			*item = *new;
-
-			/* But restore highest priority source */
-			item->addr_source = MAX (item_old.addr_source, new->addr_source);
-
-			/* for addresses that we read from the kernel, we keep the timestamps as defined
-			 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
-			 * with "what should be" and the kernel values are "what turned out after configuring it".
-			 *
-			 * For other sources, the longer lifetime wins. */
-			if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
-			    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
-				item->timestamp = item_old.timestamp;
-				item->lifetime = item_old.lifetime;
-				item->preferred = item_old.preferred;
-			}
-			if (nm_platform_ip6_address_cmp (&item_old, item) == 0)
-				return;
-			goto NOTIFY;
+		if (nm_platform_ip6_address_cmp (item, new) == 0)
+			return;
+
+		/* remember the old values. */
+		item_old = *item;
+		/* Copy over old item to get new lifetime, timestamp, preferred */
+		*item = *new;
+
+		/* But restore highest priority source */
+		item->addr_source = MAX (item_old.addr_source, new->addr_source);
+
+		/* for addresses that we read from the kernel, we keep the timestamps as defined
+		 * by the previous source (item_old). The reason is, that the other source configured the lifetimes
+		 * with "what should be" and the kernel values are "what turned out after configuring it".
+		 *
+		 * For other sources, the longer lifetime wins. */
+		if (   (new->addr_source == NM_IP_CONFIG_SOURCE_KERNEL && new->addr_source != item_old.addr_source)
+		    || nm_platform_ip_address_cmp_expiry ((const NMPlatformIPAddress *) &item_old, (const NMPlatformIPAddress *) new) > 0) {
+			item->timestamp = item_old.timestamp;
+			item->lifetime = item_old.lifetime;
+			item->preferred = item_old.preferred;
 		}
+		if (nm_platform_ip6_address_cmp (&item_old, item) == 0)
+			return;
+		goto NOTIFY;
 	}
 
 	g_array_append_val (priv->addresses, *new);
+	nm_ip_config_id_index_append (priv->addresses_idx, priv->addresses);
 NOTIFY:
 notify_addresses (config);
 }
@@ -1412,6 +1577,7 @@ nm_ip6_config_del_address (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->addresses->len);
 
 	g_array_remove_index (priv->addresses, i);
+	g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
 
 	notify_addresses (config);
 }
@@ -1512,6 +1678,7 @@ nm_ip6_config_reset_routes (NMIP6Config *config)
 
 	if (priv->routes->len != 0) {
 		g_array_set_size (priv->routes, 0);
+		g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 		_notify (config, PROP_ROUTE_DATA);
 		_notify (config, PROP_ROUTES);
 	}
@@ -1538,23 +1705,23 @@ nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *new)
 	g_return_if_fail (new->plen > 0 && new->plen <= 128);
 	g_return_if_fail (priv->ifindex > 0);
 
-	for (i = 0; i < priv->routes->len; i++ ) {
+	i = _routes_get_index (config, new);
+	if (i >= 0) {
 		NMPlatformIP6Route *item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
 
-		if (routes_are_duplicate (item, new, FALSE)) {
-			if (nm_platform_ip6_route_cmp (item, new) == 0)
-				return;
-			old_source = item->rt_source;
-			*item = *new;
-			/* Restore highest priority source */
-			item->rt_source = MAX (old_source, new->rt_source);
-			item->ifindex = priv->ifindex;
-			goto NOTIFY;
-		}
+		if (nm_platform_ip6_route_cmp (item, new) == 0)
+			return;
+		old_source = item->rt_source;
+		*item = *new;
+		/* Restore highest priority source */
+		item->rt_source = MAX (old_source, new->rt_source);
+		item->ifindex = priv->ifindex;
+		goto NOTIFY;
 	}
 
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP6Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	nm_ip_config_id_index_append (priv->routes_idx, priv->routes);
 NOTIFY:
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
@@ -1568,6 +1735,7 @@ nm_ip6_config_del_route (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->routes->len);
 
 	g_array_remove_index (priv->routes, i);
+	g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
 }
@@ -2280,6 +2448,8 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	g_clear_pointer (&priv->addresses_idx, nm_ip_config_id_index_free);
+	g_clear_pointer (&priv->routes_idx, nm_ip_config_id_index_free);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
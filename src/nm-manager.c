@@ -54,10 +54,12 @@
 #include "nm-dbus-compat.h"
 #include "nm-checkpoint.h"
 #include "nm-checkpoint-manager.h"
+#include "nm-perf-counters.h"
 #include "NetworkManagerUtils.h"
 
 #include "introspection/org.freedesktop.NetworkManager.h"
 #include "introspection/org.freedesktop.NetworkManager.Device.h"
+#include "introspection/org.freedesktop.NetworkManager.PerfCounters.h"
 
 static gboolean add_device (NMManager *self, NMDevice *device, GError **error);
 
@@ -505,6 +507,11 @@ _config_changed_cb (NMConfig *config, NMConfigData *config_data, NMConfigChangeF
 
 	if (NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG))
 		_notify (self, PROP_GLOBAL_DNS_CONFIGURATION);
+
+	if (NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_CAUSE_SIGUSR2)) {
+		nm_device_activation_stage_stats_log ();
+		nm_active_connection_activation_stats_log ();
+	}
 }
 
 static void
@@ -4826,6 +4833,15 @@ impl_manager_get_logging (NMManager *manager,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_get_perf_counters (NMManager *manager,
+                                GDBusMethodInvocation *context)
+{
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(@a{st})",
+	                                                      nm_perf_counters_to_variant ()));
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -6575,4 +6591,8 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                                        "CheckpointDestroy", impl_manager_checkpoint_destroy,
 	                                        "CheckpointRollback", impl_manager_checkpoint_rollback,
 	                                        NULL);
+	nm_exported_object_class_add_interface (NM_EXPORTED_OBJECT_CLASS (manager_class),
+	                                        NMDBUS_TYPE_PERF_COUNTERS_SKELETON,
+	                                        "GetCounters", impl_manager_get_perf_counters,
+	                                        NULL);
 }
@@ -30,25 +30,49 @@ struct NMMultiIndex {
 	GHashTable *hash;
 };
 
+typedef struct {
+	guint alloc;
+	gpointer values[];
+} ValuesArr;
+
 typedef struct {
 	/* when storing the first item for a multi-index id, we don't yet create
-	 * the hashtable @index. Instead we store it inplace to @value0. Note that
+	 * the array @arr. Instead we store it inplace to @value0. Note that
 	 * &values_data->value0 is a NULL terminated array with one item that is
-	 * suitable to be returned directly from nm_multi_index_lookup(). */
+	 * suitable to be returned directly from nm_multi_index_lookup().
+	 *
+	 * Once there is more than one value, @arr->values is a NULL terminated
+	 * array, kept up to date on every add and remove. Lookups return
+	 * it as is, without copying. @index maps each value to its position
+	 * (plus one) in @arr->values, so that removing a value is O(1) too: the
+	 * last item is moved into the hole. The number of values is the size of
+	 * @index.
+	 *
+	 * There is one ValuesData per id, so keep it small. */
 	union {
 		gpointer value0;
-		gpointer *values;
+		ValuesArr *arr;
 	};
 	GHashTable *index;
 } ValuesData;
 
+G_STATIC_ASSERT (sizeof (ValuesData) == 2 * sizeof (gpointer));
+
 /*****************************************************************************/
 
+static ValuesArr *
+_values_arr_resize (ValuesArr *arr, guint alloc)
+{
+	arr = g_realloc (arr, G_STRUCT_OFFSET (ValuesArr, values) + (sizeof (gpointer) * (alloc + 1)));
+	arr->alloc = alloc;
+	return arr;
+}
+
 static void
 _values_data_destroy (ValuesData *values_data)
 {
 	if (values_data->index) {
-		g_free (values_data->values);
+		g_free (values_data->arr);
 		g_hash_table_unref (values_data->index);
 	}
 	g_slice_free (ValuesData, values_data);
@@ -67,9 +91,7 @@ _values_data_get_data (ValuesData *values_data,
                        void *const**out_data,
                        guint *out_len)
 {
-	guint i, len;
-	gpointer *values;
-	GHashTableIter iter;
+	guint len;
 
 	nm_assert (values_data);
 
@@ -79,24 +101,95 @@ _values_data_get_data (ValuesData *values_data,
 		return;
 	}
 
-	nm_assert (values_data->index && g_hash_table_size (values_data->index) > 0);
+	len = g_hash_table_size (values_data->index);
 
-	if (!values_data->values) {
+	nm_assert (len > 1);
+	nm_assert (len <= values_data->arr->alloc);
+	nm_assert (!values_data->arr->values[len]);
+
+	NM_SET_OUT (out_data, values_data->arr->values);
+	NM_SET_OUT (out_len, len);
+}
+
+static gboolean
+_values_data_add (ValuesData *values_data, gconstpointer value)
+{
+	ValuesArr *arr;
+	guint len;
+
+	if (!values_data->index) {
+		gpointer value0 = values_data->value0;
+
+		if (value0 == value)
+			return FALSE;
+
+		arr = _values_arr_resize (NULL, 4);
+		arr->values[0] = value0;
+		values_data->arr = arr;
+		values_data->index = g_hash_table_new (NULL, NULL);
+		g_hash_table_insert (values_data->index, value0, GUINT_TO_POINTER (1));
+		len = 1;
+	} else {
+		if (g_hash_table_contains (values_data->index, value))
+			return FALSE;
+		arr = values_data->arr;
 		len = g_hash_table_size (values_data->index);
-		values = g_new (gpointer, len + 1);
+		if (len == arr->alloc)
+			values_data->arr = arr = _values_arr_resize (arr, arr->alloc * 2);
+	}
+
+	arr->values[len++] = (gpointer) value;
+	arr->values[len] = NULL;
+	g_hash_table_insert (values_data->index, (gpointer) value, GUINT_TO_POINTER (len));
+	return TRUE;
+}
+
+/* Returns: %TRUE if @value was found. In that case, @out_empty tells
+ * whether @values_data holds no values anymore and must be dropped. */
+static gboolean
+_values_data_remove (ValuesData *values_data, gconstpointer value, gboolean *out_empty)
+{
+	ValuesArr *arr;
+	guint pos, len;
+
+	if (!values_data->index) {
+		if (values_data->value0 != value)
+			return FALSE;
+		*out_empty = TRUE;
+		return TRUE;
+	}
+
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (values_data->index, value));
+	if (pos == 0)
+		return FALSE;
+	pos--;
+
+	arr = values_data->arr;
+	len = g_hash_table_size (values_data->index);
+
+	nm_assert (pos < len);
+	nm_assert (arr->values[pos] == value);
+
+	g_hash_table_remove (values_data->index, value);
+	len--;
+	if (pos < len) {
+		gpointer last = arr->values[len];
 
-		g_hash_table_iter_init (&iter, values_data->index);
-		for (i = 0; g_hash_table_iter_next (&iter, &values[i], NULL); i++)
-			nm_assert (i < len);
-		nm_assert (i == len);
-		values[i] = NULL;
+		arr->values[pos] = last;
+		g_hash_table_insert (values_data->index, last, GUINT_TO_POINTER (pos + 1));
+	}
+	arr->values[len] = NULL;
 
-		values_data->values = values;
-		NM_SET_OUT (out_len, len);
-	} else if (out_len)
-		NM_SET_OUT (out_len, g_hash_table_size (values_data->index));
+	if (len == 1) {
+		/* go back to storing the single remaining value inplace. */
+		values_data->value0 = arr->values[0];
+		g_free (arr);
+		g_clear_pointer (&values_data->index, g_hash_table_unref);
+	} else if (arr->alloc > 4 && len <= arr->alloc / 4)
+		values_data->arr = _values_arr_resize (arr, arr->alloc / 2);
 
-	NM_SET_OUT (out_data, values_data->values);
+	*out_empty = FALSE;
+	return TRUE;
 }
 
 /*****************************************************************************/
@@ -251,15 +344,12 @@ nm_multi_index_id_iter_init (NMMultiIndexIdIter *iter,
 	g_return_if_fail (id);
 
 	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data)
-		iter->_state = 2;
-	else if (values_data->index) {
-		iter->_state = 1;
-		g_hash_table_iter_init (&iter->_iter, values_data->index);
-	} else {
-		iter->_state = 0;
-		iter->_value = values_data->value0;
-	}
+	if (!values_data) {
+		iter->_values = NULL;
+		iter->_len = 0;
+	} else
+		_values_data_get_data (values_data, &iter->_values, &iter->_len);
+	iter->_idx = 0;
 }
 
 gboolean
@@ -268,19 +358,10 @@ nm_multi_index_id_iter_next (NMMultiIndexIdIter *iter,
 {
 	g_return_val_if_fail (iter, FALSE);
 
-	switch (iter->_state) {
-	case 0:
-		iter->_state = 2;
-		NM_SET_OUT (out_value, iter->_value);
-		return TRUE;
-	case 1:
-		return g_hash_table_iter_next (&iter->_iter, out_value, NULL);
-	case 2:
-		iter->_state = 3;
+	if (iter->_idx >= iter->_len)
 		return FALSE;
-	default:
-		g_return_val_if_reached (FALSE);
-	}
+	NM_SET_OUT (out_value, iter->_values[iter->_idx++]);
+	return TRUE;
 }
 
 /*****************************************************************************/
@@ -313,21 +394,10 @@ _do_add (NMMultiIndex *index,
 		values_data->value0 = (gpointer) value;
 
 		g_hash_table_insert (index->hash, id_new, values_data);
-	} else {
-		if (!values_data->index) {
-			if (values_data->value0 == value)
-				return FALSE;
-			values_data->index = g_hash_table_new (NULL, NULL);
-			g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value);
-			g_hash_table_replace (values_data->index, values_data->value0, values_data->value0);
-			values_data->values = NULL;
-		} else {
-			if (!nm_g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value))
-				return FALSE;
-			g_clear_pointer (&values_data->values, g_free);
-		}
+		return TRUE;
 	}
-	return TRUE;
+
+	return _values_data_add (values_data, value);
 }
 
 static gboolean
@@ -336,24 +406,16 @@ _do_remove (NMMultiIndex *index,
             gconstpointer value)
 {
 	ValuesData *values_data;
+	gboolean empty;
 
 	values_data = g_hash_table_lookup (index->hash, id);
 	if (!values_data)
 		return FALSE;
 
-	if (values_data->index) {
-		if (!g_hash_table_remove (values_data->index, value))
-			return FALSE;
-		if (g_hash_table_size (values_data->index) == 0)
-			g_hash_table_remove (index->hash, id);
-		else
-			g_clear_pointer (&values_data->values, g_free);
-	} else {
-		if (values_data->value0 != value)
-			return FALSE;
+	if (!_values_data_remove (values_data, value, &empty))
+		return FALSE;
+	if (empty)
 		g_hash_table_remove (index->hash, id);
-	}
-
 	return TRUE;
 }
 
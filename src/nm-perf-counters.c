@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-perf-counters.h"
+
+#include "platform/nmp-object.h"
+#include "nm-active-connection.h"
+
+/*****************************************************************************/
+
+guint64 _nm_perf_counters[_NM_PERF_COUNTER_NUM];
+
+NM_UTILS_LOOKUP_STR_DEFINE_STATIC (_perf_counter_to_string, NMPerfCounter,
+	NM_UTILS_LOOKUP_DEFAULT_WARN (NULL),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_NETLINK_RECV,       "netlink-recv"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_NETLINK_SEND,       "netlink-send"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_NETLINK_RESYNC,     "netlink-resync"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_SYSCTL_READ,        "sysctl-read"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_SYSCTL_WRITE,       "sysctl-write"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_DBUS_SIGNALS,       "dbus-signals"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_RESOLV_CONF_WRITES, "resolv-conf-writes"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_DISPATCHER_RUNS,    "dispatcher-runs"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_AUTOCONNECT_PASSES, "autoconnect-passes"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_IP_CONFIG_COMMITS,  "ip-config-commits"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED, "ip-config-commits-skipped"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_DEVICE_IP_SYNCS,    "device-ip-syncs"),
+	NM_UTILS_LOOKUP_STR_ITEM (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED, "device-ip-syncs-skipped"),
+);
+
+/**
+ * nm_perf_counters_to_variant:
+ *
+ * Returns: a floating #GVariant of type "a{st}" with the current value
+ *   of all counters, the number of objects in the platform caches,
+ *   as "platform-cache-<type>", and the activation histograms from
+ *   nm_active_connection_activation_stats_add_counters().
+ */
+GVariant *
+nm_perf_counters_to_variant (void)
+{
+	GVariantBuilder builder;
+	char buf[100];
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{st}"));
+
+	for (i = 0; i < _NM_PERF_COUNTER_NUM; i++)
+		g_variant_builder_add (&builder, "{st}", _perf_counter_to_string (i), _nm_perf_counters[i]);
+
+	for (i = 1; i <= NMP_OBJECT_TYPE_MAX; i++) {
+		const NMPClass *klass = nmp_class_from_type (i);
+
+		g_variant_builder_add (&builder, "{st}",
+		                       nm_sprintf_buf (buf, "platform-cache-%s", klass->obj_type_name),
+		                       (guint64) nmp_cache_get_total_object_count (i));
+	}
+
+	nm_active_connection_activation_stats_add_counters (&builder);
+
+	return g_variant_builder_end (&builder);
+}
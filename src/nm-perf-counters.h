@@ -0,0 +1,62 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#ifndef __NM_PERF_COUNTERS_H__
+#define __NM_PERF_COUNTERS_H__
+
+/* Daemon-wide event counters. They are only touched from the main thread,
+ * so incrementing one is a plain memory increment. */
+
+typedef enum {
+	NM_PERF_COUNTER_NETLINK_RECV,
+	NM_PERF_COUNTER_NETLINK_SEND,
+	NM_PERF_COUNTER_NETLINK_RESYNC,
+	NM_PERF_COUNTER_SYSCTL_READ,
+	NM_PERF_COUNTER_SYSCTL_WRITE,
+	NM_PERF_COUNTER_DBUS_SIGNALS,
+	NM_PERF_COUNTER_RESOLV_CONF_WRITES,
+	NM_PERF_COUNTER_DISPATCHER_RUNS,
+	NM_PERF_COUNTER_AUTOCONNECT_PASSES,
+	NM_PERF_COUNTER_IP_CONFIG_COMMITS,
+	NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED,
+	NM_PERF_COUNTER_DEVICE_IP_SYNCS,
+	NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED,
+	_NM_PERF_COUNTER_NUM,
+} NMPerfCounter;
+
+extern guint64 _nm_perf_counters[_NM_PERF_COUNTER_NUM];
+
+static inline void
+nm_perf_counter_inc (NMPerfCounter counter)
+{
+	nm_assert (counter < _NM_PERF_COUNTER_NUM);
+	_nm_perf_counters[counter]++;
+}
+
+static inline guint64
+nm_perf_counter_get (NMPerfCounter counter)
+{
+	nm_assert (counter < _NM_PERF_COUNTER_NUM);
+	return _nm_perf_counters[counter];
+}
+
+GVariant *nm_perf_counters_to_variant (void);
+
+#endif /* __NM_PERF_COUNTERS_H__ */
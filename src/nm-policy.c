@@ -48,6 +48,7 @@
 #include "nm-dhcp4-config.h"
 #include "nm-dhcp6-config.h"
 #include "nm-config.h"
+#include "nm-perf-counters.h"
 
 /*****************************************************************************/
 
@@ -1096,6 +1097,8 @@ auto_activate_device (NMPolicy *self,
 	if (nm_device_get_act_request (device))
 		return;
 
+	nm_perf_counter_inc (NM_PERF_COUNTER_AUTOCONNECT_PASSES);
+
 	connections = nm_manager_get_activatable_connections (priv->manager, &len, TRUE);
 	if (!connections[0])
 		return;
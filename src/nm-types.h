@@ -54,6 +54,7 @@ typedef struct _NMSessionMonitor     NMSessionMonitor;
 typedef struct _NMSleepMonitor       NMSleepMonitor;
 typedef struct _NMLldpListener       NMLldpListener;
 typedef struct _NMConfigDeviceStateData NMConfigDeviceStateData;
+typedef struct _NMMatchSpecCompiled NMMatchSpecCompiled;
 
 /*****************************************************************************/
 
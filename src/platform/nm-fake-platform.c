@@ -44,6 +44,7 @@ typedef struct {
 	char *udi;
 	NMPObject *lnk;
 	struct in6_addr ip6_lladdr;
+	guint64 generation;
 } NMFakePlatformLink;
 
 typedef struct {
@@ -53,6 +54,7 @@ typedef struct {
 	GArray *ip6_addresses;
 	GArray *ip4_routes;
 	GArray *ip6_routes;
+	guint64 generation;
 } NMFakePlatformPrivate;
 
 struct _NMFakePlatform {
@@ -1382,6 +1384,38 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint
 
 /*****************************************************************************/
 
+/* like NMPCache, every change bumps the generation of the whole platform
+ * and of the link it belongs to. */
+static void
+_changed_cb (NMPlatform *platform,
+             int obj_type_i,
+             int ifindex,
+             gconstpointer obj,
+             int change_type_i,
+             gpointer user_data)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE ((NMFakePlatform *) platform);
+
+	priv->generation++;
+	if (ifindex > 0 && ifindex < priv->links->len)
+		g_array_index (priv->links, NMFakePlatformLink, ifindex).generation = priv->generation;
+}
+
+static guint64
+cache_get_generation (NMPlatform *platform, int ifindex)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE ((NMFakePlatform *) platform);
+	NMFakePlatformLink *device;
+
+	if (ifindex <= 0)
+		return priv->generation;
+
+	device = link_get (platform, ifindex);
+	return device ? device->generation : 0;
+}
+
+/*****************************************************************************/
+
 static void
 nm_fake_platform_init (NMFakePlatform *fake_platform)
 {
@@ -1393,6 +1427,12 @@ nm_fake_platform_init (NMFakePlatform *fake_platform)
 	priv->ip6_addresses = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP6Address));
 	priv->ip4_routes = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP4Route));
 	priv->ip6_routes = g_array_new (TRUE, TRUE, sizeof (NMPlatformIP6Route));
+
+	g_signal_connect (fake_platform, NM_PLATFORM_SIGNAL_LINK_CHANGED, G_CALLBACK (_changed_cb), NULL);
+	g_signal_connect (fake_platform, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, G_CALLBACK (_changed_cb), NULL);
+	g_signal_connect (fake_platform, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, G_CALLBACK (_changed_cb), NULL);
+	g_signal_connect (fake_platform, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (_changed_cb), NULL);
+	g_signal_connect (fake_platform, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, G_CALLBACK (_changed_cb), NULL);
 }
 
 void
@@ -1449,6 +1489,8 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
 
+	platform_class->cache_get_generation = cache_get_generation;
+
 	platform_class->link_get = _nm_platform_link_get;
 	platform_class->link_get_by_ifname = _nm_platform_link_get_by_ifname;
 	platform_class->link_get_by_address = _nm_platform_link_get_by_address;
@@ -24,6 +24,7 @@
 #include <endian.h>
 #include <errno.h>
 #include <unistd.h>
+#include <sched.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -48,6 +49,7 @@
 #include "nmp-object.h"
 #include "nmp-netns.h"
 #include "nm-platform-utils.h"
+#include "nm-perf-counters.h"
 #include "wifi/wifi-utils.h"
 #include "wifi/wifi-utils-wext.h"
 #include "nm-utils/unaligned.h"
@@ -59,6 +61,14 @@
 #define _NLE_NM_NOBUFS 500
 #define _NLE_MSG_TRUNC 501
 
+#ifndef SOL_NETLINK
+#define SOL_NETLINK                     270
+#endif
+
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK          12
+#endif
+
 /*****************************************************************************/
 
 #define IFQDISCSIZ                      32
@@ -257,6 +267,7 @@ static void do_request_link_no_delayed_actions (NMPlatform *platform, int ifinde
 static void do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType action_type);
 static void cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMPCacheOpsType ops_type, gpointer user_data);
 static void cache_prune_candidates_prune (NMPlatform *platform);
+static void cache_populate_schedule (NMPlatform *platform);
 static gboolean event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks);
 static void ASSERT_NETNS_CURRENT (NMPlatform *platform);
 
@@ -318,6 +329,84 @@ _support_user_ipv6ll_detect (struct nlattr **tb)
 	}
 }
 
+/******************************************************************
+ * Ignored route protocols
+ ******************************************************************/
+
+/* Routes with one of these rtm_protocol values are dropped while parsing
+ * netlink messages, so they never enter the cache. This is for routers
+ * where a routing daemon installs a full table into the main table. */
+static guint32 _route_protocols_ignored[256 / 32];
+
+#define _route_protocol_is_ignored(rtprot) \
+	NM_FLAGS_HAS (_route_protocols_ignored[((guint8) (rtprot)) / 32], 1u << (((guint8) (rtprot)) % 32))
+
+static const struct {
+	const char *name;
+	guint8 rtprot;
+} _route_protocol_names[] = {
+	{ "gated",   8 },
+	{ "zebra",   11 },
+	{ "bird",    12 },
+	{ "xorp",    14 },
+	{ "ntk",     15 },
+	{ "mrouted", 17 },
+	{ "babel",   42 },
+	{ "bgp",     186 },
+	{ "isis",    187 },
+	{ "ospf",    188 },
+	{ "rip",     189 },
+};
+
+/**
+ * nm_linux_platform_set_ignored_route_protocols:
+ * @spec: (allow-none): a list of route protocols, separated by
+ *   commas or spaces. Each is either a name like "bgp" or a number.
+ *
+ * Routes with one of these protocols are ignored by all #NMLinuxPlatform
+ * instances from now on. Protocols that NetworkManager itself uses for its
+ * routes cannot be ignored. Call this before creating the platform, as
+ * routes already in the cache are not removed.
+ */
+void
+nm_linux_platform_set_ignored_route_protocols (const char *spec)
+{
+	gs_strfreev char **tokens = NULL;
+	guint i, j;
+
+	memset (_route_protocols_ignored, 0, sizeof (_route_protocols_ignored));
+
+	if (!spec)
+		return;
+
+	tokens = _nm_utils_strsplit_set (spec, " \t,", 0);
+	for (i = 0; tokens && tokens[i]; i++) {
+		gint64 rtprot = -1;
+
+		for (j = 0; j < G_N_ELEMENTS (_route_protocol_names); j++) {
+			if (nm_streq (tokens[i], _route_protocol_names[j].name)) {
+				rtprot = _route_protocol_names[j].rtprot;
+				break;
+			}
+		}
+		if (rtprot < 0)
+			rtprot = _nm_utils_ascii_str_to_int64 (tokens[i], 10, 0, 255, -1);
+
+		if (rtprot < 0) {
+			_LOG2W ("route-filter: ignore invalid route protocol \"%s\"", tokens[i]);
+			continue;
+		}
+		if (NM_IN_SET (rtprot, RTPROT_UNSPEC, RTPROT_REDIRECT, RTPROT_KERNEL, RTPROT_BOOT,
+		                       RTPROT_STATIC, RTPROT_RA, RTPROT_DHCP)) {
+			_LOG2W ("route-filter: cannot ignore route protocol \"%s\" which is used by NetworkManager", tokens[i]);
+			continue;
+		}
+
+		_route_protocols_ignored[rtprot / 32] |= (1u << (rtprot % 32));
+		_LOG2I ("route-filter: ignore routes with protocol %d", (int) rtprot);
+	}
+}
+
 /******************************************************************
  * Various utilities
  ******************************************************************/
@@ -713,11 +802,19 @@ _linktype_get_type (NMPlatform *platform,
 	}
 
 	{
+		nm_auto_pop_netns NMPNetns *netns = NULL;
 		nm_auto_close int dirfd = -1;
 		gs_free char *devtype = NULL;
 		char ifname_verified[IFNAMSIZ];
 
-		dirfd = nmp_utils_sysctl_open_netdir (ifindex, ifname, ifname_verified);
+		/* netlink is only handled with the network namespace of the platform
+		 * instance switched. /sys/class/net also needs its mount namespace. */
+		if (   !platform
+		    || !platform->_netns
+		    || nmp_netns_push_type (platform->_netns, CLONE_NEWNS)) {
+			netns = platform ? platform->_netns : NULL;
+			dirfd = nmp_utils_sysctl_open_netdir (ifindex, ifname, ifname_verified);
+		}
 		if (dirfd >= 0) {
 			if (faccessat (dirfd, "anycast_mask", F_OK, 0) == 0)
 				return NM_LINK_TYPE_OLPC_MESH;
@@ -1861,6 +1958,9 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 	if (table != RT_TABLE_MAIN)
 		goto errout;
 
+	if (_route_protocol_is_ignored (rtm->rtm_protocol))
+		goto errout;
+
 	/*****************************************************************/
 
 	is_v4 = rtm->rtm_family == AF_INET;
@@ -2545,6 +2645,17 @@ typedef struct {
 	GIOChannel *event_channel;
 	guint event_id;
 
+	/* whether the kernel accepted NETLINK_GET_STRICT_CHK. In that case,
+	 * dump requests carry the full header and the kernel filters them. */
+	bool strict_dump:1;
+
+	/* for platform instances created with NM_LINUX_PLATFORM_LAZY_POPULATE,
+	 * the initial dump is deferred until nm_linux_platform_populate(). */
+	bool populate_pending:1;
+
+	/* whether the instance is registered by nm_linux_platform_get_for_netns(). */
+	bool netns_registered:1;
+
 	gboolean sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
 
@@ -2584,6 +2695,13 @@ G_DEFINE_TYPE (NMLinuxPlatform, nm_linux_platform, NM_TYPE_PLATFORM)
 
 #define NM_LINUX_PLATFORM_GET_PRIVATE(self) _NM_GET_PRIVATE_VOID(self, NMLinuxPlatform, NM_IS_LINUX_PLATFORM)
 
+NM_GOBJECT_PROPERTIES_DEFINE_BASE (
+	PROP_LAZY_POPULATE,
+);
+
+/* platform instances by #NMPNetns, see nm_linux_platform_get_for_netns(). */
+static GHashTable *_netns_platforms;
+
 NMPlatform *
 nm_linux_platform_new (gboolean netns_support)
 {
@@ -2602,6 +2720,76 @@ nm_linux_platform_setup (void)
 	              NULL);
 }
 
+/**
+ * nm_linux_platform_get_for_netns:
+ * @netns: the network namespace
+ *
+ * Returns the platform instance for @netns, creating it if there is
+ * none yet. All instances have their own netlink socket and cache, but
+ * attach to the default main context, so one main loop serves all of
+ * them. The cache of a newly created instance is empty until the caller
+ * populates it with nm_linux_platform_populate().
+ *
+ * Returns: (transfer full): the platform instance or %NULL if switching
+ *   to @netns failed.
+ */
+NMPlatform *
+nm_linux_platform_get_for_netns (NMPNetns *netns)
+{
+	nm_auto_pop_netns NMPNetns *netns_pop = NULL;
+	NMPlatform *platform;
+
+	g_return_val_if_fail (NMP_IS_NETNS (netns), NULL);
+
+	if (G_UNLIKELY (!_netns_platforms))
+		_netns_platforms = g_hash_table_new (NULL, NULL);
+	else {
+		platform = g_hash_table_lookup (_netns_platforms, netns);
+		if (platform)
+			return g_object_ref (platform);
+	}
+
+	if (!nmp_netns_push (netns))
+		return NULL;
+	netns_pop = netns;
+
+	platform = g_object_new (NM_TYPE_LINUX_PLATFORM,
+	                         NM_PLATFORM_REGISTER_SINGLETON, FALSE,
+	                         NM_PLATFORM_NETNS_SUPPORT, TRUE,
+	                         NM_LINUX_PLATFORM_LAZY_POPULATE, TRUE,
+	                         NULL);
+	nm_assert (platform->_netns == netns);
+
+	NM_LINUX_PLATFORM_GET_PRIVATE (platform)->netns_registered = TRUE;
+	g_hash_table_insert (_netns_platforms, netns, platform);
+	return platform;
+}
+
+/**
+ * nm_linux_platform_populate:
+ * @platform: the platform instance
+ *
+ * Fills the cache of an instance from nm_linux_platform_get_for_netns()
+ * with a full dump, if that did not happen yet. Getters never populate
+ * the cache on their own, so callers are expected to do this once
+ * before they first read from it. Must not be called while the instance
+ * emits signals.
+ */
+void
+nm_linux_platform_populate (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv;
+
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+
+	priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	if (!priv->populate_pending)
+		return;
+
+	cache_populate_schedule (platform);
+	delayed_action_handle_all (platform, FALSE);
+}
+
 static void
 ASSERT_NETNS_CURRENT (NMPlatform *platform)
 {
@@ -3249,6 +3437,21 @@ delayed_action_handle_one (NMPlatform *platform)
 	return FALSE;
 }
 
+static void
+cache_populate_schedule (NMPlatform *platform)
+{
+	NM_LINUX_PLATFORM_GET_PRIVATE (platform)->populate_pending = FALSE;
+
+	_LOGD ("populate platform cache");
+	delayed_action_schedule (platform,
+	                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
+	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
+	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
+	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
+	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+	                         NULL);
+}
+
 static gboolean
 delayed_action_handle_all (NMPlatform *platform, gboolean read_netlink)
 {
@@ -3692,6 +3895,7 @@ _nl_send_auto_with_seq (NMPlatform *platform,
 
 	if (nle >= 0) {
 		nle = 0;
+		nm_perf_counter_inc (NM_PERF_COUNTER_NETLINK_SEND);
 		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, seq, out_seq_result, out_refresh_all_in_progess);
 	} else
 		_LOGD ("netlink: send: failed sending message: %s (%d)", nl_geterror (nle), nle);
@@ -3736,6 +3940,53 @@ do_request_link (NMPlatform *platform, int ifindex, const char *name)
 	delayed_action_handle_all (platform, FALSE);
 }
 
+static int
+_nl_msg_append_dump_header (NMPlatform *platform, struct nl_msg *nlmsg, const NMPClass *klass)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (!priv->strict_dump) {
+		struct rtgenmsg gmsg = {
+			.rtgen_family = klass->addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
+	}
+
+	/* with strict checking, the kernel requires the full header of the
+	 * message type and uses its fields as filter. */
+	switch (klass->obj_type) {
+	case NMP_OBJECT_TYPE_LINK: {
+		struct ifinfomsg ifi = {
+			.ifi_family = klass->addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &ifi, sizeof (ifi), NLMSG_ALIGNTO);
+	}
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+	case NMP_OBJECT_TYPE_IP6_ADDRESS: {
+		struct ifaddrmsg ifa = {
+			.ifa_family = klass->addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &ifa, sizeof (ifa), NLMSG_ALIGNTO);
+	}
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE: {
+		struct rtmsg rtm = {
+			.rtm_family = klass->addr_family,
+			/* we only cache routes from the main table. Let the kernel
+			 * skip the others instead of parsing and dropping them. */
+			.rtm_table = RT_TABLE_MAIN,
+		};
+
+		return nlmsg_append (nlmsg, &rtm, sizeof (rtm), NLMSG_ALIGNTO);
+	}
+	default:
+		g_return_val_if_reached (-NLE_BUG);
+	}
+}
+
 static void
 do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType action_type)
 {
@@ -3753,9 +4004,6 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 		NMPObjectType obj_type = delayed_action_refresh_to_object_type (iflags);
 		const NMPClass *klass = nmp_class_from_type (obj_type);
 		nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-		struct rtgenmsg gmsg = {
-			.rtgen_family = klass->addr_family,
-		};
 		int nle;
 		gint *out_refresh_all_in_progess;
 
@@ -3782,7 +4030,7 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 		if (!nlmsg)
 			continue;
 
-		nle = nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
+		nle = _nl_msg_append_dump_header (platform, nlmsg, klass);
 		if (nle < 0)
 			continue;
 
@@ -3935,6 +4183,31 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 
 /*****************************************************************************/
 
+/* like nm_platform_netns_push(), but only switches the network namespace.
+ * That is all the netlink socket and the ethtool/MII ioctls depend on, and
+ * it spares two setns() calls for the mount namespace on every event and
+ * request of a platform instance that lives in another namespace. The only
+ * access to sysfs while handling netlink, in _linktype_get_type(), switches
+ * the mount namespace itself. */
+static gboolean
+_netns_push_net (NMPlatform *platform, NMPNetns **netns)
+{
+	if (   platform->_netns
+	    && !nmp_netns_push_type (platform->_netns, CLONE_NEWNET)) {
+		NM_SET_OUT (netns, NULL);
+		return FALSE;
+	}
+
+	NM_SET_OUT (netns, platform->_netns);
+	return TRUE;
+}
+
+static guint64
+cache_get_generation (NMPlatform *platform, int ifindex)
+{
+	return nmp_cache_get_generation (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, ifindex);
+}
+
 static const NMPObject *
 cache_lookup_link (NMPlatform *platform, int ifindex)
 {
@@ -3960,10 +4233,9 @@ nm_linux_platform_lookup (NMPlatform *platform, const NMPCacheId *cache_id, guin
 static GArray *
 link_get_all (NMPlatform *platform)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	NMPCacheId cache_id;
 
-	return nmp_cache_lookup_multi_to_array (priv->cache,
+	return nmp_cache_lookup_multi_to_array (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
 	                                        NMP_OBJECT_TYPE_LINK,
 	                                        nmp_cache_id_init_object_type (&cache_id, NMP_OBJECT_TYPE_LINK, TRUE));
 }
@@ -4233,7 +4505,7 @@ do_change_link_request (NMPlatform *platform,
 	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
 	int nle;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
 
 retry:
@@ -4578,7 +4850,7 @@ link_supports_carrier_detect (NMPlatform *platform, int ifindex)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return FALSE;
 
 	/* We use netlink for the actual carrier detection, but netlink can't tell
@@ -4600,7 +4872,7 @@ link_supports_vlans (NMPlatform *platform, int ifindex)
 	if (!obj || obj->link.arptype != ARPHRD_ETHER)
 		return FALSE;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return FALSE;
 
 	return nmp_utils_ethtool_supports_vlans (ifindex);
@@ -4668,7 +4940,7 @@ link_get_permanent_address (NMPlatform *platform,
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return FALSE;
 
 	return nmp_utils_ethtool_get_permanent_address (ifindex, buf, length);
@@ -5708,7 +5980,7 @@ link_get_driver_info (NMPlatform *platform,
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMPUtilsEthtoolDriverInfo driver_info;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return FALSE;
 
 	if (!nmp_utils_ethtool_get_driver_info (ifindex, &driver_info))
@@ -5724,12 +5996,11 @@ link_get_driver_info (NMPlatform *platform,
 static GArray *
 ipx_address_get_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	NMPCacheId cache_id;
 
 	nm_assert (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS));
 
-	return nmp_cache_lookup_multi_to_array (priv->cache,
+	return nmp_cache_lookup_multi_to_array (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
 	                                        obj_type,
 	                                        nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id,
 	                                                                                        obj_type,
@@ -5890,7 +6161,6 @@ ip6_address_get (NMPlatform *platform, int ifindex, struct in6_addr addr, guint8
 static GArray *
 ipx_route_get_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type, NMPlatformGetRouteFlags flags)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	NMPCacheId cache_id;
 	const NMPlatformIPRoute *const* routes;
 	GArray *array;
@@ -5911,7 +6181,7 @@ ipx_route_get_all (NMPlatform *platform, int ifindex, NMPObjectType obj_type, NM
 	                                  NM_FLAGS_HAS (flags, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT),
 	                                  ifindex);
 
-	routes = (const NMPlatformIPRoute *const*) nmp_cache_lookup_multi (priv->cache, &cache_id, &len);
+	routes = (const NMPlatformIPRoute *const*) nmp_cache_lookup_multi (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache, &cache_id, &len);
 
 	array = g_array_sized_new (FALSE, FALSE, klass->sizeof_public, len);
 
@@ -6247,6 +6517,8 @@ continue_reading:
 		gboolean process_valid_msg = FALSE;
 		guint32 seq_number;
 
+		nm_perf_counter_inc (NM_PERF_COUNTER_NETLINK_RECV);
+
 		msg = nlmsg_convert (hdr);
 		if (!msg) {
 			err = -NLE_NOMEM;
@@ -6398,7 +6670,7 @@ event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 		gint64 timeout_abs_ns;
 	} data_next;
 
-	if (!nm_platform_netns_push (platform, &netns))
+	if (!_netns_push_net (platform, &netns))
 		return FALSE;
 
 	while (TRUE) {
@@ -6425,6 +6697,7 @@ event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 					            }
 					            _reason;
 					       }));
+					nm_perf_counter_inc (NM_PERF_COUNTER_NETLINK_RESYNC);
 					event_handler_recvmsgs (platform, FALSE);
 					delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
 					delayed_action_schedule (platform,
@@ -6648,6 +6921,23 @@ nm_linux_platform_init (NMLinuxPlatform *self)
 	}
 }
 
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_LAZY_POPULATE:
+		/* construct-only */
+		priv->populate_pending = g_value_get_boolean (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
 static void
 constructed (GObject *_object)
 {
@@ -6692,6 +6982,14 @@ constructed (GObject *_object)
 	nle = nl_socket_set_msg_buf_size (priv->nlh, 32 * 1024);
 	g_assert (!nle);
 
+	{
+		int one = 1;
+
+		/* ask the kernel to filter dumps by the header we send (since 4.20). */
+		priv->strict_dump = (setsockopt (nl_socket_get_fd (priv->nlh), SOL_NETLINK, NETLINK_GET_STRICT_CHK, &one, sizeof (one)) == 0);
+		_LOGD ("Netlink socket strict checking for dumps: %s", priv->strict_dump ? "enabled" : "not supported");
+	}
+
 	nle = nl_socket_add_memberships (priv->nlh,
 	                                 RTNLGRP_LINK,
 	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
@@ -6715,16 +7013,12 @@ constructed (GObject *_object)
 	/* complete construction of the GObject instance before populating the cache. */
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->constructed (_object);
 
-	_LOGD ("populate platform cache");
-	delayed_action_schedule (platform,
-	                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
-	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-	                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-	                         NULL);
-
-	delayed_action_handle_all (platform, FALSE);
+	if (priv->populate_pending)
+		_LOGD ("defer populating platform cache until requested");
+	else {
+		cache_populate_schedule (platform);
+		delayed_action_handle_all (platform, FALSE);
+	}
 
 	/* Set up udev monitoring */
 	if (priv->udev_client) {
@@ -6779,6 +7073,9 @@ finalize (GObject *object)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
 
+	if (priv->netns_registered)
+		g_hash_table_remove (_netns_platforms, NM_PLATFORM (object)->_netns);
+
 	nmp_cache_free (priv->cache);
 
 	g_ptr_array_unref (priv->delayed_action.list_master_connected);
@@ -6807,10 +7104,19 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMPlatformClass *platform_class = NM_PLATFORM_CLASS (klass);
 
+	object_class->set_property = set_property;
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 	object_class->finalize = finalize;
 
+	obj_properties[PROP_LAZY_POPULATE]
+	    = g_param_spec_boolean (NM_LINUX_PLATFORM_LAZY_POPULATE, "", "",
+	                            FALSE,
+	                            G_PARAM_WRITABLE |
+	                            G_PARAM_CONSTRUCT_ONLY |
+	                            G_PARAM_STATIC_STRINGS);
+	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
+
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
 
@@ -6910,5 +7216,6 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->check_support_user_ipv6ll = check_support_user_ipv6ll;
 
 	platform_class->process_events = process_events;
+	platform_class->cache_get_generation = cache_get_generation;
 }
 
@@ -30,6 +30,8 @@
 #define NM_IS_LINUX_PLATFORM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_LINUX_PLATFORM))
 #define NM_LINUX_PLATFORM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_LINUX_PLATFORM, NMLinuxPlatformClass))
 
+#define NM_LINUX_PLATFORM_LAZY_POPULATE   "lazy-populate"
+
 typedef struct _NMLinuxPlatform NMLinuxPlatform;
 typedef struct _NMLinuxPlatformClass NMLinuxPlatformClass;
 
@@ -39,6 +41,12 @@ NMPlatform *nm_linux_platform_new (gboolean netns_support);
 
 void nm_linux_platform_setup (void);
 
+NMPlatform *nm_linux_platform_get_for_netns (NMPNetns *netns);
+
+void nm_linux_platform_populate (NMPlatform *platform);
+
+void nm_linux_platform_set_ignored_route_protocols (const char *spec);
+
 struct _NMPCacheId;
 
 const NMPlatformObject *const *nm_linux_platform_lookup (NMPlatform *platform,
@@ -40,6 +40,7 @@
 #include "nm-platform-utils.h"
 #include "nmp-object.h"
 #include "nmp-netns.h"
+#include "nm-perf-counters.h"
 
 /*****************************************************************************/
 
@@ -263,6 +264,33 @@ nm_platform_process_events (NMPlatform *self)
 		klass->process_events (self);
 }
 
+/**
+ * nm_platform_cache_get_generation:
+ * @self: platform instance
+ * @ifindex: the ifindex or 0
+ *
+ * The generation of the platform cache changes whenever the cached
+ * state changes. Processing events, which many platform calls do as
+ * a side effect, can change it. Callers that read several objects
+ * can compare the generation before and after to know whether they
+ * saw one consistent state. They can also skip recomputing a result
+ * while the generation stays the same.
+ *
+ * Returns: the generation of the whole cache for @ifindex 0.
+ *   Otherwise the generation of the last change to the link
+ *   @ifindex or its addresses and routes. 0 means the generation
+ *   is unknown, and it never compares equal to an earlier value.
+ */
+guint64
+nm_platform_cache_get_generation (NMPlatform *self, int ifindex)
+{
+	_CHECK_SELF (self, klass, 0);
+
+	if (klass->cache_get_generation)
+		return klass->cache_get_generation (self, ifindex);
+	return 0;
+}
+
 /*****************************************************************************/
 
 /**
@@ -316,6 +344,7 @@ nm_platform_sysctl_set (NMPlatform *self, const char *pathid, int dirfd, const c
 	g_return_val_if_fail (path, FALSE);
 	g_return_val_if_fail (value, FALSE);
 
+	nm_perf_counter_inc (NM_PERF_COUNTER_SYSCTL_WRITE);
 	return klass->sysctl_set (self, pathid, dirfd, path, value);
 }
 
@@ -370,6 +399,7 @@ nm_platform_sysctl_get (NMPlatform *self, const char *pathid, int dirfd, const c
 
 	g_return_val_if_fail (path, NULL);
 
+	nm_perf_counter_inc (NM_PERF_COUNTER_SYSCTL_READ);
 	return klass->sysctl_get (self, pathid, dirfd, path);
 }
 
@@ -69,6 +69,9 @@ struct _NMPCache {
 	GHashTable *idx_main;
 	NMMultiIndex *idx_multi;
 
+	/* incremented on every change to the cache. */
+	guint64 generation;
+
 	gboolean use_udev;
 };
 
@@ -1615,24 +1618,97 @@ _nmp_cache_update_cache (NMPCache *cache, NMPObject *obj, gboolean remove)
 	}
 }
 
+/* number of cached objects per type, summed over all caches. */
+static guint _nmp_cache_object_counts[__NMP_OBJECT_TYPE_LAST];
+
+guint
+nmp_cache_get_total_object_count (NMPObjectType obj_type)
+{
+	g_return_val_if_fail (obj_type < __NMP_OBJECT_TYPE_LAST, 0);
+
+	return _nmp_cache_object_counts[obj_type];
+}
+
+/* start a new generation for a change of @obj. The link of @obj, if cached,
+ * remembers it as the generation of its last change. */
+static void
+_nmp_cache_generation_bump (NMPCache *cache, const NMPObject *obj)
+{
+	NMPObject obj_id;
+	NMPObject *obj_link;
+
+	cache->generation++;
+
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_LINK:
+		obj_link = (NMPObject *) obj;
+		break;
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (obj->object.ifindex <= 0)
+			return;
+		obj_link = g_hash_table_lookup (cache->idx_main,
+		                                nmp_object_stackinit_id_link (&obj_id, obj->object.ifindex));
+		if (!obj_link)
+			return;
+		break;
+	default:
+		return;
+	}
+
+	obj_link->_link.cache_generation = cache->generation;
+}
+
+/**
+ * nmp_cache_get_generation:
+ * @cache: the #NMPCache
+ * @ifindex: the ifindex or 0
+ *
+ * Returns: for @ifindex 0, the current generation of @cache, which
+ *   changes whenever the content of the cache changes. Otherwise, the
+ *   generation when the link with @ifindex, or any of its addresses or
+ *   routes, last changed. That is 0 if the link is not in the cache.
+ *   Two equal non-zero values returned for the same @ifindex mean that
+ *   the cached state did not change in between.
+ */
+guint64
+nmp_cache_get_generation (const NMPCache *cache, int ifindex)
+{
+	const NMPObject *obj_link;
+
+	g_return_val_if_fail (cache, 0);
+
+	if (ifindex <= 0)
+		return cache->generation;
+
+	obj_link = nmp_cache_lookup_link (cache, ifindex);
+	return obj_link ? obj_link->_link.cache_generation : 0;
+}
+
 static void
 _nmp_cache_update_add (NMPCache *cache, NMPObject *obj)
 {
 	nm_assert (!obj->is_cached);
 	nmp_object_ref (obj);
+	_nmp_cache_object_counts[NMP_OBJECT_GET_TYPE (obj)]++;
 	nm_assert (!nm_multi_index_lookup_first_by_value (cache->idx_multi, &obj->object));
 	if (!nm_g_hash_table_add (cache->idx_main, obj))
 		g_assert_not_reached ();
 	obj->is_cached = TRUE;
 	_nmp_cache_update_cache (cache, obj, FALSE);
+	_nmp_cache_generation_bump (cache, obj);
 }
 
 static void
 _nmp_cache_update_remove (NMPCache *cache, NMPObject *obj)
 {
 	nm_assert (obj->is_cached);
+	_nmp_cache_generation_bump (cache, obj);
 	_nmp_cache_update_cache (cache, obj, TRUE);
 	obj->is_cached = FALSE;
+	_nmp_cache_object_counts[NMP_OBJECT_GET_TYPE (obj)]--;
 	if (!g_hash_table_remove (cache->idx_main, obj))
 		g_assert_not_reached ();
 
@@ -1661,6 +1737,7 @@ _nmp_cache_update_update (NMPCache *cache, NMPObject *obj, const NMPObject *new)
 			g_assert_not_reached ();
 	}
 	nmp_object_copy (obj, new, FALSE);
+	_nmp_cache_generation_bump (cache, obj);
 }
 
 NMPCacheOpsType
@@ -2010,6 +2087,7 @@ nmp_cache_new (gboolean use_udev)
 	                                       (NMMultiIndexFuncEqual) nmp_cache_id_equal,
 	                                       (NMMultiIndexFuncClone) nmp_cache_id_clone,
 	                                       (NMMultiIndexFuncDestroy) nmp_cache_id_destroy);
+	cache->generation = 0;
 	cache->use_udev = !!use_udev;
 	return cache;
 }
@@ -2028,6 +2106,7 @@ nmp_cache_free (NMPCache *cache)
 	while (g_hash_table_iter_next (&iter, (gpointer *) &obj, NULL)) {
 		nm_assert (obj->is_cached);
 		obj->is_cached = FALSE;
+		_nmp_cache_object_counts[NMP_OBJECT_GET_TYPE (obj)]--;
 	}
 
 	nm_multi_index_free (cache->idx_multi);
@@ -204,6 +204,10 @@ typedef struct {
 		 */
 		struct udev_device *device;
 	} udev;
+
+	/* the generation of the cache when the link, or any address or route
+	 * on it, last changed. Only maintained for cached instances. */
+	guint64 cache_generation;
 } NMPObjectLink;
 
 typedef struct {
@@ -464,4 +468,8 @@ NMPCacheOpsType nmp_cache_update_link_master_connected (NMPCache *cache, int ifi
 NMPCache *nmp_cache_new (gboolean use_udev);
 void nmp_cache_free (NMPCache *cache);
 
+guint64 nmp_cache_get_generation (const NMPCache *cache, int ifindex);
+
+guint nmp_cache_get_total_object_count (NMPObjectType obj_type);
+
 #endif /* __NMP_OBJECT_H__ */
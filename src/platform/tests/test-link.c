@@ -2085,6 +2085,74 @@ test_netns_set_netns (gpointer fixture, gconstpointer test_data)
 
 /*****************************************************************************/
 
+static void
+test_netns_get_for_netns (gpointer fixture, gconstpointer test_data)
+{
+	gs_unref_object NMPNetns *netns_1 = NULL;
+	gs_unref_object NMPNetns *netns_2 = NULL;
+	gs_unref_object NMPlatform *platform_1 = NULL;
+	gs_unref_object NMPlatform *platform_2 = NULL;
+	NMPlatform *platform_tmp;
+
+	if (_test_netns_check_skip ())
+		return;
+
+	/* create the namespaces with unshare(), but without a platform instance. */
+	netns_1 = nmp_netns_new ();
+	g_assert (NMP_IS_NETNS (netns_1));
+	nmp_netns_pop (netns_1);
+
+	netns_2 = nmp_netns_new ();
+	g_assert (NMP_IS_NETNS (netns_2));
+	nmp_netns_pop (netns_2);
+
+	platform_1 = nm_linux_platform_get_for_netns (netns_1);
+	platform_2 = nm_linux_platform_get_for_netns (netns_2);
+	g_assert (NM_IS_LINUX_PLATFORM (platform_1));
+	g_assert (NM_IS_LINUX_PLATFORM (platform_2));
+	g_assert (platform_1 != platform_2);
+	g_assert (nm_platform_netns_get (platform_1) == netns_1);
+	g_assert (nm_platform_netns_get (platform_2) == netns_2);
+	g_assert (nmp_netns_get_current () != netns_1);
+	g_assert (nmp_netns_get_current () != netns_2);
+
+	platform_tmp = nm_linux_platform_get_for_netns (netns_1);
+	g_assert (platform_tmp == platform_1);
+	g_object_unref (platform_tmp);
+
+	/* the caches stay empty until they are populated explicitly. */
+	g_assert (!nm_platform_link_get (platform_1, 1));
+	nm_linux_platform_populate (platform_1);
+	nm_linux_platform_populate (platform_2);
+	g_assert (nmtstp_link_get_typed (platform_1, 1, "lo", NM_LINK_TYPE_LOOPBACK));
+	g_assert (nmtstp_link_get_typed (platform_2, 1, "lo", NM_LINK_TYPE_LOOPBACK));
+
+	_ADD_DUMMY (platform_1, "dummy-ns1");
+	g_assert ( nm_platform_link_get_by_ifname (platform_1, "dummy-ns1"));
+	g_assert (!nm_platform_link_get_by_ifname (platform_2, "dummy-ns1"));
+
+	/* a link added behind our back is seen through the event socket of
+	 * the right instance while running the default main loop. */
+	{
+		nm_auto_pop_netns NMPNetns *netns_pop = NULL;
+
+		g_assert (nmp_netns_push (netns_2));
+		netns_pop = netns_2;
+		nmtstp_run_command_check ("ip link add dummy-ns2 type dummy");
+	}
+	nmtstp_assert_wait_for_link (platform_2, "dummy-ns2", NM_LINK_TYPE_DUMMY, 100);
+	g_assert (!nm_platform_link_get_by_ifname (platform_1, "dummy-ns2"));
+
+	/* once the last reference is gone, a new instance is created. */
+	g_clear_object (&platform_2);
+	platform_2 = nm_linux_platform_get_for_netns (netns_2);
+	g_assert (NM_IS_LINUX_PLATFORM (platform_2));
+	nm_linux_platform_populate (platform_2);
+	g_assert (nm_platform_link_get_by_ifname (platform_2, "dummy-ns2"));
+}
+
+/*****************************************************************************/
+
 static char *
 _get_current_namespace_id (int ns_type)
 {
@@ -2539,6 +2607,7 @@ _nmtstp_setup_tests (void)
 		g_test_add_vtable ("/general/netns/set-netns", 0, NULL, _test_netns_setup, test_netns_set_netns, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/push", 0, NULL, _test_netns_setup, test_netns_push, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/bind-to-path", 0, NULL, _test_netns_setup, test_netns_bind_to_path, _test_netns_teardown);
+		g_test_add_vtable ("/general/netns/get-for-netns", 0, NULL, _test_netns_setup, test_netns_get_for_netns, _test_netns_teardown);
 
 		g_test_add_func ("/general/sysctl/rename", test_sysctl_rename);
 		g_test_add_func ("/general/sysctl/netns-switch", test_sysctl_netns_switch);
@@ -20,6 +20,8 @@
 
 #include "nm-default.h"
 
+#include <arpa/inet.h>
+#include <unistd.h>
 #include <libudev.h>
 
 #include "platform/nmp-object.h"
@@ -387,6 +389,258 @@ test_cache_link (void)
 
 /*****************************************************************************/
 
+#define CHURN_N_IFINDEXES 16
+
+static int
+_churn_route_ifindex (guint idx)
+{
+	return 1 + (idx % CHURN_N_IFINDEXES);
+}
+
+static void
+_churn_route_update (NMPCache *cache, guint idx, gboolean add)
+{
+	const NMPlatformIP4Route r = {
+		.ifindex = _churn_route_ifindex (idx),
+		.network = htonl (0x0A000000u + idx),
+		.plen = 32,
+		.metric = 100,
+	};
+	NMPCacheOpsType ops_type;
+
+	if (add) {
+		nm_auto_nmpobj NMPObject *obj = NULL;
+
+		obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) &r);
+		ops_type = nmp_cache_update_netlink (cache, obj, NULL, NULL, NULL, NULL);
+		g_assert_cmpint (ops_type, ==, NMP_CACHE_OPS_ADDED);
+	} else {
+		NMPObject obj_stack;
+
+		nmp_object_stackinit (&obj_stack, NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) &r);
+		ops_type = nmp_cache_remove_netlink (cache, &obj_stack, NULL, NULL, NULL, NULL);
+		g_assert_cmpint (ops_type, ==, NMP_CACHE_OPS_REMOVED);
+	}
+}
+
+static void
+test_cache_route_churn (void)
+{
+	/* With "-m perf", simulate a routing table of 100k routes that sees
+	 * 1000 changes per second, where each change is followed by a reader
+	 * looking up the routes of the affected interface. Otherwise, run
+	 * a scaled down version that only checks correctness. */
+	const gboolean perf = g_test_perf ();
+	const guint n_routes = perf ? 100000 : 2000;
+	const guint n_changes = perf ? 1000 : 100;
+	const guint n_rounds = perf ? 30 : 3;
+	NMPCache *cache;
+	gs_free gboolean *present = NULL;
+	guint n_present[CHURN_N_IFINDEXES + 1] = { 0 };
+	NMPCacheId cache_id_storage;
+	const NMPlatformObject *const *objects;
+	guint i, j, round, len;
+	gdouble elapsed, elapsed_max = 0;
+
+	cache = nmp_cache_new (FALSE);
+	present = g_new0 (gboolean, n_routes);
+
+	for (i = 0; i < n_routes; i++) {
+		_churn_route_update (cache, i, TRUE);
+		present[i] = TRUE;
+		n_present[_churn_route_ifindex (i)]++;
+	}
+
+	objects = nmp_cache_lookup_multi (cache, nmp_cache_id_init_object_type (&cache_id_storage, NMP_OBJECT_TYPE_IP4_ROUTE, TRUE), &len);
+	g_assert_cmpint (len, ==, n_routes);
+	g_assert (objects && !objects[len]);
+
+	for (round = 0; round < n_rounds; round++) {
+		g_test_timer_start ();
+		for (j = 0; j < n_changes; j++) {
+			i = nmtst_get_rand_int () % n_routes;
+
+			_churn_route_update (cache, i, !present[i]);
+			present[i] = !present[i];
+			if (present[i])
+				n_present[_churn_route_ifindex (i)]++;
+			else
+				n_present[_churn_route_ifindex (i)]--;
+
+			objects = nmp_cache_lookup_multi (cache,
+			                                  nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id_storage, NMP_OBJECT_TYPE_IP4_ROUTE, _churn_route_ifindex (i)),
+			                                  &len);
+			g_assert_cmpint (len, ==, n_present[_churn_route_ifindex (i)]);
+			g_assert (!objects || !objects[len]);
+		}
+		elapsed = g_test_timer_elapsed ();
+		elapsed_max = MAX (elapsed_max, elapsed);
+		g_test_message ("route churn: round %u: %u changes on %u routes took %.3f msec",
+		                round, n_changes, n_routes, elapsed * 1000);
+	}
+
+	if (perf) {
+		g_test_minimized_result (elapsed_max,
+		                         "route churn: slowest round of %u changes on %u routes: %.3f sec",
+		                         n_changes, n_routes, elapsed_max);
+	}
+
+	for (i = 1; i <= CHURN_N_IFINDEXES; i++) {
+		nmp_cache_lookup_multi (cache,
+		                        nmp_cache_id_init_addrroute_visible_by_ifindex (&cache_id_storage, NMP_OBJECT_TYPE_IP4_ROUTE, i),
+		                        &len);
+		g_assert_cmpint (len, ==, n_present[i]);
+	}
+
+	ASSERT_nmp_cache_is_consistent (cache);
+	nmp_cache_free (cache);
+}
+
+static void
+test_cache_generation (void)
+{
+	NMPCache *cache;
+	nm_auto_nmpobj NMPObject *obj_link = NULL;
+	nm_auto_nmpobj NMPObject *obj_link_3 = NULL;
+	nm_auto_nmpobj NMPObject *obj_route = NULL;
+	NMPlatformIP4Route r = {
+		.ifindex = pl_link_2.ifindex,
+		.network = htonl (0x0A000000u),
+		.plen = 24,
+	};
+	guint64 gen, gen_2, gen_3;
+
+	cache = nmp_cache_new (FALSE);
+	g_assert_cmpint (nmp_cache_get_generation (cache, 0), ==, 0);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_2.ifindex), ==, 0);
+
+	obj_link = nmp_object_new (NMP_OBJECT_TYPE_LINK, (NMPlatformObject *) &pl_link_2);
+	obj_link->_link.netlink.is_in_netlink = TRUE;
+	g_assert_cmpint (nmp_cache_update_netlink (cache, obj_link, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_ADDED);
+	obj_link_3 = nmp_object_new (NMP_OBJECT_TYPE_LINK, (NMPlatformObject *) &pl_link_3);
+	obj_link_3->_link.netlink.is_in_netlink = TRUE;
+	g_assert_cmpint (nmp_cache_update_netlink (cache, obj_link_3, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_ADDED);
+
+	gen = nmp_cache_get_generation (cache, 0);
+	gen_2 = nmp_cache_get_generation (cache, pl_link_2.ifindex);
+	gen_3 = nmp_cache_get_generation (cache, pl_link_3.ifindex);
+	g_assert_cmpint (gen, ==, 2);
+	g_assert_cmpint (gen_2, >, 0);
+	g_assert_cmpint (gen_3, >, gen_2);
+
+	/* an unchanged update keeps the generation. */
+	g_clear_pointer (&obj_link, nmp_object_unref);
+	obj_link = nmp_object_new (NMP_OBJECT_TYPE_LINK, (NMPlatformObject *) &pl_link_2);
+	obj_link->_link.netlink.is_in_netlink = TRUE;
+	g_assert_cmpint (nmp_cache_update_netlink (cache, obj_link, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_UNCHANGED);
+	g_assert_cmpint (nmp_cache_get_generation (cache, 0), ==, gen);
+
+	/* adding, updating and removing a route changes the generation of
+	 * its link, but not that of other links. */
+	obj_route = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) &r);
+	g_assert_cmpint (nmp_cache_update_netlink (cache, obj_route, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_ADDED);
+	g_assert_cmpint (nmp_cache_get_generation (cache, 0), >, gen);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_2.ifindex), ==, nmp_cache_get_generation (cache, 0));
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_3.ifindex), ==, gen_3);
+	gen = nmp_cache_get_generation (cache, 0);
+
+	g_clear_pointer (&obj_route, nmp_object_unref);
+	r.mss = 1400;
+	obj_route = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) &r);
+	g_assert_cmpint (nmp_cache_update_netlink (cache, obj_route, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_UPDATED);
+	g_assert_cmpint (nmp_cache_get_generation (cache, 0), ==, gen + 1);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_2.ifindex), ==, gen + 1);
+	gen = nmp_cache_get_generation (cache, 0);
+
+	g_assert_cmpint (nmp_cache_remove (cache, obj_route, FALSE, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_REMOVED);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_2.ifindex), ==, gen + 1);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_3.ifindex), ==, gen_3);
+	ASSERT_nmp_cache_is_consistent (cache);
+
+	/* once the link is gone, its generation is unknown. */
+	g_assert_cmpint (nmp_cache_remove (cache, obj_link, FALSE, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_REMOVED);
+	g_assert_cmpint (nmp_cache_get_generation (cache, 0), ==, gen + 2);
+	g_assert_cmpint (nmp_cache_get_generation (cache, pl_link_2.ifindex), ==, 0);
+
+	nmp_cache_free (cache);
+}
+
+static gsize
+_get_rss (void)
+{
+	gs_free char *contents = NULL;
+	unsigned long size, resident;
+
+	if (   !g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL)
+	    || sscanf (contents, "%lu %lu", &size, &resident) != 2)
+		return 0;
+	return (gsize) resident * sysconf (_SC_PAGESIZE);
+}
+
+static void
+test_cache_route_memory (void)
+{
+	/* With "-m perf", fill the cache with a synthetic full IPv6 table
+	 * of 1M routes and report the memory it takes per route.
+	 *
+	 * Besides the object itself, a route takes an entry in the cache
+	 * and in each multi-index id it belongs to. Only its by-destination
+	 * id is its own, the others are shared with the other routes. The
+	 * budget is generous, so that the check does not depend on the
+	 * allocator. */
+	const guint n_routes = g_test_perf () ? 1000000 : 10000;
+	const gsize max_per_route = 1024;
+	NMPCache *cache;
+	NMPCacheId cache_id_storage;
+	guint i, len;
+	gsize rss_before, rss_after;
+	double per_route;
+
+	rss_before = _get_rss ();
+
+	cache = nmp_cache_new (FALSE);
+	for (i = 0; i < n_routes; i++) {
+		NMPlatformIP6Route r = {
+			.ifindex = 1 + (i % 4),
+			.plen = 48,
+			.metric = 1024,
+		};
+		nm_auto_nmpobj NMPObject *obj = NULL;
+
+		r.network.s6_addr32[0] = htonl (0x20010000u + (i >> 16));
+		r.network.s6_addr32[1] = htonl ((i & 0xFFFF) << 16);
+		r.gateway.s6_addr32[0] = htonl (0xFE800000u);
+		r.gateway.s6_addr32[3] = htonl (1 + (i % 4));
+
+		obj = nmp_object_new (NMP_OBJECT_TYPE_IP6_ROUTE, (NMPlatformObject *) &r);
+		g_assert_cmpint (nmp_cache_update_netlink (cache, obj, NULL, NULL, NULL, NULL), ==, NMP_CACHE_OPS_ADDED);
+	}
+
+	rss_after = _get_rss ();
+	per_route = (double) (rss_after - MIN (rss_before, rss_after)) / n_routes;
+
+	nmp_cache_lookup_multi (cache, nmp_cache_id_init_object_type (&cache_id_storage, NMP_OBJECT_TYPE_IP6_ROUTE, TRUE), &len);
+	g_assert_cmpint (len, ==, n_routes);
+
+	g_test_message ("route memory: %u IPv6 routes take %.1f bytes per route (object size %u)",
+	                n_routes, per_route,
+	                (guint) (G_STRUCT_OFFSET (NMPObject, object) + sizeof (NMPObjectIP6Route)));
+
+	/* without /proc, there is nothing to check. */
+	if (rss_after)
+		g_assert_cmpfloat (per_route, <=, max_per_route);
+
+	if (g_test_perf ()) {
+		g_test_minimized_result (per_route,
+		                         "route memory: %u IPv6 routes take %.1f bytes per route",
+		                         n_routes, per_route);
+	}
+
+	nmp_cache_free (cache);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -430,6 +684,9 @@ main (int argc, char **argv)
 	}
 
 	g_test_add_func ("/nmp-object/cache_link", test_cache_link);
+	g_test_add_func ("/nmp-object/cache_route_churn", test_cache_route_churn);
+	g_test_add_func ("/nmp-object/cache_generation", test_cache_generation);
+	g_test_add_func ("/nmp-object/cache_route_memory", test_cache_route_memory);
 
 	result = g_test_run ();
 
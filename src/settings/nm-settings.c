@@ -158,6 +158,8 @@ typedef struct {
 	NMSettingsConnection **connections_cached_list;
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
+	NMMatchSpecCompiled *unmanaged_specs_compiled;
+	NMMatchSpecCompiled *unrecognized_specs_compiled;
 
 	gboolean started;
 	gboolean startup_complete;
@@ -548,6 +550,14 @@ nm_settings_get_unmanaged_specs (NMSettings *self)
 	return priv->unmanaged_specs;
 }
 
+const NMMatchSpecCompiled *
+nm_settings_get_unmanaged_specs_compiled (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	return priv->unmanaged_specs_compiled;
+}
+
 static NMSettingsPlugin *
 get_plugin (NMSettings *self, guint32 capability)
 {
@@ -693,34 +703,27 @@ out:
 	return hostname;
 }
 
-static gboolean
-find_spec (GSList *spec_list, const char *spec)
-{
-	GSList *iter;
-
-	for (iter = spec_list; iter; iter = g_slist_next (iter)) {
-		if (!strcmp ((const char *) iter->data, spec))
-			return TRUE;
-	}
-	return FALSE;
-}
-
 static void
 update_specs (NMSettings *self, GSList **specs_ptr,
+              NMMatchSpecCompiled **compiled_ptr,
               GSList * (*get_specs_func) (NMSettingsPlugin *))
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *seen = NULL;
 	GSList *iter;
 
 	g_slist_free_full (*specs_ptr, g_free);
 	*specs_ptr = NULL;
 
+	seen = g_hash_table_new (g_str_hash, g_str_equal);
+
 	for (iter = priv->plugins; iter; iter = g_slist_next (iter)) {
 		GSList *specs, *specs_iter;
 
 		specs = get_specs_func (NM_SETTINGS_PLUGIN (iter->data));
 		for (specs_iter = specs; specs_iter; specs_iter = specs_iter->next) {
-			if (!find_spec (*specs_ptr, (const char *) specs_iter->data)) {
+			if (!g_hash_table_contains (seen, specs_iter->data)) {
+				g_hash_table_add (seen, specs_iter->data);
 				*specs_ptr = g_slist_prepend (*specs_ptr, specs_iter->data);
 			} else
 				g_free (specs_iter->data);
@@ -728,6 +731,9 @@ update_specs (NMSettings *self, GSList **specs_ptr,
 
 		g_slist_free (specs);
 	}
+
+	nm_match_spec_compiled_free (*compiled_ptr);
+	*compiled_ptr = nm_match_spec_compile (*specs_ptr);
 }
 
 static void
@@ -738,6 +744,7 @@ unmanaged_specs_changed (NMSettingsPlugin *config,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	update_specs (self, &priv->unmanaged_specs,
+	              &priv->unmanaged_specs_compiled,
 	              nm_settings_plugin_get_unmanaged_specs);
 	_notify (self, PROP_UNMANAGED_SPECS);
 }
@@ -750,6 +757,7 @@ unrecognized_specs_changed (NMSettingsPlugin *config,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	update_specs (self, &priv->unrecognized_specs,
+	              &priv->unrecognized_specs_compiled,
 	              nm_settings_plugin_get_unrecognized_specs);
 }
 
@@ -1977,7 +1985,7 @@ have_connection_for_device (NMSettings *self, NMDevice *device)
 	}
 
 	/* See if there's a known non-NetworkManager configuration for the device */
-	if (nm_device_spec_match_list (device, priv->unrecognized_specs))
+	if (nm_device_spec_match_compiled (device, priv->unrecognized_specs_compiled))
 		return TRUE;
 
 	return FALSE;
@@ -2402,6 +2410,8 @@ finalize (GObject *object)
 
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
+	nm_match_spec_compiled_free (priv->unmanaged_specs_compiled);
+	nm_match_spec_compiled_free (priv->unrecognized_specs_compiled);
 
 	g_slist_free_full (priv->plugins, g_object_unref);
 
@@ -47,6 +47,7 @@
 
 typedef struct {
 	GHashTable *connections;  /* uuid::connection */
+	GHashTable *file_states;  /* path::FileState */
 
 	gboolean initialized;
 	GFileMonitor *monitor;
@@ -84,13 +85,34 @@ G_DEFINE_TYPE_EXTENDED (NMSKeyfilePlugin, nms_keyfile_plugin, G_TYPE_OBJECT, 0,
 
 /*****************************************************************************/
 
+/* Forget the recorded state of a file that we wrote or re-read outside
+ * of read_connections(). The next reload parses it again. */
+static void
+_file_state_forget (NMSKeyfilePlugin *self, const char *path)
+{
+	NMSKeyfilePluginPrivate *priv = NMS_KEYFILE_PLUGIN_GET_PRIVATE (self);
+
+	if (path && priv->file_states)
+		g_hash_table_remove (priv->file_states, path);
+}
+
 static void
 connection_removed_cb (NMSettingsConnection *obj, gpointer user_data)
 {
+	_file_state_forget (user_data, nm_settings_connection_get_filename (obj));
 	g_hash_table_remove (NMS_KEYFILE_PLUGIN_GET_PRIVATE ((NMSKeyfilePlugin *) user_data)->connections,
 	                     nm_connection_get_uuid (NM_CONNECTION (obj)));
 }
 
+static void
+connection_updated_cb (NMSettingsConnection *obj, gboolean by_user, gpointer user_data)
+{
+	/* The settings changed, either in memory only or followed by a commit
+	 * writing them out. Either way, the file state we recorded no longer
+	 * describes the content of the connection. */
+	_file_state_forget (user_data, nm_settings_connection_get_filename (obj));
+}
+
 /* Monitoring */
 
 static void
@@ -105,6 +127,8 @@ remove_connection (NMSKeyfilePlugin *self, NMSKeyfileConnection *connection)
 	/* Removing from the hash table should drop the last reference */
 	g_object_ref (connection);
 	g_signal_handlers_disconnect_by_func (connection, connection_removed_cb, self);
+	g_signal_handlers_disconnect_by_func (connection, connection_updated_cb, self);
+	_file_state_forget (self, nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection)));
 	removed = g_hash_table_remove (NMS_KEYFILE_PLUGIN_GET_PRIVATE (self)->connections,
 	                               nm_connection_get_uuid (NM_CONNECTION (connection)));
 	nm_settings_connection_signal_remove (NM_SETTINGS_CONNECTION (connection), FALSE);
@@ -282,6 +306,9 @@ update_connection (NMSKeyfilePlugin *self,
 		g_signal_connect (connection_new, NM_SETTINGS_CONNECTION_REMOVED,
 		                  G_CALLBACK (connection_removed_cb),
 		                  self);
+		g_signal_connect (connection_new, NM_SETTINGS_CONNECTION_UPDATED_INTERNAL,
+		                  G_CALLBACK (connection_updated_cb),
+		                  self);
 
 		if (!source) {
 			/* Only raise the signal if we were called without source, i.e. if we read the connection from file.
@@ -316,6 +343,8 @@ dir_changed (GFileMonitor *monitor,
 
 	connection = find_by_path (self, full_path);
 
+	_file_state_forget (self, full_path);
+
 	switch (event_type) {
 	case G_FILE_MONITOR_EVENT_DELETED:
 		if (!exists && connection)
@@ -373,6 +402,107 @@ setup_monitoring (NMSettingsPlugin *config)
 	                  config);
 }
 
+/* The state of a keyfile at the time we last parsed it. If neither the
+ * stat() data nor the content changed, a reload doesn't need to
+ * parse the file again. */
+typedef struct {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtim;
+	char *checksum;
+} FileState;
+
+typedef struct {
+	char *path;
+	struct stat st;
+	gboolean st_valid;
+	NMSKeyfileConnection *known;
+} FileEntry;
+
+static void
+_file_state_free (gpointer data)
+{
+	FileState *state = data;
+
+	g_free (state->checksum);
+	g_slice_free (FileState, state);
+}
+
+static gboolean
+_file_state_stat_equal (const FileState *state, const struct stat *st)
+{
+	return    state->dev == st->st_dev
+	       && state->ino == st->st_ino
+	       && state->size == st->st_size
+	       && state->mtim.tv_sec == st->st_mtim.tv_sec
+	       && state->mtim.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void
+_file_state_set_stat (FileState *state, const struct stat *st)
+{
+	state->dev = st->st_dev;
+	state->ino = st->st_ino;
+	state->size = st->st_size;
+	state->mtim = st->st_mtim;
+}
+
+static char *
+_file_checksum (const char *path)
+{
+	gs_free char *contents = NULL;
+	gsize len;
+
+	if (!g_file_get_contents (path, &contents, &len, NULL))
+		return NULL;
+	return g_compute_checksum_for_data (G_CHECKSUM_SHA256, (const guchar *) contents, len);
+}
+
+/* Returns %TRUE if the file at @entry did not change since it was parsed
+ * last time. In that case, the state is carried over to @new_states. */
+static gboolean
+_file_entry_unchanged (GHashTable *old_states, GHashTable *new_states, FileEntry *entry)
+{
+	FileState *state;
+	char *state_path;
+	gs_free char *checksum = NULL;
+
+	if (!entry->st_valid)
+		return FALSE;
+
+	if (!g_hash_table_lookup_extended (old_states, entry->path, (gpointer *) &state_path, (gpointer *) &state))
+		return FALSE;
+
+	if (!_file_state_stat_equal (state, &entry->st)) {
+		/* the file was touched, but maybe its content is still the same. */
+		if (!state->checksum)
+			return FALSE;
+		checksum = _file_checksum (entry->path);
+		if (g_strcmp0 (checksum, state->checksum) != 0)
+			return FALSE;
+		_file_state_set_stat (state, &entry->st);
+	}
+
+	g_hash_table_steal (old_states, state_path);
+	g_hash_table_insert (new_states, state_path, state);
+	return TRUE;
+}
+
+static void
+_file_entry_record (GHashTable *new_states, FileEntry *entry)
+{
+	FileState *state;
+
+	if (!entry->st_valid)
+		return;
+
+	state = g_slice_new0 (FileState);
+	_file_state_set_stat (state, &entry->st);
+	state->checksum = _file_checksum (entry->path);
+	g_hash_table_insert (new_states, g_strdup (entry->path), state);
+}
+
 static GHashTable *
 _paths_from_connections (GHashTable *connections)
 {
@@ -385,29 +515,34 @@ _paths_from_connections (GHashTable *connections)
 		const char *path = nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection));
 
 		if (path)
-			g_hash_table_add (paths, (void *) path);
+			g_hash_table_insert (paths, (void *) path, connection);
 	}
 	return paths;
 }
 
 static int
-_sort_paths (const char **f1, const char **f2, GHashTable *paths)
+_sort_paths (const FileEntry *f1, const FileEntry *f2, gpointer user_data)
 {
-	struct stat st;
 	gboolean c1, c2;
 	gint64 m1, m2;
 
-	c1 = !!g_hash_table_contains (paths, *f1);
-	c2 = !!g_hash_table_contains (paths, *f2);
+	c1 = !!f1->known;
+	c2 = !!f2->known;
 	if (c1 != c2)
 		return c1 ? -1 : 1;
 
-	m1 = stat (*f1, &st) == 0 ? (gint64) st.st_mtime : G_MININT64;
-	m2 = stat (*f2, &st) == 0 ? (gint64) st.st_mtime : G_MININT64;
+	m1 = f1->st_valid ? (gint64) f1->st.st_mtime : G_MININT64;
+	m2 = f2->st_valid ? (gint64) f2->st.st_mtime : G_MININT64;
 	if (m1 != m2)
 		return m1 > m2 ? -1 : 1;
 
-	return strcmp (*f1, *f2);
+	return strcmp (f1->path, f2->path);
+}
+
+static void
+_file_entry_clear (gpointer data)
+{
+	g_free (((FileEntry *) data)->path);
 }
 
 static void
@@ -423,8 +558,10 @@ read_connections (NMSettingsPlugin *config)
 	NMSKeyfileConnection *connection;
 	GPtrArray *dead_connections = NULL;
 	guint i;
-	GPtrArray *filenames;
+	GArray *entries;
 	GHashTable *paths;
+	GHashTable *file_states;
+	guint n_skipped = 0;
 
 	dir = g_dir_open (nms_keyfile_utils_get_path (), 0, &error);
 	if (!dir) {
@@ -436,12 +573,19 @@ read_connections (NMSettingsPlugin *config)
 	}
 
 	alive_connections = g_hash_table_new (NULL, NULL);
+	paths = _paths_from_connections (priv->connections);
 
-	filenames = g_ptr_array_new_with_free_func (g_free);
+	entries = g_array_new (FALSE, FALSE, sizeof (FileEntry));
+	g_array_set_clear_func (entries, _file_entry_clear);
 	while ((item = g_dir_read_name (dir))) {
+		FileEntry entry = { 0 };
+
 		if (nms_keyfile_utils_should_ignore_file (item))
 			continue;
-		g_ptr_array_add (filenames, g_build_filename (nms_keyfile_utils_get_path (), item, NULL));
+		entry.path = g_build_filename (nms_keyfile_utils_get_path (), item, NULL);
+		entry.st_valid = (stat (entry.path, &entry.st) == 0);
+		entry.known = g_hash_table_lookup (paths, entry.path);
+		g_array_append_val (entries, entry);
 	}
 	g_dir_close (dir);
 
@@ -451,16 +595,43 @@ read_connections (NMSettingsPlugin *config)
 	 * To have sensible, reproducible behavior, sort the paths by last modification
 	 * time prefering older files.
 	 */
-	paths = _paths_from_connections (priv->connections);
-	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
-	g_hash_table_destroy (paths);
+	g_array_sort_with_data (entries, (GCompareDataFunc) _sort_paths, NULL);
+
+	file_states = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _file_state_free);
 
-	for (i = 0; i < filenames->len; i++) {
-		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
+	for (i = 0; i < entries->len; i++) {
+		FileEntry *entry = &g_array_index (entries, FileEntry, i);
+
+		/* Only re-parse files that changed since we loaded them. Connections
+		 * with unsaved modifications are re-read, so that the reload still
+		 * reverts them to the content on disk. */
+		connection = entry->known;
+		if (   connection
+		    && !g_hash_table_contains (alive_connections, connection)
+		    && !nm_settings_connection_get_unsaved (NM_SETTINGS_CONNECTION (connection))
+		    && nm_streq0 (nm_settings_connection_get_filename (NM_SETTINGS_CONNECTION (connection)), entry->path)
+		    && _file_entry_unchanged (priv->file_states, file_states, entry)) {
+			_LOGT ("skip unchanged file \"%s\"", entry->path);
+			n_skipped++;
+		} else {
+			connection = update_connection (self, NULL, entry->path, NULL, FALSE, alive_connections, NULL);
+			if (connection)
+				_file_entry_record (file_states, entry);
+		}
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
 	}
-	g_ptr_array_free (filenames, TRUE);
+
+	g_hash_table_unref (priv->file_states);
+	priv->file_states = file_states;
+
+	if (priv->initialized) {
+		_LOGI ("reload: %u files, %u re-read, %u skipped as unchanged",
+		       entries->len, entries->len - n_skipped, n_skipped);
+	}
+
+	g_array_free (entries, TRUE);
+	g_hash_table_destroy (paths);
 
 	g_hash_table_iter_init (&iter, priv->connections);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
@@ -511,6 +682,7 @@ load_connection (NMSettingsPlugin *config,
 	if (nms_keyfile_utils_should_ignore_file (filename + dir_len + 1))
 		return FALSE;
 
+	_file_state_forget (self, filename);
 	connection = update_connection (self, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
 
 	return (connection != NULL);
@@ -541,6 +713,7 @@ add_connection (NMSettingsPlugin *config,
 		                                    NULL,
 		                                    error))
 			return NULL;
+		_file_state_forget (self, path);
 	}
 	return NM_SETTINGS_CONNECTION (update_connection (self, reread ?: connection, path, NULL, FALSE, NULL, error));
 }
@@ -589,6 +762,7 @@ nms_keyfile_plugin_init (NMSKeyfilePlugin *plugin)
 
 	priv->config = g_object_ref (nm_config_get ());
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	priv->file_states = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _file_state_free);
 }
 
 static void
@@ -627,6 +801,7 @@ dispose (GObject *object)
 		g_hash_table_destroy (priv->connections);
 		priv->connections = NULL;
 	}
+	g_clear_pointer (&priv->file_states, g_hash_table_unref);
 
 	if (priv->config) {
 		g_signal_handlers_disconnect_by_func (priv->config, config_changed_cb, object);
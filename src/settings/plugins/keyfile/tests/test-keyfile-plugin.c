@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <unistd.h>
+
+#include "nm-core-internal.h"
+#include "nm-config.h"
+#include "nm-auth-manager.h"
+#include "settings/nm-settings-plugin.h"
+#include "settings/nm-settings-connection.h"
+#include "settings/plugins/keyfile/nms-keyfile-plugin.h"
+#include "settings/plugins/keyfile/nms-keyfile-writer.h"
+#include "settings/plugins/keyfile/nms-keyfile-utils.h"
+
+#include "nm-test-utils-core.h"
+
+#define TEST_KEYFILE_PLUGIN_DIR TEST_SCRATCH_DIR"/plugin"
+
+/*****************************************************************************/
+
+static void
+_commit_cb (NMSettingsConnection *connection, GError *error, gpointer user_data)
+{
+	g_assert_no_error (error);
+	*((gboolean *) user_data) = TRUE;
+}
+
+static void
+test_reload_after_write (void)
+{
+	gs_unref_object NMSettingsPlugin *plugin = NULL;
+	gs_unref_object NMConnection *c1 = NULL;
+	gs_unref_object NMConnection *c2 = NULL;
+	gs_free char *path = NULL;
+	gs_free char *c1_contents = NULL;
+	gsize c1_len;
+	NMSettingsConnection *connection;
+	GSList *list;
+	GError *error = NULL;
+	gboolean committed = FALSE;
+
+	/* C1 is on disk when the plugin loads the connections. */
+	c1 = nmtst_create_minimal_connection ("test-reload-c1", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	nm_connection_normalize (c1, NULL, NULL, NULL);
+	if (!nms_keyfile_writer_connection (c1, NULL, FALSE, &path, NULL, NULL, &error))
+		g_assert_not_reached ();
+	g_assert_no_error (error);
+	g_assert (path);
+	if (!g_file_get_contents (path, &c1_contents, &c1_len, &error))
+		g_assert_not_reached ();
+
+	plugin = NM_SETTINGS_PLUGIN (nms_keyfile_plugin_new ());
+	list = nm_settings_plugin_get_connections (plugin);
+	g_assert_cmpint (g_slist_length (list), ==, 1);
+	connection = list->data;
+	g_slist_free (list);
+	g_assert_cmpstr (nm_settings_connection_get_filename (connection), ==, path);
+
+	/* The daemon writes C2 to the same file. */
+	c2 = nmtst_clone_connection (c1);
+	g_object_set (nm_connection_get_setting_connection (c2),
+	              NM_SETTING_CONNECTION_ID, "test-reload-c2",
+	              NULL);
+	if (!nm_settings_connection_replace_settings (connection, c2, FALSE, NULL, &error))
+		g_assert_not_reached ();
+	nm_settings_connection_commit_changes (connection, NM_SETTINGS_CONNECTION_COMMIT_REASON_NONE,
+	                                       _commit_cb, &committed);
+	g_assert (committed);
+	g_assert_cmpstr (nm_settings_connection_get_filename (connection), ==, path);
+	g_assert_cmpstr (nm_connection_get_id (NM_CONNECTION (connection)), ==, "test-reload-c2");
+
+	/* C1 is restored on disk. Its content matches the state the plugin
+	 * recorded at load time, but no longer what the connection holds. */
+	if (!g_file_set_contents (path, c1_contents, c1_len, &error))
+		g_assert_not_reached ();
+
+	nm_settings_plugin_reload_connections (plugin);
+
+	list = nm_settings_plugin_get_connections (plugin);
+	g_assert_cmpint (g_slist_length (list), ==, 1);
+	g_assert (list->data == connection);
+	g_slist_free (list);
+	g_assert_cmpstr (nm_connection_get_id (NM_CONNECTION (connection)), ==, "test-reload-c1");
+
+	unlink (path);
+}
+
+/*****************************************************************************/
+
+static void
+_setup_config (void)
+{
+	gs_free char *config_file = NULL;
+	gs_free char *config_contents = NULL;
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	GError *error = NULL;
+	char *args[] = { "test-keyfile-plugin", "--config", NULL, "--config-dir", "/no/such/dir",
+	                 "--intern-config", "", "--no-auto-default", TEST_KEYFILE_PLUGIN_DIR"/no-auto-default.state", NULL };
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args) - 1;
+
+	config_file = g_build_filename (TEST_KEYFILE_PLUGIN_DIR, "NetworkManager.conf", NULL);
+	config_contents = g_strdup_printf ("[keyfile]\n"
+	                                   "path=%s\n",
+	                                   TEST_KEYFILE_PLUGIN_DIR"/system-connections");
+	if (!g_file_set_contents (config_file, config_contents, -1, &error))
+		g_error ("failure to write \"%s\": %s", config_file, error->message);
+	args[2] = config_file;
+
+	cli = nm_config_cmd_line_options_new ();
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	if (!g_option_context_parse (context, &argc, &argv, NULL))
+		g_assert_not_reached ();
+	g_option_context_free (context);
+
+	if (!nm_config_setup (cli, NULL, &error))
+		g_error ("failure to setup config: %s", error->message);
+	nm_config_cmd_line_options_free (cli);
+
+	g_assert_cmpstr (nms_keyfile_utils_get_path (), ==, TEST_KEYFILE_PLUGIN_DIR"/system-connections");
+}
+
+NMTST_DEFINE ();
+
+int main (int argc, char **argv)
+{
+	_nm_utils_set_testing (NM_UTILS_TEST_NO_KEYFILE_OWNER_CHECK);
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	if (g_mkdir_with_parents (TEST_KEYFILE_PLUGIN_DIR"/system-connections", 0755) != 0)
+		g_error ("failure to create test directory \"%s\": %s", TEST_KEYFILE_PLUGIN_DIR, g_strerror (errno));
+
+	_setup_config ();
+	nm_auth_manager_setup (FALSE);
+
+	g_test_add_func ("/keyfile/plugin/reload-after-write", test_reload_after_write);
+
+	return g_test_run ();
+}
@@ -0,0 +1,200 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-act-request.h"
+#include "nm-active-connection.h"
+#include "nm-auth-manager.h"
+#include "nm-auth-subject.h"
+#include "nm-bus-manager.h"
+#include "nm-perf-counters.h"
+#include "settings/nm-settings-connection.h"
+#include "platform/nm-fake-platform.h"
+#include "tests/config/nm-test-device.h"
+
+#include "nm-test-utils-core.h"
+
+/* NMTestDevice has no type description of its own */
+#define ACTIVATION_COUNT_KEY "activation-nmtestdevice-count"
+
+/*****************************************************************************/
+
+static NMSettingsConnection *
+_create_settings_connection (void)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	NMSettingsConnection *settings_connection;
+
+	connection = nmtst_create_minimal_connection ("test-active-connection", NULL,
+	                                              NM_SETTING_WIRED_SETTING_NAME, NULL);
+	nmtst_connection_normalize (connection);
+
+	settings_connection = g_object_new (NM_TYPE_SETTINGS_CONNECTION, NULL);
+	nm_connection_replace_settings_from_connection (NM_CONNECTION (settings_connection), connection);
+	return settings_connection;
+}
+
+static GVariant *
+_get_timings (NMActiveConnection *ac)
+{
+	GVariant *timings = NULL;
+
+	g_object_get (ac, NM_ACTIVE_CONNECTION_TIMINGS, &timings, NULL);
+	g_assert (timings);
+	g_assert (g_variant_is_of_type (timings, G_VARIANT_TYPE ("a{st}")));
+	return timings;
+}
+
+static guint64
+_get_timing (NMActiveConnection *ac, const char *milestone)
+{
+	gs_unref_variant GVariant *timings = _get_timings (ac);
+	guint64 usec;
+
+	g_assert (g_variant_lookup (timings, milestone, "t", &usec));
+	return usec;
+}
+
+static guint64
+_get_activation_count (void)
+{
+	gs_unref_variant GVariant *counters = g_variant_ref_sink (nm_perf_counters_to_variant ());
+	guint64 count = 0;
+
+	g_variant_lookup (counters, ACTIVATION_COUNT_KEY, "t", &count);
+	return count;
+}
+
+static void
+_timings_notify_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	(*((guint *) user_data))++;
+}
+
+/*****************************************************************************/
+
+static void
+test_milestones (void)
+{
+	gs_unref_object NMSettingsConnection *settings_connection = NULL;
+	gs_unref_object NMDevice *device = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+	gs_unref_object NMActRequest *req = NULL;
+	gs_unref_variant GVariant *timings = NULL;
+	NMActiveConnection *ac;
+	guint64 prepare, config, activated;
+	guint64 count;
+	guint n_notify = 0;
+
+	settings_connection = _create_settings_connection ();
+	device = nm_test_device_new ("00:11:22:33:44:55");
+	subject = nm_auth_subject_new_internal ();
+	count = _get_activation_count ();
+
+	req = nm_act_request_new (settings_connection, NULL, NULL, subject,
+	                          NM_ACTIVATION_TYPE_MANAGED, device);
+	ac = NM_ACTIVE_CONNECTION (req);
+	g_signal_connect (ac, "notify::" NM_ACTIVE_CONNECTION_TIMINGS,
+	                  G_CALLBACK (_timings_notify_cb), &n_notify);
+
+	timings = _get_timings (ac);
+	g_assert_cmpint (g_variant_n_children (timings), ==, 0);
+	g_clear_pointer (&timings, g_variant_unref);
+
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_PREPARE);
+	g_assert_cmpint (n_notify, ==, 1);
+	prepare = _get_timing (ac, "prepare");
+
+	g_usleep (10000);
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_CONFIG);
+	g_assert_cmpint (n_notify, ==, 2);
+	config = _get_timing (ac, "config");
+	g_assert_cmpuint (config, >=, prepare + 10000);
+
+	/* only the first time a milestone is reached counts */
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_PREPARE);
+	g_assert_cmpint (n_notify, ==, 2);
+	g_assert_cmpuint (_get_timing (ac, "prepare"), ==, prepare);
+
+	timings = _get_timings (ac);
+	g_assert_cmpint (g_variant_n_children (timings), ==, 2);
+	g_assert (!g_variant_lookup (timings, "activated", "t", NULL));
+	g_clear_pointer (&timings, g_variant_unref);
+
+	/* reaching "activated" adds the activation to the histogram of its device type */
+	g_assert_cmpuint (_get_activation_count (), ==, count);
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_ACTIVATED);
+	g_assert_cmpint (n_notify, ==, 3);
+	activated = _get_timing (ac, "activated");
+	g_assert_cmpuint (activated, >=, config);
+	g_assert_cmpuint (_get_activation_count (), ==, count + 1);
+
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_ACTIVATED);
+	g_assert_cmpuint (_get_activation_count (), ==, count + 1);
+
+	g_signal_handlers_disconnect_by_func (ac, G_CALLBACK (_timings_notify_cb), &n_notify);
+}
+
+static void
+test_milestones_assume (void)
+{
+	gs_unref_object NMSettingsConnection *settings_connection = NULL;
+	gs_unref_object NMDevice *device = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+	gs_unref_object NMActRequest *req = NULL;
+	NMActiveConnection *ac;
+	guint64 count;
+
+	settings_connection = _create_settings_connection ();
+	device = nm_test_device_new ("00:11:22:33:44:66");
+	subject = nm_auth_subject_new_internal ();
+	count = _get_activation_count ();
+
+	/* an assumed connection records its timings, but was not activated
+	 * by us and does not count for the histograms. */
+	req = nm_act_request_new (settings_connection, NULL, NULL, subject,
+	                          NM_ACTIVATION_TYPE_ASSUME, device);
+	ac = NM_ACTIVE_CONNECTION (req);
+
+	nm_active_connection_record_milestone (ac, NM_ACTIVATION_MILESTONE_ACTIVATED);
+	_get_timing (ac, "activated");
+	g_assert_cmpuint (_get_activation_count (), ==, count);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* like test-config, skip nm_bus_manager_init_bus() */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+	nm_auth_manager_setup (FALSE);
+	nm_fake_platform_setup ();
+
+	g_test_add_func ("/active-connection/milestones", test_milestones);
+	g_test_add_func ("/active-connection/milestones-assume", test_milestones_assume);
+
+	return g_test_run ();
+}
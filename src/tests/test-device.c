@@ -0,0 +1,203 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "devices/nm-device-private.h"
+#include "nm-auth-manager.h"
+#include "nm-bus-manager.h"
+#include "nm-config.h"
+#include "nm-ip4-config.h"
+#include "nm-ip6-config.h"
+#include "nm-perf-counters.h"
+#include "platform/nm-fake-platform.h"
+#include "tests/config/nm-test-device.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+#define _assert_syncs(syncs, skipped) \
+	G_STMT_START { \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS), ==, (syncs)); \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED), ==, (skipped)); \
+	} G_STMT_END
+
+static NMDevice *
+_create_device (const char *ip_iface, const char *hwaddr)
+{
+	NMDevice *device;
+
+	device = nm_test_device_new (hwaddr);
+	g_assert (nm_device_set_ip_iface (device, ip_iface));
+	g_assert_cmpint (nm_device_get_ip_ifindex (device), ==, nm_platform_link_get_ifindex (NM_PLATFORM_GET, ip_iface));
+	return device;
+}
+
+/*****************************************************************************/
+
+static void
+test_ip4_sync_skip (void)
+{
+	gs_unref_object NMDevice *device = NULL;
+	const NMPlatformIP4Address *addr;
+	int ifindex;
+	guint64 syncs, skipped;
+
+	device = _create_device ("eth1", "00:11:22:33:44:55");
+	ifindex = nm_device_get_ip_ifindex (device);
+
+	g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.168.1.10"), 24, 0,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0, NULL));
+
+	syncs = nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS);
+	skipped = nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED);
+
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (++syncs, skipped);
+	addr = nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.168.1.10"), 24, 0);
+	g_assert (addr);
+	g_assert (nm_device_get_ip4_config (device));
+	g_assert (nm_ip4_config_address_exists (nm_device_get_ip4_config (device), addr));
+
+	/* the link did not change since the last sync */
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (syncs, ++skipped);
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (syncs, ++skipped);
+
+	/* an external change of the link is picked up by the next sync */
+	g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.168.2.10"), 24, 0,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0, NULL));
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (++syncs, skipped);
+	addr = nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.168.2.10"), 24, 0);
+	g_assert (addr);
+	g_assert (nm_ip4_config_address_exists (nm_device_get_ip4_config (device), addr));
+
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (syncs, ++skipped);
+
+	/* so is the removal of an address */
+	g_assert (nm_platform_ip4_address_delete (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.168.1.10"), 24, 0));
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (++syncs, skipped);
+	g_assert_cmpint (nm_ip4_config_get_num_addresses (nm_device_get_ip4_config (device)), ==, 1);
+
+	/* a change of another link does not affect this one */
+	g_assert (nm_platform_ip4_address_add (NM_PLATFORM_GET, nm_platform_link_get_ifindex (NM_PLATFORM_GET, "eth0"),
+	                                       nmtst_inet4_from_string ("192.168.3.10"), 24, 0,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0, NULL));
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (syncs, ++skipped);
+}
+
+static void
+test_ip6_sync_skip (void)
+{
+	gs_unref_object NMDevice *device = NULL;
+	const NMPlatformIP6Address *addr;
+	int ifindex;
+	guint64 syncs, skipped;
+
+	device = _create_device ("eth2", "00:11:22:33:44:66");
+	ifindex = nm_device_get_ip_ifindex (device);
+
+	g_assert (nm_platform_ip6_address_add (NM_PLATFORM_GET, ifindex, *nmtst_inet6_from_string ("2001:db8:a::10"), 64, in6addr_any,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0));
+
+	syncs = nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS);
+	skipped = nm_perf_counter_get (NM_PERF_COUNTER_DEVICE_IP_SYNCS_SKIPPED);
+
+	nm_device_sync_ip_config (device, AF_INET6);
+	_assert_syncs (++syncs, skipped);
+	addr = nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, *nmtst_inet6_from_string ("2001:db8:a::10"), 64);
+	g_assert (addr);
+	g_assert (nm_device_get_ip6_config (device));
+	g_assert (nm_ip6_config_address_exists (nm_device_get_ip6_config (device), addr));
+
+	/* the link did not change since the last sync */
+	nm_device_sync_ip_config (device, AF_INET6);
+	_assert_syncs (syncs, ++skipped);
+
+	/* an external change of the link is picked up by the next sync */
+	g_assert (nm_platform_ip6_address_add (NM_PLATFORM_GET, ifindex, *nmtst_inet6_from_string ("2001:db8:b::10"), 64, in6addr_any,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, 0));
+	nm_device_sync_ip_config (device, AF_INET6);
+	_assert_syncs (++syncs, skipped);
+	addr = nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, *nmtst_inet6_from_string ("2001:db8:b::10"), 64);
+	g_assert (addr);
+	g_assert (nm_ip6_config_address_exists (nm_device_get_ip6_config (device), addr));
+
+	nm_device_sync_ip_config (device, AF_INET6);
+	_assert_syncs (syncs, ++skipped);
+
+	/* syncing IPv4 does not change the link and leaves the IPv6 sync valid */
+	nm_device_sync_ip_config (device, AF_INET);
+	_assert_syncs (++syncs, skipped);
+	nm_device_sync_ip_config (device, AF_INET6);
+	_assert_syncs (syncs, ++skipped);
+}
+
+/*****************************************************************************/
+
+static void
+_setup_config (void)
+{
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	GError *error = NULL;
+	char *args[] = { "test-device", "--config", "/dev/null", "--config-dir", "/no/such/dir",
+	                 "--system-config-dir", "/no/such/dir", "--intern-config", "",
+	                 "--no-auto-default", "/no/such/file", NULL };
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args) - 1;
+
+	/* the device reads the connection defaults of NMConfig */
+	cli = nm_config_cmd_line_options_new ();
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	if (!g_option_context_parse (context, &argc, &argv, NULL))
+		g_assert_not_reached ();
+	g_option_context_free (context);
+
+	if (!nm_config_setup (cli, NULL, &error))
+		g_error ("failure to setup config: %s", error->message);
+	nm_config_cmd_line_options_free (cli);
+}
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* like test-config, skip nm_bus_manager_init_bus() */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+	nm_auth_manager_setup (FALSE);
+	nm_fake_platform_setup ();
+	_setup_config ();
+
+	g_test_add_func ("/device/ip4-sync-skip", test_ip4_sync_skip);
+	g_test_add_func ("/device/ip6-sync-skip", test_ip6_sync_skip);
+
+	return g_test_run ();
+}
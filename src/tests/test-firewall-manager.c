@@ -0,0 +1,320 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-firewall-manager.h"
+
+#include "nm-test-utils-core.h"
+
+/* The mock firewalld, tools/test-firewalld-service.py, runs on the session
+ * bus and records the calls it receives. main() points the system bus at
+ * the session bus, so that NMFirewallManager finds the mock. */
+
+#define TEST_INTERFACE "org.freedesktop.NetworkManager.TestFirewallD"
+
+typedef struct {
+	GMainLoop *loop;
+	NMFirewallManager *mgr;
+	GDBusProxy *test_proxy;
+	GPid pid;
+	GString *completed;
+	guint n_pending;
+} TestData;
+
+typedef enum {
+	OP_ADD,
+	OP_CHANGE,
+	OP_REMOVE,
+} TestOp;
+
+typedef struct {
+	TestData *data;
+	const char *name;
+	TestOp op;
+	const char *iface;
+	const char *zone;
+	NMFirewallManagerCallId call_id;
+	gboolean completed;
+	gboolean cancelled;
+} TestCall;
+
+/*****************************************************************************/
+
+static void
+_available_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	g_main_loop_quit (user_data);
+}
+
+static void
+_mock_start (TestData *data)
+{
+	const char *const args[] = { TEST_NM_PYTHON, TEST_FIREWALLD_SERVICE, "--session", NULL };
+	GError *error = NULL;
+	gboolean available;
+	gulong id;
+
+	data->loop = g_main_loop_new (NULL, FALSE);
+	data->completed = g_string_new (NULL);
+	data->mgr = g_object_new (NM_TYPE_FIREWALL_MANAGER, NULL);
+	g_object_get (data->mgr, NM_FIREWALL_MANAGER_AVAILABLE, &available, NULL);
+	g_assert (!available);
+
+	if (!g_spawn_async (NULL, (char **) args, NULL, G_SPAWN_SEARCH_PATH,
+	                    NULL, NULL, &data->pid, &error))
+		g_assert_no_error (error);
+
+	/* wait until the mock owns the firewalld name */
+	id = g_signal_connect (data->mgr, "notify::" NM_FIREWALL_MANAGER_AVAILABLE,
+	                       G_CALLBACK (_available_cb), data->loop);
+	g_assert (nmtst_main_loop_run (data->loop, 5000));
+	g_signal_handler_disconnect (data->mgr, id);
+	g_object_get (data->mgr, NM_FIREWALL_MANAGER_AVAILABLE, &available, NULL);
+	g_assert (available);
+
+	data->test_proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
+	                                                  G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+	                                                  G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
+	                                                  G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+	                                                  NULL,
+	                                                  FIREWALL_DBUS_SERVICE,
+	                                                  FIREWALL_DBUS_PATH,
+	                                                  TEST_INTERFACE,
+	                                                  NULL, &error);
+	g_assert_no_error (error);
+}
+
+static void
+_mock_stop (TestData *data)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	GError *error = NULL;
+
+	g_assert_cmpint (data->n_pending, ==, 0);
+
+	ret = g_dbus_proxy_call_sync (data->test_proxy, "Quit", NULL,
+	                              G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	g_assert_no_error (error);
+
+	g_object_unref (data->test_proxy);
+	g_object_unref (data->mgr);
+	g_string_free (data->completed, TRUE);
+	g_main_loop_unref (data->loop);
+	g_spawn_close_pid (data->pid);
+}
+
+/* checks the calls firewalld received so far, given as "method:zone:iface". */
+static void
+_assert_calls (TestData *data, const char *const *expected)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_unref_variant GVariant *calls = NULL;
+	GError *error = NULL;
+	const char *method, *zone, *iface;
+	gsize i;
+
+	ret = g_dbus_proxy_call_sync (data->test_proxy, "GetCalls", NULL,
+	                              G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	g_assert_no_error (error);
+
+	calls = g_variant_get_child_value (ret, 0);
+	g_assert_cmpint (g_variant_n_children (calls), ==, g_strv_length ((char **) expected));
+	for (i = 0; expected[i]; i++) {
+		gs_free char *s = NULL;
+
+		g_variant_get_child (calls, i, "(&s&s&s)", &method, &zone, &iface);
+		s = g_strdup_printf ("%s:%s:%s", method, zone, iface);
+		g_assert_cmpstr (s, ==, expected[i]);
+	}
+}
+
+/*****************************************************************************/
+
+static void
+_call_cb (NMFirewallManager *mgr,
+          NMFirewallManagerCallId call_id,
+          GError *error,
+          gpointer user_data)
+{
+	TestCall *call = user_data;
+	TestData *data = call->data;
+
+	g_assert (!call->completed);
+	g_assert (call->call_id == call_id);
+
+	call->completed = TRUE;
+	call->cancelled = nm_utils_error_is_cancelled (error, FALSE);
+	if (!call->cancelled)
+		g_assert_no_error (error);
+
+	g_string_append (data->completed, call->name);
+
+	g_assert_cmpint (data->n_pending, >, 0);
+	if (--data->n_pending == 0)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+_call_start (TestData *data, TestCall *call)
+{
+	call->data = data;
+	if (call->op == OP_REMOVE) {
+		call->call_id = nm_firewall_manager_remove_from_zone (data->mgr, call->iface, call->zone,
+		                                                      _call_cb, call);
+	} else {
+		call->call_id = nm_firewall_manager_add_or_change_zone (data->mgr, call->iface, call->zone,
+		                                                        call->op == OP_ADD,
+		                                                        _call_cb, call);
+	}
+	g_assert (call->call_id);
+	data->n_pending++;
+}
+
+static void
+_wait_pending (TestData *data)
+{
+	if (data->n_pending)
+		g_assert (nmtst_main_loop_run (data->loop, 5000));
+	g_assert_cmpint (data->n_pending, ==, 0);
+}
+
+/*****************************************************************************/
+
+static void
+test_queue_coalesce (void)
+{
+	TestCall calls[] = {
+		{ .name = "a", .op = OP_ADD,    .iface = "eth0", .zone = "work" },
+		/* identical to the request before, shares its call */
+		{ .name = "b", .op = OP_ADD,    .iface = "eth0", .zone = "work" },
+		{ .name = "c", .op = OP_CHANGE, .iface = "eth1", .zone = "home" },
+		{ .name = "d", .op = OP_REMOVE, .iface = "eth0", .zone = "work" },
+		/* identical to "a", but must go after "d" */
+		{ .name = "e", .op = OP_ADD,    .iface = "eth0", .zone = "work" },
+		{ .name = "f", .op = OP_ADD,    .iface = "eth2", .zone = "public" },
+		{ .name = "g", .op = OP_ADD,    .iface = "eth0", .zone = "work" },
+		/* firewalld fails with UNKNOWN_INTERFACE, which is no error */
+		{ .name = "h", .op = OP_REMOVE, .iface = "eth3", .zone = NULL },
+	};
+	const char *const expected[] = {
+		"addInterface:work:eth0",
+		"changeZone:home:eth1",
+		"removeInterface:work:eth0",
+		"addInterface:work:eth0",
+		"removeInterface::eth3",
+		NULL,
+	};
+	TestData data = { };
+	guint i;
+
+	_mock_start (&data);
+
+	/* all requests are made without iterating the main loop */
+	for (i = 0; i < G_N_ELEMENTS (calls); i++)
+		_call_start (&data, &calls[i]);
+	g_assert_cmpstr (data.completed->str, ==, "");
+
+	nm_firewall_manager_cancel_call (calls[5].call_id);
+	g_assert (calls[5].cancelled);
+	g_assert_cmpstr (data.completed->str, ==, "f");
+
+	_wait_pending (&data);
+
+	/* merged requests complete together with the one they were merged into */
+	g_assert_cmpstr (data.completed->str, ==, "fabcdegh");
+	for (i = 0; i < G_N_ELEMENTS (calls); i++) {
+		g_assert (calls[i].completed);
+		g_assert (calls[i].cancelled == (i == 5));
+	}
+
+	_assert_calls (&data, expected);
+
+	_mock_stop (&data);
+}
+
+static void
+test_queue_cancel (void)
+{
+	TestCall calls[] = {
+		{ .name = "a", .op = OP_ADD,    .iface = "eth0", .zone = "work" },
+		{ .name = "b", .op = OP_CHANGE, .iface = "eth0", .zone = "home" },
+		{ .name = "c", .op = OP_ADD,    .iface = "eth1", .zone = "work" },
+		{ .name = "d", .op = OP_ADD,    .iface = "eth1", .zone = "work" },
+	};
+	TestCall call_e = { .name = "e", .op = OP_REMOVE, .iface = "eth0", .zone = "home" };
+	const char *const expected[] = {
+		"changeZone:home:eth0",
+		"addInterface:work:eth1",
+		NULL,
+	};
+	TestData data = { };
+	guint i;
+
+	_mock_start (&data);
+
+	for (i = 0; i < G_N_ELEMENTS (calls); i++)
+		_call_start (&data, &calls[i]);
+
+	/* a request cancelled before the queue is flushed is never sent,
+	 * even if an identical one would have been merged into it. */
+	nm_firewall_manager_cancel_call (calls[0].call_id);
+	nm_firewall_manager_cancel_call (calls[2].call_id);
+	g_assert_cmpstr (data.completed->str, ==, "ac");
+
+	_wait_pending (&data);
+	g_assert_cmpstr (data.completed->str, ==, "acbd");
+	g_assert (!calls[1].cancelled);
+	g_assert (!calls[3].cancelled);
+
+	_assert_calls (&data, expected);
+
+	/* if all requests are cancelled, there is nothing to send. */
+	_call_start (&data, &call_e);
+	nm_firewall_manager_cancel_call (call_e.call_id);
+	g_assert (call_e.cancelled);
+	g_assert (!nmtst_main_loop_run (data.loop, 200));
+
+	_assert_calls (&data, expected);
+
+	_mock_stop (&data);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	const char *session_bus;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* NMFirewallManager talks to firewalld on the system bus */
+	session_bus = g_getenv ("DBUS_SESSION_BUS_ADDRESS");
+	g_assert (session_bus);
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", session_bus, TRUE);
+
+	g_test_add_func ("/firewall/queue/coalesce", test_queue_coalesce);
+	g_test_add_func ("/firewall/queue/cancel", test_queue_cancel);
+
+	return g_test_run ();
+}
@@ -991,11 +991,31 @@ test_connection_sort_autoconnect_priority (void)
 #define MATCH_S390 "S390:"
 #define MATCH_DRIVER "DRIVER:"
 
+static NMMatchSpecMatchType
+_test_match_spec_device_check (const GSList *specs,
+                               const char *interface_name,
+                               const char *driver,
+                               const char *driver_version,
+                               const char *s390_subchannels)
+{
+	NMMatchSpecCompiled *compiled;
+	NMMatchSpecMatchType m, m_compiled;
+
+	m = nm_match_spec_device (specs, interface_name, NULL, driver, driver_version, NULL, s390_subchannels);
+
+	compiled = nm_match_spec_compile (specs);
+	m_compiled = nm_match_spec_compiled_match_device (compiled, interface_name, NULL, driver, driver_version, NULL, s390_subchannels);
+	nm_match_spec_compiled_free (compiled);
+
+	g_assert_cmpint (m, ==, m_compiled);
+	return m;
+}
+
 static NMMatchSpecMatchType
 _test_match_spec_device (const GSList *specs, const char *match_str)
 {
 	if (match_str && g_str_has_prefix (match_str, MATCH_S390))
-		return nm_match_spec_device (specs, NULL, NULL, NULL, NULL, NULL, &match_str[NM_STRLEN (MATCH_S390)]);
+		return _test_match_spec_device_check (specs, NULL, NULL, NULL, &match_str[NM_STRLEN (MATCH_S390)]);
 	if (match_str && g_str_has_prefix (match_str, MATCH_DRIVER)) {
 		gs_free char *s = g_strdup (&match_str[NM_STRLEN (MATCH_DRIVER)]);
 		char *t;
@@ -1005,9 +1025,9 @@ _test_match_spec_device (const GSList *specs, const char *match_str)
 			t[0] = '\0';
 			t++;
 		}
-		return nm_match_spec_device (specs, NULL, NULL, s, t, NULL, NULL);
+		return _test_match_spec_device_check (specs, NULL, s, t, NULL);
 	}
-	return nm_match_spec_device (specs, match_str, NULL, NULL, NULL, NULL, NULL);
+	return _test_match_spec_device_check (specs, match_str, NULL, NULL, NULL);
 }
 
 static void
@@ -1177,6 +1197,51 @@ test_match_spec_device (void)
 #undef S
 }
 
+static void
+test_match_spec_device_many (void)
+{
+	GSList *specs = NULL;
+	NMMatchSpecCompiled *compiled;
+	guint i;
+	static const struct {
+		const char *interface_name;
+		const char *hwaddr;
+		NMMatchSpecMatchType expected;
+	} devices[] = {
+		{ "eth0",       NULL,                NM_MATCH_SPEC_MATCH },
+		{ "eth499",     NULL,                NM_MATCH_SPEC_MATCH },
+		{ "eth500",     NULL,                NM_MATCH_SPEC_NO_MATCH },
+		{ "eth77",      NULL,                NM_MATCH_SPEC_NEG_MATCH },
+		{ "vlan12.3",   NULL,                NM_MATCH_SPEC_MATCH },
+		{ "vlan1",      NULL,                NM_MATCH_SPEC_NO_MATCH },
+		{ "vlan77.1",   NULL,                NM_MATCH_SPEC_NEG_MATCH },
+		{ "foo",        "00:11:22:33:01:2c", NM_MATCH_SPEC_MATCH },
+		{ "foo",        "00:11:22:33:01:f4", NM_MATCH_SPEC_NO_MATCH },
+		{ "foo",        "00:11:22:33:00:07", NM_MATCH_SPEC_NEG_MATCH },
+		{ "em5",        NULL,                NM_MATCH_SPEC_MATCH },
+	};
+
+	for (i = 0; i < 500; i++) {
+		specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:eth%u", i));
+		specs = g_slist_prepend (specs, g_strdup_printf ("mac:00:11:22:33:%02x:%02x", i >> 8, i & 0xFF));
+		specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:vlan%u.*", i + 10));
+	}
+	specs = g_slist_prepend (specs, g_strdup ("em5"));
+	specs = g_slist_prepend (specs, g_strdup ("except:interface-name:eth77"));
+	specs = g_slist_prepend (specs, g_strdup ("except:interface-name:vlan77.*"));
+	specs = g_slist_prepend (specs, g_strdup ("except:mac:00:11:22:33:00:07"));
+
+	compiled = nm_match_spec_compile (specs);
+	for (i = 0; i < G_N_ELEMENTS (devices); i++) {
+		g_assert_cmpint (nm_match_spec_device (specs, devices[i].interface_name, NULL, NULL, NULL, devices[i].hwaddr, NULL),
+		                 ==, devices[i].expected);
+		g_assert_cmpint (nm_match_spec_compiled_match_device (compiled, devices[i].interface_name, NULL, NULL, NULL, devices[i].hwaddr, NULL),
+		                 ==, devices[i].expected);
+	}
+	nm_match_spec_compiled_free (compiled);
+	g_slist_free_full (specs, g_free);
+}
+
 /*****************************************************************************/
 
 static void
@@ -1736,6 +1801,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/connection-sort/autoconnect-priority", test_connection_sort_autoconnect_priority);
 
 	g_test_add_func ("/general/match-spec/device", test_match_spec_device);
+	g_test_add_func ("/general/match-spec/device-many", test_match_spec_device_many);
 	g_test_add_func ("/general/match-spec/config", test_match_spec_config);
 	g_test_add_func ("/general/duplicate_decl_specifier", test_duplicate_decl_specifier);
 
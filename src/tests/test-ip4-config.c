@@ -22,9 +22,12 @@
 
 #include <string.h>
 #include <arpa/inet.h>
+#include <linux/rtnetlink.h>
 
 #include "nm-ip4-config.h"
+#include "nm-perf-counters.h"
 #include "platform/nm-platform.h"
+#include "platform/nm-fake-platform.h"
 
 #include "nm-test-utils-core.h"
 
@@ -149,6 +152,54 @@ test_subtract (void)
 	g_object_unref (dst);
 }
 
+static void
+test_subtract_duplicate_id (void)
+{
+	const NMPlatformLink *link;
+	NMPlatformIP4Route route = {
+		.network = nmtst_inet4_from_string ("10.0.0.0"),
+		.plen = 8,
+	};
+	NMIP4Config *src, *dst;
+	int ifindex;
+
+	g_assert_cmpint (nm_platform_link_dummy_add (NM_PLATFORM_GET, "dup0", &link), ==, NM_PLATFORM_ERROR_SUCCESS);
+	ifindex = link->ifindex;
+
+	/* the platform has two routes to the same network, differing only in
+	 * their metric, and so does the captured config. */
+	route.ifindex = ifindex;
+	route.metric = 100;
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, &route));
+	route.metric = 200;
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, &route));
+
+	dst = nm_ip4_config_capture (ifindex, FALSE);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 2);
+
+	/* each route in @src removes only one route with the same id */
+	src = nm_ip4_config_new (ifindex);
+	nm_ip4_config_add_route (src, &route);
+	nm_ip4_config_subtract (dst, src);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 1);
+	g_assert_cmpuint (nm_ip4_config_get_route (dst, 0)->network, ==, route.network);
+
+	nm_ip4_config_subtract (dst, src);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 0);
+	g_object_unref (src);
+	g_object_unref (dst);
+
+	/* duplicates in @src remove as many duplicates from @dst */
+	src = nm_ip4_config_capture (ifindex, FALSE);
+	dst = nm_ip4_config_capture (ifindex, FALSE);
+	nm_ip4_config_subtract (dst, src);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (dst), ==, 0);
+	g_object_unref (src);
+	g_object_unref (dst);
+
+	nm_platform_link_delete (NM_PLATFORM_GET, ifindex);
+}
+
 static void
 test_compare_with_source (void)
 {
@@ -322,6 +373,164 @@ test_strip_search_trailing_dot (void)
 	g_object_unref (config);
 }
 
+static void
+_fill_large_config (NMIP4Config *config, guint first, guint n)
+{
+	guint i;
+
+	for (i = first; i < first + n; i++) {
+		NMPlatformIP4Address addr = {
+			.address = htonl (0x0A000000u + i),
+			.peer_address = htonl (0x0A000000u + i),
+			.plen = 32,
+		};
+		NMPlatformIP4Route route = {
+			.network = htonl (0xC0000000u + (i << 8)),
+			.plen = 24,
+			.gateway = htonl (0x0A000001u),
+		};
+
+		nm_ip4_config_add_address (config, &addr);
+		nm_ip4_config_add_route (config, &route);
+	}
+}
+
+static void
+test_large_config (void)
+{
+	/* With "-m perf", merge/intersect/subtract configs with 100k addresses
+	 * and routes each and report the time taken. The operations are expected
+	 * to scale linearly with the number of entries. */
+	const guint n = g_test_perf () ? 100000 : 2000;
+	NMIP4Config *a, *b;
+	gint64 start, elapsed;
+	NMPlatformIP4Route route;
+
+	start = nm_utils_get_monotonic_timestamp_ns ();
+
+	a = nm_ip4_config_new (1);
+	b = nm_ip4_config_new (1);
+	_fill_large_config (a, 0, n);
+	_fill_large_config (b, n / 2, n);
+
+	/* adding an already present route updates it in place */
+	route = *nm_ip4_config_get_route (a, n - 1);
+	route.metric = 42;
+	nm_ip4_config_add_route (a, &route);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (a), ==, n);
+	g_assert_cmpuint (nm_ip4_config_get_route (a, n - 1)->metric, ==, 42);
+
+	nm_ip4_config_merge (a, b, NM_IP_CONFIG_MERGE_DEFAULT);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (a), ==, n + n / 2);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (a), ==, n + n / 2);
+	g_assert (nm_ip4_config_address_exists (a, nm_ip4_config_get_address (b, n - 1)));
+
+	nm_ip4_config_subtract (a, b);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (a), ==, n / 2);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (a), ==, n / 2);
+	g_assert_cmpuint (nm_ip4_config_get_address (a, 0)->address, ==, htonl (0x0A000000u));
+	g_assert (!nm_ip4_config_address_exists (a, nm_ip4_config_get_address (b, 0)));
+
+	_fill_large_config (a, n / 2, n / 4);
+	nm_ip4_config_intersect (a, b);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (a), ==, n / 4);
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (a), ==, n / 4);
+	g_assert_cmpuint (nm_ip4_config_get_address (a, 0)->address, ==, htonl (0x0A000000u + n / 2));
+
+	elapsed = nm_utils_get_monotonic_timestamp_ns () - start;
+	g_test_message ("large config: %u entries took %.3f msec", n, elapsed / 1000000.0);
+	if (g_test_perf ()) {
+		g_test_minimized_result (elapsed / 1000000000.0,
+		                         "large config: %u entries took %.3f sec",
+		                         n, elapsed / 1000000000.0);
+	}
+
+	g_object_unref (a);
+	g_object_unref (b);
+}
+
+/*****************************************************************************/
+
+#define _assert_commits(commits, skipped) \
+	G_STMT_START { \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS), ==, (commits)); \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED), ==, (skipped)); \
+	} G_STMT_END
+
+static void
+test_commit_skip (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, "eth0");
+	gs_unref_object NMIP4Config *config = NULL;
+	NMPlatformIP4Address addr;
+	NMPlatformIP4Route route;
+	guint64 commits, skipped;
+
+	g_assert_cmpint (ifindex, >, 0);
+
+	config = nm_ip4_config_new (ifindex);
+	addr = *nmtst_platform_ip4_address_full ("192.168.1.10", NULL, 24, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                                         nm_utils_get_monotonic_timestamp_s (),
+	                                         NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT,
+	                                         0, NULL);
+	nm_ip4_config_add_address (config, &addr);
+	route = *nmtst_platform_ip4_route_full ("10.0.0.0", 8, NULL, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                                        100, 0, RT_SCOPE_LINK, NULL);
+	nm_ip4_config_add_route (config, &route);
+
+	commits = nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS);
+	skipped = nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED);
+
+	g_assert (nm_ip4_config_commit (config, ifindex, TRUE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen, addr.peer_address));
+	g_assert (nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, route.network, route.plen, route.metric));
+
+	/* neither the config nor the platform changed */
+	g_assert (nm_ip4_config_commit (config, ifindex, TRUE, -1));
+	_assert_commits (commits, ++skipped);
+
+	/* the commit arguments are part of the input */
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (commits, ++skipped);
+
+	/* a new lifetime of an existing address must be synced */
+	addr.lifetime = 3600;
+	addr.preferred = 1800;
+	nm_ip4_config_add_address (config, &addr);
+	g_assert_cmpint (nm_ip4_config_get_num_addresses (config), ==, 1);
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert_cmpuint (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen, addr.peer_address)->lifetime, <=, 3600);
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (commits, ++skipped);
+
+	/* so must a changed route */
+	route.mss = 1400;
+	nm_ip4_config_add_route (config, &route);
+	g_assert_cmpint (nm_ip4_config_get_num_routes (config), ==, 1);
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert_cmpuint (nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, route.network, route.plen, route.metric)->mss, ==, 1400);
+
+	/* an unchanged config is synced again after the platform changed */
+	g_assert (nm_platform_ip4_address_delete (NM_PLATFORM_GET, ifindex, addr.address, addr.plen, addr.peer_address));
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen, addr.peer_address));
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (commits, ++skipped);
+
+	/* so must an emptied config */
+	nm_ip4_config_reset_addresses (config);
+	nm_ip4_config_reset_routes (config);
+	g_assert (nm_ip4_config_commit (config, ifindex, FALSE, -1));
+	_assert_commits (++commits, skipped);
+	g_assert (!nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen, addr.peer_address));
+}
+
 /*****************************************************************************/
 
 NMTST_DEFINE ();
@@ -331,12 +540,17 @@ main (int argc, char **argv)
 {
 	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
 
+	nm_fake_platform_setup ();
+
 	g_test_add_func ("/ip4-config/subtract", test_subtract);
+	g_test_add_func ("/ip4-config/subtract-duplicate-id", test_subtract_duplicate_id);
 	g_test_add_func ("/ip4-config/compare-with-source", test_compare_with_source);
 	g_test_add_func ("/ip4-config/add-address-with-source", test_add_address_with_source);
 	g_test_add_func ("/ip4-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip4-config/merge-subtract-mss-mtu", test_merge_subtract_mss_mtu);
 	g_test_add_func ("/ip4-config/strip-search-trailing-dot", test_strip_search_trailing_dot);
+	g_test_add_func ("/ip4-config/large-config", test_large_config);
+	g_test_add_func ("/ip4-config/commit-skip", test_commit_skip);
 
 	return g_test_run ();
 }
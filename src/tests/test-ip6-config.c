@@ -24,8 +24,10 @@
 #include <arpa/inet.h>
 
 #include "nm-ip6-config.h"
+#include "nm-perf-counters.h"
 
 #include "platform/nm-platform.h"
+#include "platform/nm-fake-platform.h"
 #include "nm-test-utils-core.h"
 
 static NMIP6Config *
@@ -345,6 +347,88 @@ test_strip_search_trailing_dot (void)
 
 /*****************************************************************************/
 
+#define _assert_commits(commits, skipped) \
+	G_STMT_START { \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS), ==, (commits)); \
+		g_assert_cmpuint (nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED), ==, (skipped)); \
+	} G_STMT_END
+
+static void
+test_commit_skip (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, "eth0");
+	gs_unref_object NMIP6Config *config = NULL;
+	NMPlatformIP6Address addr;
+	NMPlatformIP6Route route;
+	guint64 commits, skipped;
+
+	g_assert_cmpint (ifindex, >, 0);
+
+	config = nm_ip6_config_new (ifindex);
+	addr = *nmtst_platform_ip6_address_full ("2001:db8:1::10", NULL, 64, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                                         nm_utils_get_monotonic_timestamp_s (),
+	                                         NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT,
+	                                         0);
+	nm_ip6_config_add_address (config, &addr);
+	route = *nmtst_platform_ip6_route_full ("2001:db8:2::", 64, NULL, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                                        100, 0);
+	nm_ip6_config_add_route (config, &route);
+
+	commits = nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS);
+	skipped = nm_perf_counter_get (NM_PERF_COUNTER_IP_CONFIG_COMMITS_SKIPPED);
+
+	g_assert (nm_ip6_config_commit (config, ifindex, TRUE));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen));
+	g_assert (nm_platform_ip6_route_get (NM_PLATFORM_GET, ifindex, route.network, route.plen, route.metric));
+
+	/* neither the config nor the platform changed */
+	g_assert (nm_ip6_config_commit (config, ifindex, TRUE));
+	_assert_commits (commits, ++skipped);
+
+	/* the commit arguments are part of the input */
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (commits, ++skipped);
+
+	/* a new lifetime of an existing address must be synced */
+	addr.lifetime = 3600;
+	addr.preferred = 1800;
+	nm_ip6_config_add_address (config, &addr);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (config), ==, 1);
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (++commits, skipped);
+	g_assert_cmpuint (nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen)->lifetime, <=, 3600);
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (commits, ++skipped);
+
+	/* so must a changed route */
+	route.mss = 1400;
+	nm_ip6_config_add_route (config, &route);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (config), ==, 1);
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (++commits, skipped);
+	g_assert_cmpuint (nm_platform_ip6_route_get (NM_PLATFORM_GET, ifindex, route.network, route.plen, route.metric)->mss, ==, 1400);
+
+	/* an unchanged config is synced again after the platform changed */
+	g_assert (nm_platform_ip6_address_delete (NM_PLATFORM_GET, ifindex, addr.address, addr.plen));
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (++commits, skipped);
+	g_assert (nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen));
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (commits, ++skipped);
+
+	/* so must an emptied config */
+	nm_ip6_config_reset_addresses (config);
+	nm_ip6_config_reset_routes (config);
+	g_assert (nm_ip6_config_commit (config, ifindex, FALSE));
+	_assert_commits (++commits, skipped);
+	g_assert (!nm_platform_ip6_address_get (NM_PLATFORM_GET, ifindex, addr.address, addr.plen));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -352,12 +436,15 @@ main (int argc, char **argv)
 {
 	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
 
+	nm_fake_platform_setup ();
+
 	g_test_add_func ("/ip6-config/subtract", test_subtract);
 	g_test_add_func ("/ip6-config/compare-with-source", test_compare_with_source);
 	g_test_add_func ("/ip6-config/add-address-with-source", test_add_address_with_source);
 	g_test_add_func ("/ip6-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip6-config/test_nm_ip6_config_addresses_sort", test_nm_ip6_config_addresses_sort);
 	g_test_add_func ("/ip6-config/strip-search-trailing-dot", test_strip_search_trailing_dot);
+	g_test_add_func ("/ip6-config/commit-skip", test_commit_skip);
 
 	return g_test_run ();
 }
@@ -116,6 +116,15 @@ typedef struct {
 	gboolean service_running;
 	NMVpnPluginInfo *plugin_info;
 	char *bus_name;
+	char *object_path;
+	bool shared_service:1;
+	bool shared_service_spawner:1;
+
+	/* The last Config, Ip4Config and Ip6Config dictionaries of the plugin,
+	 * to expand delta updates against. */
+	GVariant *plugin_config;
+	GVariant *plugin_ip4_config;
+	GVariant *plugin_ip6_config;
 
 	/* Firewall */
 	NMFirewallManagerCallId fw_call;
@@ -192,6 +201,8 @@ static void _set_vpn_state (NMVpnConnection *self,
                             NMActiveConnectionStateReason reason,
                             gboolean quitting);
 
+static void _shared_service_spawn_release (NMVpnConnection *self);
+
 /*****************************************************************************/
 
 #define _NMLOG_DOMAIN      LOGD_VPN
@@ -431,8 +442,14 @@ vpn_cleanup (NMVpnConnection *self, NMDevice *parent_dev)
 	priv->ip_iface = NULL;
 	priv->ip_ifindex = 0;
 
+	_shared_service_spawn_release (self);
 	g_free (priv->bus_name);
 	priv->bus_name = NULL;
+	g_clear_pointer (&priv->object_path, g_free);
+
+	g_clear_pointer (&priv->plugin_config, g_variant_unref);
+	g_clear_pointer (&priv->plugin_ip4_config, g_variant_unref);
+	g_clear_pointer (&priv->plugin_ip6_config, g_variant_unref);
 
 	/* Clear out connection secrets to ensure that the settings service
 	 * gets asked for them next time the connection is activated.
@@ -1914,6 +1931,50 @@ secrets_required_cb (GDBusProxy  *proxy,
 	plugin_interactive_secrets_required (self, message, secrets);
 }
 
+/* Expands a Config/Ip4Config/Ip6Config dictionary marked as delta to the
+ * full dictionary by taking the missing items from the previous one.
+ * A delta without a previous dictionary, for example one that raced with
+ * a restart of the plugin, is taken as the full dictionary. The "delta"
+ * key itself is never part of the result. Returns the full dictionary,
+ * which also becomes the new @p_last. */
+GVariant *
+_nm_vpn_connection_config_expand_delta (GVariant **p_last, GVariant *dict)
+{
+	GVariantBuilder builder;
+	GVariantIter iter;
+	const char *key;
+	GVariant *value;
+	gboolean delta = FALSE;
+
+	g_variant_lookup (dict, NM_VPN_PLUGIN_CONFIG_DELTA, "b", &delta);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	if (delta && *p_last) {
+		g_variant_iter_init (&iter, *p_last);
+		while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+			gs_unref_variant GVariant *value_new = NULL;
+
+			value_new = g_variant_lookup_value (dict, key, NULL);
+			if (!value_new)
+				g_variant_builder_add (&builder, "{sv}", key, value);
+			g_variant_unref (value);
+		}
+	}
+
+	g_variant_iter_init (&iter, dict);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		if (!nm_streq (key, NM_VPN_PLUGIN_CONFIG_DELTA))
+			g_variant_builder_add (&builder, "{sv}", key, value);
+		g_variant_unref (value);
+	}
+
+	if (*p_last)
+		g_variant_unref (*p_last);
+	*p_last = g_variant_ref_sink (g_variant_builder_end (&builder));
+	return *p_last;
+}
+
 static void
 config_cb (GDBusProxy *proxy,
            GVariant   *dict,
@@ -1924,7 +1985,7 @@ config_cb (GDBusProxy *proxy,
 
 	/* Only list to this signals during and after connection */
 	if (priv->vpn_state >= STATE_NEED_AUTH)
-		nm_vpn_connection_config_get (self, dict);
+		nm_vpn_connection_config_get (self, _nm_vpn_connection_config_expand_delta (&priv->plugin_config, dict));
 }
 
 static void
@@ -1937,7 +1998,7 @@ ip4_config_cb (GDBusProxy *proxy,
 
 	/* Only list to this signals during and after connection */
 	if (priv->vpn_state >= STATE_NEED_AUTH)
-		nm_vpn_connection_ip4_config_get (self, dict);
+		nm_vpn_connection_ip4_config_get (self, _nm_vpn_connection_config_expand_delta (&priv->plugin_ip4_config, dict));
 }
 
 static void
@@ -1950,7 +2011,49 @@ ip6_config_cb (GDBusProxy *proxy,
 
 	/* Only list to this signals during and after connection */
 	if (priv->vpn_state >= STATE_NEED_AUTH)
-		nm_vpn_connection_ip6_config_get (self, dict);
+		nm_vpn_connection_ip6_config_get (self, _nm_vpn_connection_config_expand_delta (&priv->plugin_ip6_config, dict));
+}
+
+/* Shared services that were spawned and did not yet appear on the bus,
+ * by bus name, with the connection that spawned them. Connections
+ * activated meanwhile wait for that instance instead of spawning another
+ * one. Only the spawning connection releases the entry: when the service
+ * appears, when it times out waiting, and when it is cleaned up or
+ * disposed before that. */
+static GHashTable *_shared_service_spawns;
+
+static gboolean
+_shared_service_spawn_pending (const char *bus_name)
+{
+	return    _shared_service_spawns
+	       && g_hash_table_contains (_shared_service_spawns, bus_name);
+}
+
+static void
+_shared_service_spawn_start (NMVpnConnection *self)
+{
+	NMVpnConnectionPrivate *priv = NM_VPN_CONNECTION_GET_PRIVATE (self);
+
+	nm_assert (priv->shared_service && priv->bus_name);
+	nm_assert (!priv->shared_service_spawner);
+
+	if (!_shared_service_spawns)
+		_shared_service_spawns = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_insert (_shared_service_spawns, g_strdup (priv->bus_name), self);
+	priv->shared_service_spawner = TRUE;
+}
+
+static void
+_shared_service_spawn_release (NMVpnConnection *self)
+{
+	NMVpnConnectionPrivate *priv = NM_VPN_CONNECTION_GET_PRIVATE (self);
+
+	if (!priv->shared_service_spawner)
+		return;
+
+	priv->shared_service_spawner = FALSE;
+	if (g_hash_table_lookup (_shared_service_spawns, priv->bus_name) == self)
+		g_hash_table_remove (_shared_service_spawns, priv->bus_name);
 }
 
 static void
@@ -1969,6 +2072,8 @@ _name_owner_changed (GObject *object,
 		priv->service_running = TRUE;
 		_LOGI ("Saw the service appear; activating connection");
 
+		_shared_service_spawn_release (self);
+
 		/* No need to wait for the timeout any longer */
 		nm_clear_g_source (&priv->start_timeout);
 
@@ -2013,6 +2118,7 @@ _daemon_exec_timeout (gpointer data)
 
 	_LOGW ("Timed out waiting for the service to start");
 	priv->start_timeout = 0;
+	_shared_service_spawn_release (self);
 	nm_vpn_connection_disconnect (self, NM_ACTIVE_CONNECTION_STATE_REASON_SERVICE_START_TIMEOUT, FALSE);
 	return G_SOURCE_REMOVE;
 }
@@ -2074,7 +2180,8 @@ nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
 	i = 0;
 	vpn_argv[i++] = (char *) nm_vpn_plugin_info_get_program (priv->plugin_info);
 	g_return_val_if_fail (vpn_argv[0], FALSE);
-	if (nm_vpn_plugin_info_supports_multiple (priv->plugin_info)) {
+	if (   !priv->shared_service
+	    && nm_vpn_plugin_info_supports_multiple (priv->plugin_info)) {
 		vpn_argv[i++] = "--bus-name";
 		vpn_argv[i++] = priv->bus_name;
 	}
@@ -2108,6 +2215,8 @@ nm_vpn_service_daemon_exec (NMVpnConnection *self, GError **error)
 	if (success) {
 		_LOGI ("Started the VPN service, PID %ld", (long int) pid);
 		priv->start_timeout = g_timeout_add_seconds (5, _daemon_exec_timeout, self);
+		if (priv->shared_service)
+			_shared_service_spawn_start (self);
 	} else {
 		g_set_error (error,
 		             NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
@@ -2154,6 +2263,13 @@ on_proxy_acquired (GObject *object, GAsyncResult *result, gpointer user_data)
 	if (priv->service_running)
 		return;
 
+	if (   priv->shared_service
+	    && _shared_service_spawn_pending (priv->bus_name)) {
+		_LOGI ("Waiting for the shared VPN service to start");
+		priv->start_timeout = g_timeout_add_seconds (5, _daemon_exec_timeout, self);
+		return;
+	}
+
 	if (!nm_vpn_service_daemon_exec (self, &error)) {
 		_LOGW ("Could not launch the VPN service. error: %s.",
 		       error->message);
@@ -2182,7 +2298,20 @@ nm_vpn_connection_activate (NMVpnConnection *self,
 	service = nm_vpn_plugin_info_get_service (plugin_info);
 	nm_assert (service);
 
-	if (nm_vpn_plugin_info_supports_multiple (plugin_info)) {
+	if (nm_vpn_plugin_info_supports_shared_service (plugin_info)) {
+		const char *path;
+
+		path = nm_exported_object_get_path (NM_EXPORTED_OBJECT (self));
+		if (path)
+			path = strrchr (path, '/');
+		g_return_if_fail (path);
+
+		/* one instance of the service hosts all connections, each as
+		 * its own plugin object. */
+		priv->shared_service = TRUE;
+		priv->bus_name = g_strdup (service);
+		priv->object_path = g_strdup_printf ("%s/Connection_%s", NM_VPN_DBUS_PLUGIN_PATH, &path[1]);
+	} else if (nm_vpn_plugin_info_supports_multiple (plugin_info)) {
 		const char *path;
 
 		path = nm_exported_object_get_path (NM_EXPORTED_OBJECT (self));
@@ -2202,7 +2331,7 @@ nm_vpn_connection_activate (NMVpnConnection *self,
 	                          G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
 	                          NULL,
 	                          priv->bus_name,
-	                          NM_VPN_DBUS_PLUGIN_PATH,
+	                          priv->object_path ?: NM_VPN_DBUS_PLUGIN_PATH,
 	                          NM_VPN_DBUS_PLUGIN_INTERFACE,
 	                          priv->cancellable,
 	                          (GAsyncReadyCallback) on_proxy_acquired,
@@ -2620,6 +2749,7 @@ dispose (GObject *object)
 	NMVpnConnectionPrivate *priv = NM_VPN_CONNECTION_GET_PRIVATE (self);
 
 	nm_clear_g_source (&priv->start_timeout);
+	_shared_service_spawn_release (self);
 
 	g_clear_pointer (&priv->connect_hash, g_variant_unref);
 
@@ -2636,6 +2766,9 @@ dispose (GObject *object)
 	nm_exported_object_clear_and_unexport (&priv->ip6_config);
 	g_clear_object (&priv->proxy);
 	g_clear_object (&priv->plugin_info);
+	g_clear_pointer (&priv->plugin_config, g_variant_unref);
+	g_clear_pointer (&priv->plugin_ip4_config, g_variant_unref);
+	g_clear_pointer (&priv->plugin_ip6_config, g_variant_unref);
 
 	fw_call_cleanup (self);
 
@@ -2653,6 +2786,7 @@ finalize (GObject *object)
 	g_free (priv->banner);
 	g_free (priv->ip_iface);
 	g_free (priv->username);
+	g_free (priv->object_path);
 	g_free (priv->ip6_internal_gw);
 	g_free (priv->ip6_external_gw);
 
@@ -80,4 +80,7 @@ struct in6_addr *    nm_vpn_connection_get_ip6_internal_gateway (NMVpnConnection
 guint32              nm_vpn_connection_get_ip4_route_metric (NMVpnConnection *self);
 guint32              nm_vpn_connection_get_ip6_route_metric (NMVpnConnection *self);
 
+/* For testing only */
+GVariant *_nm_vpn_connection_config_expand_delta (GVariant **p_last, GVariant *dict);
+
 #endif /* __NM_VPN_CONNECTION_H__ */
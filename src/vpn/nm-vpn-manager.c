@@ -83,6 +83,7 @@ nm_vpn_manager_activate_connection (NMVpnManager *manager,
 	NMVpnPluginInfo *plugin_info;
 	const char *service_name;
 	NMDevice *device;
+	gboolean supports_multiple;
 
 	g_return_val_if_fail (NM_IS_VPN_MANAGER (manager), FALSE);
 	g_return_val_if_fail (NM_IS_VPN_CONNECTION (vpn), FALSE);
@@ -108,7 +109,10 @@ nm_vpn_manager_activate_connection (NMVpnManager *manager,
 		return FALSE;
 	}
 
-	if (   !nm_vpn_plugin_info_supports_multiple (plugin_info)
+	supports_multiple =    nm_vpn_plugin_info_supports_multiple (plugin_info)
+	                    || nm_vpn_plugin_info_supports_shared_service (plugin_info);
+
+	if (   !supports_multiple
 	    && g_hash_table_contains (priv->active_services, service_name)) {
 		g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_CONNECTION_NOT_AVAILABLE,
 		             "The '%s' plugin only supports a single active connection.",
@@ -118,7 +122,7 @@ nm_vpn_manager_activate_connection (NMVpnManager *manager,
 
 	nm_vpn_connection_activate (vpn, plugin_info);
 
-	if (!nm_vpn_plugin_info_supports_multiple (plugin_info)) {
+	if (!supports_multiple) {
 		/* Block activations of the connections of the same service type. */
 		g_hash_table_add (priv->active_services, g_strdup (service_name));
 		g_signal_connect (vpn, "notify::" NM_ACTIVE_CONNECTION_STATE,
@@ -0,0 +1,515 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2017 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+#include "vpn/nm-vpn-connection.h"
+#include "settings/nm-settings-connection.h"
+#include "platform/nm-fake-platform.h"
+#include "tests/config/nm-test-device.h"
+#include "nm-auth-manager.h"
+#include "nm-auth-subject.h"
+#include "nm-bus-manager.h"
+#include "nm-ip4-config.h"
+
+#include "nm-test-utils-core.h"
+
+/* The mock shared plugin service, tools/test-vpn-shared-service.py, runs on
+ * the session bus. One instance hosts both connections, each at its own
+ * object path, and sends a delta Ip4Config for each every second. The
+ * configs are expanded like the daemon does for its own connections.
+ *
+ * For the daemon side, main() points the system bus at the session bus,
+ * so that NMVpnConnection finds the mock where it expects a plugin. */
+
+#define TEST_BUS_NAME "org.freedesktop.NetworkManager.test-vpn-shared"
+#define TEST_SERVICE  "org.freedesktop.NetworkManager.test-vpn-shared-activate"
+#define N_CONNECTIONS 2
+
+typedef struct {
+	GDBusProxy *proxy;
+	const char *address;
+	guint32 state;
+	GVariant *ip4_config;
+	guint n_ip4_configs;
+	guint n_deltas;
+} TestConnection;
+
+typedef struct {
+	GMainLoop *loop;
+	TestConnection cons[N_CONNECTIONS];
+	guint wait_deltas;
+} TestData;
+
+/*****************************************************************************/
+
+static gboolean
+_all_connections_have (TestData *data, guint n_deltas)
+{
+	guint i;
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		if (   data->cons[i].state != NM_VPN_SERVICE_STATE_STARTED
+		    || !data->cons[i].ip4_config
+		    || data->cons[i].n_deltas < n_deltas)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_plugin_signal_cb (GDBusProxy *proxy,
+                   const char *sender_name,
+                   const char *signal_name,
+                   GVariant *parameters,
+                   gpointer user_data)
+{
+	TestData *data = user_data;
+	TestConnection *con = NULL;
+	guint i;
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		if (data->cons[i].proxy == proxy)
+			con = &data->cons[i];
+	}
+	g_assert (con);
+
+	if (nm_streq (signal_name, "StateChanged"))
+		g_variant_get (parameters, "(u)", &con->state);
+	else if (nm_streq (signal_name, "Ip4Config")) {
+		gs_unref_variant GVariant *dict = NULL;
+		gboolean delta = FALSE;
+
+		g_variant_get (parameters, "(@a{sv})", &dict);
+		if (   g_variant_lookup (dict, NM_VPN_PLUGIN_CONFIG_DELTA, "b", &delta)
+		    && delta) {
+			/* a delta never comes before the full config */
+			g_assert (con->ip4_config);
+			con->n_deltas++;
+		}
+		_nm_vpn_connection_config_expand_delta (&con->ip4_config, dict);
+		con->n_ip4_configs++;
+	}
+
+	if (_all_connections_have (data, data->wait_deltas))
+		g_main_loop_quit (data->loop);
+}
+
+static GVariant *
+_connection_dict (const char *address, const char *tundev)
+{
+	GVariantBuilder vpn_data;
+	GVariantBuilder vpn;
+	GVariantBuilder connection;
+
+	g_variant_builder_init (&vpn_data, G_VARIANT_TYPE ("a{ss}"));
+	g_variant_builder_add (&vpn_data, "{ss}", "address", address);
+	g_variant_builder_add (&vpn_data, "{ss}", "prefix", "24");
+	g_variant_builder_add (&vpn_data, "{ss}", "tundev", tundev);
+
+	g_variant_builder_init (&vpn, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&vpn, "{sv}", NM_SETTING_VPN_DATA, g_variant_builder_end (&vpn_data));
+
+	g_variant_builder_init (&connection, G_VARIANT_TYPE ("a{sa{sv}}"));
+	g_variant_builder_add (&connection, "{s@a{sv}}", NM_SETTING_VPN_SETTING_NAME, g_variant_builder_end (&vpn));
+
+	return g_variant_new ("(@a{sa{sv}})", g_variant_builder_end (&connection));
+}
+
+static void
+_assert_ip4_config (TestConnection *con)
+{
+	char dns[INET_ADDRSTRLEN];
+	guint32 address, prefix;
+	gs_unref_variant GVariant *dns_servers = NULL;
+	const guint32 *servers;
+	gsize n_servers;
+
+	g_assert (con->ip4_config);
+	g_assert (!g_variant_lookup_value (con->ip4_config, NM_VPN_PLUGIN_CONFIG_DELTA, NULL));
+
+	/* items missing from a delta are taken from the previous config */
+	g_assert (g_variant_lookup (con->ip4_config, NM_VPN_PLUGIN_IP4_CONFIG_ADDRESS, "u", &address));
+	g_assert_cmpuint (address, ==, nmtst_inet4_from_string (con->address));
+	g_assert (g_variant_lookup (con->ip4_config, NM_VPN_PLUGIN_IP4_CONFIG_PREFIX, "u", &prefix));
+	g_assert_cmpuint (prefix, ==, 24);
+
+	/* each delta rotates the DNS server */
+	nm_sprintf_buf (dns, "10.8.0.%u", 53 + (con->n_deltas % 8));
+	dns_servers = g_variant_lookup_value (con->ip4_config, NM_VPN_PLUGIN_IP4_CONFIG_DNS, G_VARIANT_TYPE ("au"));
+	g_assert (dns_servers);
+	servers = g_variant_get_fixed_array (dns_servers, &n_servers, sizeof (guint32));
+	g_assert_cmpuint (n_servers, ==, 1);
+	g_assert_cmpuint (servers[0], ==, nmtst_inet4_from_string (dns));
+}
+
+static void
+test_shared_service_two_connections (void)
+{
+	const char *const args[] = { TEST_NM_PYTHON, TEST_VPN_SHARED_SERVICE,
+	                             "--session",
+	                             "--bus-name", TEST_BUS_NAME,
+	                             "--delta-interval", "1",
+	                             "--idle-timeout", "10",
+	                             NULL };
+	const char *const addresses[N_CONNECTIONS] = { "10.8.0.2", "10.8.1.2" };
+	gs_unref_object GDBusConnection *bus = NULL;
+	GError *error = NULL;
+	TestData data = { };
+	GPid pid;
+	guint i;
+
+	bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+
+	if (!g_spawn_async (NULL, (char **) args, NULL, G_SPAWN_SEARCH_PATH,
+	                    NULL, NULL, &pid, &error))
+		g_assert_no_error (error);
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		TestConnection *con = &data.cons[i];
+		gs_free char *path = g_strdup_printf ("%s/Connection_%u", NM_VPN_DBUS_PLUGIN_PATH, i + 1);
+
+		con->address = addresses[i];
+		con->proxy = g_dbus_proxy_new_sync (bus,
+		                                    G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+		                                    G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+		                                    NULL,
+		                                    TEST_BUS_NAME,
+		                                    path,
+		                                    NM_VPN_DBUS_PLUGIN_INTERFACE,
+		                                    NULL, &error);
+		g_assert_no_error (error);
+		g_signal_connect (con->proxy, "g-signal", G_CALLBACK (_plugin_signal_cb), &data);
+	}
+
+	/* Wait until the service is registered on the bus */
+	for (i = 1000; i > 0; i--) {
+		gs_free char *owner = g_dbus_proxy_get_name_owner (data.cons[0].proxy);
+
+		if (owner)
+			break;
+		g_main_context_iteration (NULL, FALSE);
+		g_usleep (G_USEC_PER_SEC / 50);
+	}
+	g_assert (i > 0);
+
+	/* both connections are started while the other one is active */
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		gs_unref_variant GVariant *ret = NULL;
+		gs_free char *tundev = g_strdup_printf ("tun%u", i);
+
+		ret = g_dbus_proxy_call_sync (data.cons[i].proxy, "Connect",
+		                              _connection_dict (addresses[i], tundev),
+		                              G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+		g_assert_no_error (error);
+	}
+
+	data.wait_deltas = 0;
+	if (!_all_connections_have (&data, 0))
+		g_assert (nmtst_main_loop_run (data.loop, 5000));
+	for (i = 0; i < N_CONNECTIONS; i++)
+		_assert_ip4_config (&data.cons[i]);
+
+	/* a delta only carries the new DNS server */
+	data.wait_deltas = 1;
+	if (!_all_connections_have (&data, 1))
+		g_assert (nmtst_main_loop_run (data.loop, 5000));
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		g_assert_cmpuint (data.cons[i].n_ip4_configs, ==, data.cons[i].n_deltas + 1);
+		_assert_ip4_config (&data.cons[i]);
+	}
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		gs_unref_variant GVariant *ret = NULL;
+
+		ret = g_dbus_proxy_call_sync (data.cons[i].proxy, "Disconnect", NULL,
+		                              G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+		g_assert_no_error (error);
+	}
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		g_object_unref (data.cons[i].proxy);
+		g_clear_pointer (&data.cons[i].ip4_config, g_variant_unref);
+	}
+	g_main_loop_unref (data.loop);
+
+	kill (pid, SIGTERM);
+	g_spawn_close_pid (pid);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	NMVpnConnection *vpns[N_CONNECTIONS];
+} ActivateData;
+
+static gboolean
+_all_vpns_have_ip4_config (ActivateData *data)
+{
+	guint i;
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		if (!nm_vpn_connection_get_ip4_config (data->vpns[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_vpn_ip4_config_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	ActivateData *data = user_data;
+
+	if (_all_vpns_have_ip4_config (data))
+		g_main_loop_quit (data->loop);
+}
+
+static NMSettingsConnection *
+_create_settings_connection (guint i, const char *address)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	gs_free char *id = g_strdup_printf ("vpn-shared-%u", i);
+	gs_free char *tundev = g_strdup_printf ("tun%u", i);
+	NMSettingsConnection *settings_connection;
+	NMSettingVpn *s_vpn;
+
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_VPN_SETTING_NAME, NULL);
+	s_vpn = nm_connection_get_setting_vpn (connection);
+	g_object_set (s_vpn, NM_SETTING_VPN_SERVICE_TYPE, TEST_SERVICE, NULL);
+	nm_setting_vpn_add_data_item (s_vpn, "address", address);
+	nm_setting_vpn_add_data_item (s_vpn, "prefix", "24");
+	nm_setting_vpn_add_data_item (s_vpn, "tundev", tundev);
+	nmtst_connection_normalize (connection);
+
+	/* without cached system secrets, the daemon goes on to ask the
+	 * plugin directly, which needs none. */
+	settings_connection = g_object_new (NM_TYPE_SETTINGS_CONNECTION, NULL);
+	nm_connection_replace_settings_from_connection (NM_CONNECTION (settings_connection), connection);
+	return settings_connection;
+}
+
+static void
+test_shared_service_activate (void)
+{
+	const char *const addresses[N_CONNECTIONS] = { "10.9.0.2", "10.9.1.2" };
+	gs_free char *tmpdir = NULL;
+	gs_free char *program = NULL;
+	gs_free char *spawn_log = NULL;
+	gs_free char *script = NULL;
+	gs_free char *spawns = NULL;
+	gs_strfreev char **pids = NULL;
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	gs_unref_object NMVpnPluginInfo *plugin_info = NULL;
+	gs_unref_object NMDevice *parent = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+	NMSettingsConnection *settings_connections[N_CONNECTIONS];
+	ActivateData data = { };
+	GError *error = NULL;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("test-vpn-shared-XXXXXX", &error);
+	g_assert_no_error (error);
+	program = g_build_filename (tmpdir, "nm-test-shared-service", NULL);
+	spawn_log = g_build_filename (tmpdir, "spawns", NULL);
+
+	/* the daemon starts the plugin without arguments. Log each start
+	 * before running the mock in place of the shell. */
+	script = g_strdup_printf ("#!/bin/sh\n"
+	                          "echo $$ >> '%s'\n"
+	                          "exec '%s' '%s' --bus-name '%s' --idle-timeout 10\n",
+	                          spawn_log, TEST_NM_PYTHON, TEST_VPN_SHARED_SERVICE, TEST_SERVICE);
+	g_file_set_contents (program, script, -1, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (chmod (program, 0755), ==, 0);
+
+	keyfile = g_key_file_new ();
+	g_key_file_set_string (keyfile, NM_VPN_PLUGIN_INFO_KF_GROUP_CONNECTION, "name", "test-vpn-shared");
+	g_key_file_set_string (keyfile, NM_VPN_PLUGIN_INFO_KF_GROUP_CONNECTION, "service", TEST_SERVICE);
+	g_key_file_set_string (keyfile, NM_VPN_PLUGIN_INFO_KF_GROUP_CONNECTION, "program", program);
+	g_key_file_set_string (keyfile, NM_VPN_PLUGIN_INFO_KF_GROUP_CONNECTION, "supports-shared-service", "true");
+	plugin_info = nm_vpn_plugin_info_new_with_data (NULL, keyfile, &error);
+	g_assert_no_error (error);
+	g_assert (nm_vpn_plugin_info_supports_shared_service (plugin_info));
+
+	parent = nm_test_device_new ("00:11:22:33:44:55");
+	subject = nm_auth_subject_new_internal ();
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	/* both connections are activated before the service runs. The
+	 * second one must wait for the instance the first one starts. */
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		gs_free char *tundev = g_strdup_printf ("tun%u", i);
+
+		g_assert_cmpint (nm_platform_link_dummy_add (NM_PLATFORM_GET, tundev, NULL), ==, NM_PLATFORM_ERROR_SUCCESS);
+
+		settings_connections[i] = _create_settings_connection (i, addresses[i]);
+		data.vpns[i] = nm_vpn_connection_new (settings_connections[i], parent, NULL, subject);
+		nm_exported_object_export (NM_EXPORTED_OBJECT (data.vpns[i]));
+		g_signal_connect (data.vpns[i], "notify::" NM_ACTIVE_CONNECTION_IP4_CONFIG,
+		                  G_CALLBACK (_vpn_ip4_config_cb), &data);
+		nm_vpn_connection_activate (data.vpns[i], plugin_info);
+	}
+
+	g_assert (nmtst_main_loop_run (data.loop, 10000));
+	g_assert (_all_vpns_have_ip4_config (&data));
+
+	/* one process serves both connections */
+	g_file_get_contents (spawn_log, &spawns, NULL, &error);
+	g_assert_no_error (error);
+	pids = g_strsplit (g_strstrip (spawns), "\n", -1);
+	g_assert_cmpint (g_strv_length (pids), ==, 1);
+
+	/* each connection got the config of its own plugin object */
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		NMIP4Config *ip4_config = nm_vpn_connection_get_ip4_config (data.vpns[i]);
+		gs_free char *tundev = g_strdup_printf ("tun%u", i);
+		const NMPlatformIP4Address *address;
+
+		g_assert_cmpstr (nm_vpn_connection_get_ip_iface (data.vpns[i], FALSE), ==, tundev);
+		g_assert_cmpint (nm_vpn_connection_get_ip_ifindex (data.vpns[i], FALSE), ==, nm_platform_link_get_ifindex (NM_PLATFORM_GET, tundev));
+		g_assert_cmpuint (nm_ip4_config_get_num_addresses (ip4_config), ==, 1);
+		address = nm_ip4_config_get_address (ip4_config, 0);
+		g_assert_cmpuint (address->address, ==, nmtst_inet4_from_string (addresses[i]));
+		g_assert_cmpuint (address->plen, ==, 24);
+	}
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		gs_free char *tundev = g_strdup_printf ("tun%u", i);
+
+		g_signal_handlers_disconnect_by_func (data.vpns[i], G_CALLBACK (_vpn_ip4_config_cb), &data);
+		nm_vpn_connection_disconnect (data.vpns[i], NM_ACTIVE_CONNECTION_STATE_REASON_USER_DISCONNECTED, FALSE);
+		nm_exported_object_clear_and_unexport (&data.vpns[i]);
+		g_object_unref (settings_connections[i]);
+		nm_platform_link_delete (NM_PLATFORM_GET, nm_platform_link_get_ifindex (NM_PLATFORM_GET, tundev));
+	}
+	g_main_loop_unref (data.loop);
+
+	kill (_nm_utils_ascii_str_to_int64 (pids[0], 10, 1, G_MAXINT32, 0), SIGTERM);
+	unlink (spawn_log);
+	unlink (program);
+	rmdir (tmpdir);
+}
+
+/*****************************************************************************/
+
+static GVariant *
+_config_dict (int delta, guint32 mtu, const char *banner)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	if (delta != -1)
+		g_variant_builder_add (&builder, "{sv}", NM_VPN_PLUGIN_CONFIG_DELTA, g_variant_new_boolean (delta));
+	if (mtu)
+		g_variant_builder_add (&builder, "{sv}", NM_VPN_PLUGIN_CONFIG_MTU, g_variant_new_uint32 (mtu));
+	if (banner)
+		g_variant_builder_add (&builder, "{sv}", NM_VPN_PLUGIN_CONFIG_BANNER, g_variant_new_string (banner));
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+_assert_config (GVariant *config, guint32 mtu, const char *banner)
+{
+	guint32 mtu_found;
+	const char *banner_found;
+
+	g_assert (!g_variant_lookup_value (config, NM_VPN_PLUGIN_CONFIG_DELTA, NULL));
+	g_assert_cmpuint (g_variant_n_children (config), ==, !!mtu + !!banner);
+
+	if (mtu) {
+		g_assert (g_variant_lookup (config, NM_VPN_PLUGIN_CONFIG_MTU, "u", &mtu_found));
+		g_assert_cmpuint (mtu_found, ==, mtu);
+	}
+	if (banner) {
+		g_assert (g_variant_lookup (config, NM_VPN_PLUGIN_CONFIG_BANNER, "&s", &banner_found));
+		g_assert_cmpstr (banner_found, ==, banner);
+	}
+}
+
+static void
+test_config_expand_delta (void)
+{
+	GVariant *last = NULL;
+	GVariant *dict;
+
+	/* a delta without a previous config is the full config */
+	dict = _config_dict (TRUE, 1400, NULL);
+	_assert_config (_nm_vpn_connection_config_expand_delta (&last, dict), 1400, NULL);
+	g_assert (last);
+	g_variant_unref (dict);
+
+	/* a delta keeps the items it does not carry */
+	dict = _config_dict (TRUE, 0, "hello");
+	_assert_config (_nm_vpn_connection_config_expand_delta (&last, dict), 1400, "hello");
+	g_variant_unref (dict);
+
+	/* and overrides the ones it does */
+	dict = _config_dict (TRUE, 1300, NULL);
+	_assert_config (_nm_vpn_connection_config_expand_delta (&last, dict), 1300, "hello");
+	g_variant_unref (dict);
+
+	/* a full config replaces everything, whether marked or not */
+	dict = _config_dict (FALSE, 0, "bye");
+	_assert_config (_nm_vpn_connection_config_expand_delta (&last, dict), 0, "bye");
+	g_variant_unref (dict);
+
+	dict = _config_dict (-1, 1200, NULL);
+	_assert_config (_nm_vpn_connection_config_expand_delta (&last, dict), 1200, NULL);
+	g_variant_unref (dict);
+
+	g_variant_unref (last);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	const char *session_bus;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* the daemon and the plugins it starts use the system bus */
+	session_bus = g_getenv ("DBUS_SESSION_BUS_ADDRESS");
+	g_assert (session_bus);
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", session_bus, TRUE);
+
+	/* like test-config, skip nm_bus_manager_init_bus() */
+	nm_bus_manager_setup (g_object_new (NM_TYPE_BUS_MANAGER, NULL));
+	nm_auth_manager_setup (FALSE);
+	nm_fake_platform_setup ();
+
+	g_test_add_func ("/vpn/config/expand-delta", test_config_expand_delta);
+	g_test_add_func ("/vpn/shared-service/two-connections", test_shared_service_two_connections);
+	g_test_add_func ("/vpn/shared-service/activate", test_shared_service_activate);
+
+	return g_test_run ();
+}
@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+# Mock firewalld implementing the zone methods NetworkManager uses. It
+# keeps the zone of each interface, fails like firewalld when an
+# interface is added twice or removed while unknown, and records every
+# call in the order it arrived. Tests read the record with GetCalls() on
+# the org.freedesktop.NetworkManager.TestFirewallD interface.
+
+from __future__ import print_function
+
+from gi.repository import GLib
+import sys
+import argparse
+import dbus
+import dbus.service
+import dbus.mainloop.glib
+
+mainloop = GLib.MainLoop()
+
+FIREWALL_DBUS_SERVICE        = 'org.fedoraproject.FirewallD1'
+FIREWALL_DBUS_PATH           = '/org/fedoraproject/FirewallD1'
+IFACE_FIREWALL_ZONE          = 'org.fedoraproject.FirewallD1.zone'
+IFACE_TEST                   = 'org.freedesktop.NetworkManager.TestFirewallD'
+
+#########################################################
+
+class FirewallException(dbus.DBusException):
+    _dbus_error_name = 'org.fedoraproject.FirewallD1.Exception'
+
+class FirewallD(dbus.service.Object):
+    def __init__(self, bus, object_path, default_zone):
+        dbus.service.Object.__init__(self, bus, object_path)
+        self.default_zone = default_zone
+        self.zones = {}
+        self.calls = []
+
+    def __record(self, method, zone, interface):
+        self.calls.append((method, zone, interface))
+        return zone or self.default_zone
+
+    @dbus.service.method(dbus_interface=IFACE_FIREWALL_ZONE, in_signature='ss', out_signature='s')
+    def addInterface(self, zone, interface):
+        zone = self.__record('addInterface', zone, interface)
+        if interface in self.zones:
+            raise FirewallException('ZONE_ALREADY_SET')
+        self.zones[interface] = zone
+        return zone
+
+    @dbus.service.method(dbus_interface=IFACE_FIREWALL_ZONE, in_signature='ss', out_signature='s')
+    def changeZone(self, zone, interface):
+        zone = self.__record('changeZone', zone, interface)
+        self.zones[interface] = zone
+        return zone
+
+    @dbus.service.method(dbus_interface=IFACE_FIREWALL_ZONE, in_signature='ss', out_signature='s')
+    def removeInterface(self, zone, interface):
+        zone = self.__record('removeInterface', zone, interface)
+        if interface not in self.zones:
+            raise FirewallException('UNKNOWN_INTERFACE')
+        return self.zones.pop(interface)
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='a(sss)')
+    def GetCalls(self):
+        return dbus.Array(self.calls, signature='(sss)')
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='')
+    def Reset(self):
+        self.zones = {}
+        self.calls = []
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='')
+    def Quit(self):
+        GLib.idle_add(quit_cb, None)
+
+###################################################################
+def quit_cb(user_data):
+    mainloop.quit()
+    return False
+
+def main():
+    parser = argparse.ArgumentParser(description='Mock firewalld service')
+    parser.add_argument('--session', action='store_true',
+                        help='use the session bus instead of the system bus')
+    parser.add_argument('--default-zone', default='public',
+                        help='the zone used for an empty zone name (default: %(default)s)')
+    args = parser.parse_args()
+
+    dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+
+    bus = dbus.SessionBus() if args.session else dbus.SystemBus()
+    firewalld = FirewallD(bus, FIREWALL_DBUS_PATH, args.default_zone)
+
+    if bus.request_name(FIREWALL_DBUS_SERVICE, dbus.bus.NAME_FLAG_DO_NOT_QUEUE) != dbus.bus.REQUEST_NAME_REPLY_PRIMARY_OWNER:
+        print('cannot own bus name %s' % (FIREWALL_DBUS_SERVICE), file=sys.stderr)
+        sys.exit(1)
+
+    try:
+        mainloop.run()
+    except Exception as e:
+        pass
+
+    sys.exit(0)
+
+if __name__ == '__main__':
+    main()
@@ -64,6 +64,9 @@ NM_ACTIVE_CONNECTION_STATE_ACTIVATED    = 2
 NM_ACTIVE_CONNECTION_STATE_DEACTIVATING = 3
 NM_ACTIVE_CONNECTION_STATE_DEACTIVATED  = 4
 
+# AC state reason
+NM_ACTIVE_CONNECTION_STATE_REASON_NONE  = 1
+
 #########################################################
 IFACE_DBUS = 'org.freedesktop.DBus'
 
@@ -650,6 +653,18 @@ class ActiveConnection(ExportedObj):
     def PropertiesChanged(self, changed):
         pass
 
+    @dbus.service.signal(IFACE_ACTIVE_CONNECTION, signature='uu')
+    def StateChanged(self, state, reason):
+        pass
+
+    def __notify(self, propname):
+        self._dbus_property_notify(IFACE_ACTIVE_CONNECTION, propname)
+
+    def set_state(self, state, reason):
+        self.state = state
+        self.__notify(PAC_STATE)
+        self.StateChanged(dbus.UInt32(state), dbus.UInt32(reason))
+
 ###################################################################
 IFACE_TEST = 'org.freedesktop.NetworkManager.LibnmGlibTest'
 IFACE_NM = 'org.freedesktop.NetworkManager'
@@ -682,6 +697,7 @@ PM_CONNECTIVITY = 'Connectivity'
 
 def set_device_ac_cb(device, ac):
     device.set_active_connection(ac)
+    ac.set_state(NM_ACTIVE_CONNECTION_STATE_ACTIVATED, NM_ACTIVE_CONNECTION_STATE_REASON_NONE)
 
 class NetworkManager(ExportedObj):
     def __init__(self, bus, object_path):
@@ -0,0 +1,224 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+# Mock VPN plugin implementing the shared service protocol: one instance
+# hosts all connections, each as its own plugin object below
+# /org/freedesktop/NetworkManager/VPN/Plugin. It does not create any
+# tunnel; it only reports the IPv4 configuration taken from the "address",
+# "prefix" and "tundev" items of the VPN data. With --delta-interval, it
+# periodically sends delta Ip4Config updates rotating the DNS server.
+#
+# To use it with NetworkManager, install a name file like:
+#
+#   [VPN Connection]
+#   name=mock-shared
+#   service=org.freedesktop.NetworkManager.mock-shared
+#   program=/path/to/test-vpn-shared-service.py
+#   supports-shared-service=true
+#
+# and allow the service name on the system bus.
+
+from __future__ import print_function
+
+from gi.repository import GLib
+import sys
+import argparse
+import socket
+import struct
+import dbus
+import dbus.service
+import dbus.mainloop.glib
+
+mainloop = GLib.MainLoop()
+
+NM_VPN_DBUS_PLUGIN_PATH      = '/org/freedesktop/NetworkManager/VPN/Plugin'
+IFACE_VPN_PLUGIN             = 'org.freedesktop.NetworkManager.VPN.Plugin'
+DEFAULT_SERVICE              = 'org.freedesktop.NetworkManager.mock-shared'
+
+# VPN service state
+NM_VPN_SERVICE_STATE_UNKNOWN  = 0
+NM_VPN_SERVICE_STATE_INIT     = 1
+NM_VPN_SERVICE_STATE_SHUTDOWN = 2
+NM_VPN_SERVICE_STATE_STARTING = 3
+NM_VPN_SERVICE_STATE_STARTED  = 4
+NM_VPN_SERVICE_STATE_STOPPING = 5
+NM_VPN_SERVICE_STATE_STOPPED  = 6
+
+# VPN plugin failure
+NM_VPN_PLUGIN_FAILURE_LOGIN_FAILED   = 0
+NM_VPN_PLUGIN_FAILURE_CONNECT_FAILED = 1
+NM_VPN_PLUGIN_FAILURE_BAD_IP_CONFIG  = 2
+
+#########################################################
+
+def ip4_to_uint32(addr):
+    return dbus.UInt32(struct.unpack('=I', socket.inet_aton(addr))[0])
+
+class BadConnectionException(dbus.DBusException):
+    _dbus_error_name = IFACE_VPN_PLUGIN + '.BadArguments'
+
+class VpnConnection(object):
+    def __init__(self, rel_path, connection):
+        data = connection.get('vpn', {}).get('data', {})
+        self.rel_path = rel_path
+        self.address = str(data.get('address', '10.8.0.2'))
+        self.prefix = int(data.get('prefix', '24'))
+        self.tundev = str(data.get('tundev', ''))
+        self.dns_idx = 0
+        self.started = False
+
+    def config(self):
+        config = {
+            'has-ip4': dbus.Boolean(True),
+            'has-ip6': dbus.Boolean(False),
+            'gateway': ip4_to_uint32('192.0.2.1'),
+        }
+        if self.tundev:
+            config['tundev'] = dbus.String(self.tundev)
+        return dbus.Dictionary(config, signature='sv')
+
+    def dns(self):
+        return dbus.Array([ip4_to_uint32('10.8.0.%d' % (53 + self.dns_idx))], signature='u')
+
+    def ip4_config(self):
+        return dbus.Dictionary({
+            'address': ip4_to_uint32(self.address),
+            'prefix': dbus.UInt32(self.prefix),
+            'dns': self.dns(),
+            'never-default': dbus.Boolean(True),
+        }, signature='sv')
+
+    def ip4_config_delta(self):
+        self.dns_idx = (self.dns_idx + 1) % 8
+        return dbus.Dictionary({
+            'delta': dbus.Boolean(True),
+            'dns': self.dns(),
+        }, signature='sv')
+
+class SharedVpnPlugin(dbus.service.FallbackObject):
+    def __init__(self, bus, object_path, idle_timeout):
+        dbus.service.FallbackObject.__init__(self, bus, object_path)
+        self.connections = {}
+        self.idle_timeout = idle_timeout
+        self.idle_id = 0
+        self.__schedule_quit()
+
+    def __schedule_quit(self):
+        if self.idle_id:
+            GLib.source_remove(self.idle_id)
+            self.idle_id = 0
+        if not self.connections and self.idle_timeout > 0:
+            self.idle_id = GLib.timeout_add_seconds(self.idle_timeout, quit_cb, None)
+
+    def __connect(self, connection, rel_path):
+        if not rel_path or rel_path == '/':
+            raise BadConnectionException('connections must use a per-connection object path')
+        if rel_path in self.connections:
+            raise BadConnectionException('connection %s is already active' % (rel_path))
+        con = VpnConnection(rel_path, connection)
+        self.connections[rel_path] = con
+        self.__schedule_quit()
+        self.StateChanged(NM_VPN_SERVICE_STATE_STARTING, rel_path=rel_path)
+        GLib.idle_add(self.__connected_cb, con)
+
+    def __connected_cb(self, con):
+        if self.connections.get(con.rel_path) is not con:
+            return False
+        self.Config(con.config(), rel_path=con.rel_path)
+        self.Ip4Config(con.ip4_config(), rel_path=con.rel_path)
+        self.StateChanged(NM_VPN_SERVICE_STATE_STARTED, rel_path=con.rel_path)
+        con.started = True
+        return False
+
+    def send_deltas(self):
+        for con in self.connections.values():
+            # a delta is only meaningful after the full config
+            if con.started:
+                self.Ip4Config(con.ip4_config_delta(), rel_path=con.rel_path)
+        return True
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='a{sa{sv}}', out_signature='', rel_path_keyword='rel_path')
+    def Connect(self, connection, rel_path):
+        self.__connect(connection, rel_path)
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='a{sa{sv}}a{sv}', out_signature='', rel_path_keyword='rel_path')
+    def ConnectInteractive(self, connection, details, rel_path):
+        self.__connect(connection, rel_path)
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='a{sa{sv}}', out_signature='s', rel_path_keyword='rel_path')
+    def NeedSecrets(self, settings, rel_path):
+        return ''
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='a{sa{sv}}', out_signature='', rel_path_keyword='rel_path')
+    def NewSecrets(self, connection, rel_path):
+        pass
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='', out_signature='', rel_path_keyword='rel_path')
+    def Disconnect(self, rel_path):
+        if self.connections.pop(rel_path, None) is None:
+            raise BadConnectionException('connection %s is not active' % (rel_path))
+        self.StateChanged(NM_VPN_SERVICE_STATE_STOPPING, rel_path=rel_path)
+        self.StateChanged(NM_VPN_SERVICE_STATE_STOPPED, rel_path=rel_path)
+        self.__schedule_quit()
+
+    @dbus.service.method(dbus_interface=IFACE_VPN_PLUGIN, in_signature='s', out_signature='', rel_path_keyword='rel_path')
+    def SetFailure(self, reason, rel_path):
+        if self.connections.pop(rel_path, None) is not None:
+            self.Failure(NM_VPN_PLUGIN_FAILURE_CONNECT_FAILED, rel_path=rel_path)
+            self.StateChanged(NM_VPN_SERVICE_STATE_STOPPED, rel_path=rel_path)
+            self.__schedule_quit()
+
+    @dbus.service.signal(IFACE_VPN_PLUGIN, signature='u', rel_path_keyword='rel_path')
+    def StateChanged(self, state, rel_path):
+        pass
+
+    @dbus.service.signal(IFACE_VPN_PLUGIN, signature='a{sv}', rel_path_keyword='rel_path')
+    def Config(self, config, rel_path):
+        pass
+
+    @dbus.service.signal(IFACE_VPN_PLUGIN, signature='a{sv}', rel_path_keyword='rel_path')
+    def Ip4Config(self, ip4config, rel_path):
+        pass
+
+    @dbus.service.signal(IFACE_VPN_PLUGIN, signature='u', rel_path_keyword='rel_path')
+    def Failure(self, reason, rel_path):
+        pass
+
+###################################################################
+def quit_cb(user_data):
+    mainloop.quit()
+    return False
+
+def main():
+    parser = argparse.ArgumentParser(description='Mock shared VPN plugin service')
+    parser.add_argument('--bus-name', default=DEFAULT_SERVICE,
+                        help='the D-Bus name to own (default: %(default)s)')
+    parser.add_argument('--session', action='store_true',
+                        help='use the session bus instead of the system bus')
+    parser.add_argument('--delta-interval', type=int, default=0,
+                        help='send a delta Ip4Config update every N seconds')
+    parser.add_argument('--idle-timeout', type=int, default=180,
+                        help='quit after N seconds without connections, 0 to never quit')
+    args = parser.parse_args()
+
+    dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+
+    bus = dbus.SessionBus() if args.session else dbus.SystemBus()
+    plugin = SharedVpnPlugin(bus, NM_VPN_DBUS_PLUGIN_PATH, args.idle_timeout)
+
+    if bus.request_name(args.bus_name, dbus.bus.NAME_FLAG_DO_NOT_QUEUE) != dbus.bus.REQUEST_NAME_REPLY_PRIMARY_OWNER:
+        print('cannot own bus name %s' % (args.bus_name), file=sys.stderr)
+        sys.exit(1)
+
+    if args.delta_interval > 0:
+        GLib.timeout_add_seconds(args.delta_interval, plugin.send_deltas)
+
+    try:
+        mainloop.run()
+    except Exception as e:
+        pass
+
+    sys.exit(0)
+
+if __name__ == '__main__':
+    main()